@@ -18,9 +18,9 @@ import 'dart:math';
 
 import 'package:flutter/foundation.dart';
 import 'package:flutter/material.dart';
-import 'dart:async';
 
 import 'package:flutter/services.dart';
+import 'package:sw_rend/pixel_format.dart';
 import 'package:sw_rend/software_texture.dart';
 
 void main() {
@@ -80,9 +80,11 @@ class _MyAppState extends State<MyApp> {
   }
 
   Future<void> tick() async {
-    num targetFps = 200;
-    Duration wait = Duration(microseconds: 1e6 ~/ targetFps);
-    DateTime pre = DateTime.now();
+    // Draw the next frame once the engine has taken this one, falling back to
+    // a timer in case the textures are scrolled out of view
+    Future<void> presented = texture2!.presentedFrames.first
+        .then<void>((_) {})
+        .timeout(const Duration(milliseconds: 100), onTimeout: () {});
     await noisy();
     DateTime now = DateTime.now();
     frames++;
@@ -93,8 +95,8 @@ class _MyAppState extends State<MyApp> {
       start = now;
     }
     last = now;
-    wait = wait - now.difference(pre);
-    Timer(wait, tick);
+    await presented;
+    tick();
   }
 
   Future<void> game() async {
@@ -134,19 +136,9 @@ class _MyAppState extends State<MyApp> {
 
   Future<void> noisy() async {
     await game();
-    Uint8List pixels = texture!.buffer;
-    await texture!.readPixels();
     Random r = Random();
-    for (int i = 0; i < width * height * 4; i += 4) {
-      int index = i ~/ 4;
-      int color = gol[index];
-      pixels[i] = color;
-      pixels[i + 1] = color;
-      pixels[i + 2] = color;
-      pixels[i + 3] = 255;
-    }
-    await texture!.draw();
-    pixels = texture2!.buffer;
+    await texture!.drawPixels(gol, format: PixelFormat.gray8);
+    Uint8List pixels = texture2!.buffer;
     for (int i = 0; i < width * height * 4; i += 4) {
       int x = (i ~/ 4) % width;
       pixels[i] = r.nextInt(256) ~/ (2 + r.nextInt(4));
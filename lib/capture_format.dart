@@ -0,0 +1,29 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// How recorded frames are stored
+///
+/// Recording is currently only supported on Linux.
+enum CaptureFormat {
+  /// The rects that changed in each frame, with timestamps. See
+  /// `src/sw_capture.h` for the layout.
+  raw,
+
+  /// Every frame in full as uncompressed YUV 4:2:0 video, which most video
+  /// tools can play or convert. Frames after the texture changes size are
+  /// left out.
+  y4m,
+}
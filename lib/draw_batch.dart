@@ -0,0 +1,68 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:typed_data';
+import 'dart:ui';
+
+import 'package:sw_rend/pixel_blend_mode.dart';
+import 'package:sw_rend/pixel_format.dart';
+import 'package:sw_rend/sw_rend.dart';
+
+/// Collects rects of pixels bound for any number of textures so they can be
+/// drawn with a single platform message
+///
+/// Every rect in a batch uses the same [format] and [blend] mode. Currently
+/// only supported on Linux.
+class DrawBatch {
+  static final SwRend _plugin = SwRend();
+  static const int _recordSize = 6;
+
+  final PixelFormat format;
+  final PixelBlendMode blend;
+  final List<int> _records = [];
+  final BytesBuilder _pixels = BytesBuilder(copy: false);
+
+  DrawBatch(
+      {this.format = PixelFormat.rgba8888, this.blend = PixelBlendMode.src});
+
+  /// Number of rects added so far
+  int get length => _records.length ~/ _recordSize;
+
+  /// Queue [pixels], the tightly packed rows of [area], to be drawn to
+  /// texture [textureId]
+  void add(int textureId, Rect area, Uint8List pixels) {
+    int w = area.width.toInt();
+    int h = area.height.toInt();
+    if (pixels.length < w * h * format.bytesPerPixel) {
+      throw ArgumentError.value(pixels, 'pixels', 'smaller than area');
+    }
+    _records.addAll([
+      textureId, area.left.toInt(), area.top.toInt(), w, h, _pixels.length
+    ]);
+    _pixels.add(pixels);
+  }
+
+  /// Draw every queued rect and empty the batch
+  ///
+  /// If [redraw] is [true] or unspecified, every texture that was drawn to is
+  /// refreshed once all the rects are in place.
+  Future<void> submit({bool redraw = true}) {
+    Int64List records = Int64List.fromList(_records);
+    _records.clear();
+    return _plugin.drawBatch(records, _pixels.takeBytes(),
+        format: format, blend: blend, invalidate: redraw);
+  }
+}
@@ -0,0 +1,40 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// How drawn pixels combine with the pixels already in a texture
+///
+/// Blending happens on the device, so overlays such as cursors or selection
+/// boxes need no read back. Each mode works on every channel independently.
+/// Modes other than [src] are currently only supported on Linux.
+enum PixelBlendMode {
+  /// Replace the texture's pixels
+  src,
+
+  /// Draw premultiplied pixels over the texture
+  srcOver,
+
+  /// Draw straight (non-premultiplied) pixels over the texture
+  srcOverStraight,
+
+  /// Add to the texture's pixels, saturating
+  add,
+
+  /// Multiply the texture's colors; alpha combines as in [screen]
+  multiply,
+
+  /// Invert, multiply and invert again, which always lightens
+  screen,
+}
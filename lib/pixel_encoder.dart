@@ -0,0 +1,98 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:typed_data';
+
+import 'package:sw_rend/pixel_encoding.dart';
+
+/// Encodes RGBA pixels for [PixelEncoding.rle] and [PixelEncoding.xorRle]
+/// draws
+///
+/// The data is a series of packets covering the pixels in order, each
+/// starting with an unsigned LEB128 header h for a count n = (h >> 1) + 1.
+/// If h is even, n literal pixels follow; if odd, one pixel follows that is
+/// repeated n times.
+class PixelEncoder {
+  /// Run-length encode [pixels]
+  static Uint8List encodeRle(Uint8List pixels) => _encode(_words(pixels));
+
+  /// Encode [current] as a change from [previous], which must be what the
+  /// drawn rect of the texture holds when the draw arrives
+  static Uint8List encodeXorRle(Uint8List previous, Uint8List current) {
+    Uint32List before = _words(previous);
+    Uint32List after = _words(current);
+    Uint32List delta = Uint32List(after.length);
+    for (int i = 0; i < after.length; i++) {
+      delta[i] = before[i] ^ after[i];
+    }
+    return _encode(delta);
+  }
+
+  /// [bytes] as whole pixels, viewed in place when they start on a 4-byte
+  /// boundary and copied otherwise, since views must be aligned
+  static Uint32List _words(Uint8List bytes) {
+    int count = bytes.length ~/ 4;
+    if (bytes.offsetInBytes % 4 == 0) {
+      return bytes.buffer.asUint32List(bytes.offsetInBytes, count);
+    }
+    return Uint8List.fromList(Uint8List.sublistView(bytes, 0, 4 * count))
+        .buffer
+        .asUint32List(0, count);
+  }
+
+  static Uint8List _encode(Uint32List pixels) {
+    int n = pixels.length;
+    // Every packet covers at least one pixel and costs at most one byte more
+    // than its pixels
+    Uint8List out = Uint8List(5 * n);
+    ByteData view = out.buffer.asByteData();
+    int pos = 0;
+
+    void header(int value) {
+      while (value >= 0x80) {
+        out[pos++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+      }
+      out[pos++] = value;
+    }
+
+    int i = 0;
+    while (i < n) {
+      int run = 1;
+      while (i + run < n && pixels[i + run] == pixels[i]) {
+        run++;
+      }
+      if (run >= 2) {
+        header(((run - 1) << 1) | 1);
+        view.setUint32(pos, pixels[i], Endian.host);
+        pos += 4;
+        i += run;
+        continue;
+      }
+      // Extend the literal up to the start of the next run
+      int end = i + 1;
+      while (end < n && !(end + 1 < n && pixels[end] == pixels[end + 1])) {
+        end++;
+      }
+      header((end - i - 1) << 1);
+      for (; i < end; i++) {
+        view.setUint32(pos, pixels[i], Endian.host);
+        pos += 4;
+      }
+    }
+    return Uint8List.sublistView(out, 0, pos);
+  }
+}
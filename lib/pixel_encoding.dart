@@ -0,0 +1,32 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// How the pixels of a draw are encoded
+///
+/// Encoded pixels are always RGBA and replace what is in the texture. Use
+/// [PixelEncoder] to produce them. Encodings other than [raw] are currently
+/// only supported on Linux.
+enum PixelEncoding {
+  /// Tightly packed pixels
+  raw,
+
+  /// Run-length encoded pixels, for flat areas
+  rle,
+
+  /// Run-length encoded XOR of each pixel with the one already in the
+  /// texture, so that only what changed costs anything to send
+  xorRle,
+}
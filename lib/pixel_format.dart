@@ -0,0 +1,44 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// Layouts that pixel data can be drawn from
+///
+/// Textures always hold RGBA pixels; other formats are converted on the
+/// device as they are drawn, which saves expanding them in Dart and sending
+/// the larger result over the platform channel. Formats other than [rgba8888]
+/// are currently only supported on Linux.
+enum PixelFormat {
+  /// 4 bytes per pixel: red, green, blue, alpha
+  rgba8888,
+
+  /// 4 bytes per pixel: blue, green, red, alpha
+  bgra8888,
+
+  /// 3 bytes per pixel: red, green, blue; drawn opaque
+  rgb888,
+
+  /// 2 bytes per pixel, little-endian, with 5 bits of red in the high bits,
+  /// then 6 of green and 5 of blue; drawn opaque
+  rgb565,
+
+  /// 1 byte per pixel of luminance; drawn opaque
+  gray8,
+}
+
+extension PixelFormatSize on PixelFormat {
+  /// Number of bytes each pixel takes up in this format
+  int get bytesPerPixel => const [4, 4, 3, 2, 1][index];
+}
@@ -0,0 +1,28 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// A frame of a texture that the engine has taken to display
+class PresentedFrame {
+  final int textureId;
+
+  /// How many frames the engine has taken from the texture, this one included
+  final int frame;
+
+  /// When the engine took the frame, on the device's monotonic clock
+  final Duration timestamp;
+
+  const PresentedFrame(this.textureId, this.frame, this.timestamp);
+}
@@ -0,0 +1,79 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:typed_data';
+import 'dart:ui';
+
+/// A list of drawing commands that the device rasterizes straight into a
+/// texture, so only the commands cross the platform channel
+///
+/// Coordinates are in texture pixels and are clipped to the texture. Colors
+/// are drawn as-is, without blending. Currently only supported on Linux.
+class RasterCommands {
+  static const int _clear = 0;
+  static const int _fillRect = 1;
+  static const int _hspan = 2;
+  static const int _vspan = 3;
+  static const int _line = 4;
+  static const int _strokeRect = 5;
+  static const int _fillCircle = 6;
+
+  final List<int> _words = [];
+
+  bool get isEmpty => _words.isEmpty;
+
+  /// Converts a [Color] to the RGBA word the device expects, which puts red in
+  /// the low byte so that it lands first in memory
+  static int _rgba(Color color) =>
+      (color.alpha << 24 | color.blue << 16 | color.green << 8 | color.red)
+          .toSigned(32);
+
+  /// Fill the whole texture with [color]
+  void clear(Color color) => _words.addAll([_clear, _rgba(color)]);
+
+  void fillRect(Rect rect, Color color) => _words.addAll([
+        _fillRect, rect.left.toInt(), rect.top.toInt(),
+        rect.width.toInt(), rect.height.toInt(), _rgba(color)
+      ]);
+
+  /// Draw a horizontal run of [length] pixels starting at ([x], [y])
+  void hspan(int x, int y, int length, Color color) =>
+      _words.addAll([_hspan, x, y, length, _rgba(color)]);
+
+  /// Draw a vertical run of [length] pixels starting at ([x], [y])
+  void vspan(int x, int y, int length, Color color) =>
+      _words.addAll([_vspan, x, y, length, _rgba(color)]);
+
+  /// Draw a one pixel wide line, including both endpoints
+  void line(Offset from, Offset to, Color color) => _words.addAll([
+        _line, from.dx.toInt(), from.dy.toInt(),
+        to.dx.toInt(), to.dy.toInt(), _rgba(color)
+      ]);
+
+  /// Draw a one pixel wide outline just inside [rect]
+  void strokeRect(Rect rect, Color color) => _words.addAll([
+        _strokeRect, rect.left.toInt(), rect.top.toInt(),
+        rect.width.toInt(), rect.height.toInt(), _rgba(color)
+      ]);
+
+  void fillCircle(Offset center, int radius, Color color) => _words.addAll(
+      [_fillCircle, center.dx.toInt(), center.dy.toInt(), radius, _rgba(color)]);
+
+  void reset() => _words.clear();
+
+  /// The encoded command list
+  Int32List build() => Int32List.fromList(_words);
+}
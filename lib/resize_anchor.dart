@@ -0,0 +1,27 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// Where a texture's existing content ends up when it is resized
+enum ResizeAnchor {
+  /// Keep the top-left corner in place
+  topLeft,
+
+  /// Keep the content centered, cropping or padding evenly on each side
+  center,
+
+  /// Drop the content
+  clear,
+}
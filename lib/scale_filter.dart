@@ -0,0 +1,26 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+/// How a scaled blit samples its source
+///
+/// Scaled blits are currently only supported on Linux.
+enum ScaleFilter {
+  /// Take the nearest source pixel, keeping hard pixel edges
+  nearest,
+
+  /// Interpolate between the four nearest source pixels
+  bilinear,
+}
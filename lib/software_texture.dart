@@ -14,32 +14,106 @@ See the License for the specific language governing permissions and
 limitations under the License.
  */
 
+import 'dart:ffi' show Pointer, Uint8;
 import 'dart:math';
 import 'dart:typed_data';
 import 'dart:ui';
 
+import 'package:sw_rend/capture_format.dart';
+import 'package:sw_rend/pixel_blend_mode.dart';
+import 'package:sw_rend/pixel_encoding.dart';
+import 'package:sw_rend/pixel_format.dart';
+import 'package:sw_rend/presented_frame.dart';
+import 'package:sw_rend/raster_commands.dart';
+import 'package:sw_rend/resize_anchor.dart';
+import 'package:sw_rend/scale_filter.dart';
 import 'package:sw_rend/sw_rend.dart';
+import 'package:sw_rend/sw_rend_ffi.dart';
 
 /// Represents a texture on the host device whose pixels can be
 /// directly manipulated
 class SoftwareTexture {
   static final SwRend _plugin = SwRend();
+  static final SwRendFfi? _ffi = SwRendFfi.instance;
   static const int bytesPerPixel = 4;
 
   late final int textureId;
-  late final int width, height;
-  late final Uint8List buffer;
+  int width, height;
+  late Uint8List buffer;
+
+  /// Whether the texture presents each redraw as a complete frame
+  final bool tearFree;
+
+  /// Whether [buffer] is a view onto the device texture's own pixel memory
+  final bool sharedMemory;
 
   /// [size] holds the width and height in pixels of this texture
-  SoftwareTexture(Size size)
+  ///
+  /// If [tearFree] is [true], the device keeps a separate copy of each
+  /// redrawn frame for the engine to display, so drawing the next frame can
+  /// never show up half-finished. Only frames that are redrawn are shown, and
+  /// if several are redrawn between two engine frames only the latest is.
+  /// Currently only honored on Linux.
+  ///
+  /// If [sharedMemory] is [true], [buffer] is not allocated until
+  /// [generateTexture] completes, and then views the pixel memory of the
+  /// device texture directly, so [draw] only has to tell the device which
+  /// region changed instead of copying it. [buffer] must not be used after
+  /// [dispose]. Currently only supported on Linux.
+  SoftwareTexture(Size size, {this.tearFree = false, this.sharedMemory = false})
       : width = size.width.toInt(),
         height = size.height.toInt() {
-    buffer = Uint8List(width * height * bytesPerPixel);
+    if (!sharedMemory) {
+      buffer = Uint8List(width * height * bytesPerPixel);
+    }
   }
 
   /// Instantiates the actual texture on the device and stores its texture ID
   Future<void> generateTexture() async {
-    textureId = (await _plugin.init(width, height))!;
+    textureId = (await _plugin.init(width, height, tearFree: tearFree))!;
+    if (sharedMemory) {
+      int address = (await _plugin.getBufferAddress(textureId))!;
+      buffer = Pointer<Uint8>.fromAddress(address)
+          .asTypedList(width * height * bytesPerPixel);
+    }
+  }
+
+  /// Change the size of this texture in place, keeping [textureId]
+  ///
+  /// The existing content of both [buffer] and the device texture is laid
+  /// out according to [anchor], and any new area is cleared. [buffer] is
+  /// replaced, so references to the old one must not be used afterwards; for
+  /// [sharedMemory] textures it then views the device's new pixel memory.
+  /// If [redraw] is [true] or unspecified, the texture is redrawn at its new
+  /// size.
+  Future<void> resize(Size size,
+      {ResizeAnchor anchor = ResizeAnchor.topLeft, bool redraw = true}) async {
+    int newWidth = size.width.toInt();
+    int newHeight = size.height.toInt();
+    await _plugin.resize(textureId, newWidth, newHeight, anchor: anchor);
+    if (sharedMemory) {
+      int address = (await _plugin.getBufferAddress(textureId))!;
+      buffer = Pointer<Uint8>.fromAddress(address)
+          .asTypedList(newWidth * newHeight * bytesPerPixel);
+    } else {
+      Uint8List resized = Uint8List(newWidth * newHeight * bytesPerPixel);
+      if (anchor != ResizeAnchor.clear) {
+        int dx = anchor == ResizeAnchor.center ? (newWidth - width) ~/ 2 : 0;
+        int dy = anchor == ResizeAnchor.center ? (newHeight - height) ~/ 2 : 0;
+        int x0 = max(dx, 0), x1 = min(dx + width, newWidth);
+        for (int y = max(dy, 0); y < min(dy + height, newHeight) && x0 < x1; y++) {
+          int src = bytesPerPixel * ((y - dy) * width + x0 - dx);
+          resized.setRange(bytesPerPixel * (y * newWidth + x0),
+              bytesPerPixel * (y * newWidth + x1), buffer, src);
+        }
+      }
+      buffer = resized;
+    }
+    width = newWidth;
+    height = newHeight;
+    if (redraw) {
+      await this.redraw();
+    }
   }
 
   /// Push a region of the [buffer] to the underlying texture and optionally
@@ -49,12 +123,52 @@ class SoftwareTexture {
   /// from [buffer] to the texture data, otherwise, the entire [buffer] is used.
   /// If [redraw] is [true] or unspecified, the texture will be refreshed with
   /// its new contents.
+  ///
+  /// For [sharedMemory] textures the pixels are already in place, so where
+  /// [SwRendFfi] is available the redraw happens synchronously before this
+  /// returns.
   Future<dynamic> draw({Rect? area, bool redraw = true}) async {
     int x = area?.left.toInt() ?? 0;
     int y = area?.top.toInt() ?? 0;
     int w = area?.width.toInt() ?? width;
     int h = area?.height.toInt() ?? height;
-    Future<void> draw = _plugin.draw(textureId, x, y, w, h, buffer);
+    if (sharedMemory && _ffi != null) {
+      _ffi!.damageRect(textureId, x, y, w, h);
+      if (redraw) {
+        _ffi!.markFrameAvailable(textureId);
+      }
+      return;
+    }
+    Future<void> draw =
+        _plugin.draw(textureId, x, y, w, h, sharedMemory ? null : buffer);
+    if (redraw) {
+      Future<void> invalidate = _plugin.invalidate(textureId);
+      return Future.wait([draw, invalidate]);
+    }
+    return draw;
+  }
+
+  /// Draw [pixels] of the given [format] straight to the underlying texture,
+  /// bypassing [buffer], and optionally redraw it
+  ///
+  /// [pixels] holds the tightly packed rows of [area], or of the entire
+  /// texture if [area] is not specified. The pixels are converted to RGBA and
+  /// combined with the texture according to [blend] on the device, and
+  /// [buffer] is left as it was. Unless [encoding] is [PixelEncoding.raw],
+  /// [pixels] holds RGBA pixels encoded with [PixelEncoder] instead.
+  Future<dynamic> drawPixels(Uint8List pixels,
+      {Rect? area,
+      PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw,
+      bool redraw = true}) async {
+    int x = area?.left.toInt() ?? 0;
+    int y = area?.top.toInt() ?? 0;
+    int w = area?.width.toInt() ?? width;
+    int h = area?.height.toInt() ?? height;
+    Future<void> draw =
+        _plugin.draw(textureId, x, y, w, h, pixels,
+            format: format, blend: blend, encoding: encoding);
     if (redraw) {
       Future<void> invalidate = _plugin.invalidate(textureId);
       return Future.wait([draw, invalidate]);
@@ -62,14 +176,165 @@ class SoftwareTexture {
     return draw;
   }
 
-  /// Retrieves the actual pixel data in the texture and stores in [buffer]
-  Future<void> readPixels() async {
-    Uint8List? currentPixels = await _plugin.getPixels(textureId);
-    buffer.setAll(0, currentPixels!);
+  /// Rasterize [commands] straight into the underlying texture, bypassing
+  /// [buffer], and optionally redraw it
+  Future<void> raster(RasterCommands commands, {bool redraw = true}) =>
+      _plugin.raster(textureId, commands.build(), invalidate: redraw);
+
+  /// Draw sprite [sprite], added with [SwRend.addSprite], with its top-left
+  /// corner at [position], and optionally redraw the texture. Only the ID
+  /// crosses the platform channel. Returns false if the sprite was evicted
+  /// from the cache and must be added again. Currently only supported on
+  /// Linux.
+  Future<bool> blitSprite(int sprite, Offset position,
+      {int alpha = 255,
+      PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool redraw = true}) async =>
+      await _plugin.blitSprite(textureId, sprite, position.dx.toInt(),
+          position.dy.toInt(),
+          alpha: alpha, blend: blend, invalidate: redraw) ??
+      false;
+
+  /// Bind a [columns] by [rows] tilemap to this texture and draw it,
+  /// bypassing [buffer], see [SwRend.setTilemap]. Tiles of [tileSize] are
+  /// cut from [tileset], tightly packed RGBA rows of an atlas of
+  /// [tilesetSize]. Returns the number of tiles in the atlas. Currently only
+  /// supported on Linux.
+  Future<int?> setTilemap(Uint8List tileset, Size tilesetSize, Size tileSize,
+          int columns, int rows,
+          {Int32List? tiles, Offset scroll = Offset.zero, bool redraw = true}) =>
+      _plugin.setTilemap(textureId, tileset, tilesetSize.width.toInt(),
+          tilesetSize.height.toInt(), tileSize.width.toInt(),
+          tileSize.height.toInt(), columns, rows,
+          tiles: tiles,
+          x: scroll.dx.toInt(),
+          y: scroll.dy.toInt(),
+          invalidate: redraw);
+
+  /// Set the [cells] of the tilemap to [tiles], row by row, redrawing only
+  /// the cells that changed
+  Future<void> setTiles(Rect cells, Int32List tiles, {bool redraw = true}) =>
+      _plugin.setTiles(textureId, cells.left.toInt(), cells.top.toInt(),
+          cells.width.toInt(), cells.height.toInt(), tiles,
+          invalidate: redraw);
+
+  /// Show the tilemap from [scroll] in map pixels, drawing only what
+  /// scrolls into view
+  Future<void> scrollTilemap(Offset scroll, {bool redraw = true}) =>
+      _plugin.scrollTilemap(textureId, scroll.dx.toInt(), scroll.dy.toInt(),
+          invalidate: redraw);
+
+  /// Unbind the tilemap, leaving the texture as it is
+  Future<void> removeTilemap() => _plugin.removeTilemap(textureId);
+
+  /// Scale [pixels], tightly packed RGBA rows of an image of [size], onto
+  /// [area] of the texture, all of it by default, bypassing [buffer], and
+  /// optionally redraw it
+  ///
+  /// Only the small image crosses the platform channel; the scaled output is
+  /// produced natively.
+  Future<void> blitPixels(Uint8List pixels, Size size,
+          {Rect? area,
+          ScaleFilter filter = ScaleFilter.nearest,
+          bool redraw = true}) =>
+      _plugin.blit(textureId, area?.left.toInt() ?? 0, area?.top.toInt() ?? 0,
+          area?.width.toInt() ?? width, area?.height.toInt() ?? height,
+          pixels: pixels,
+          srcW: size.width.toInt(),
+          srcH: size.height.toInt(),
+          filter: filter,
+          invalidate: redraw);
+
+  /// Scale [from] of [source], all of it by default, onto [area] of this
+  /// texture, all of it by default, bypassing [buffer], and optionally redraw
+  /// it
+  Future<void> blitFrom(SoftwareTexture source,
+          {Rect? from,
+          Rect? area,
+          ScaleFilter filter = ScaleFilter.nearest,
+          bool redraw = true}) =>
+      _plugin.blit(textureId, area?.left.toInt() ?? 0, area?.top.toInt() ?? 0,
+          area?.width.toInt() ?? width, area?.height.toInt() ?? height,
+          source: source.textureId,
+          srcX: from?.left.toInt() ?? 0,
+          srcY: from?.top.toInt() ?? 0,
+          srcW: from?.width.toInt() ?? source.width,
+          srcH: from?.height.toInt() ?? source.height,
+          filter: filter,
+          invalidate: redraw);
+
+  /// Retrieves the actual pixel data in the texture, or just in [area], and
+  /// stores it in [buffer]
+  ///
+  /// [sharedMemory] textures already view the texture's pixels, so there is
+  /// nothing to read.
+  Future<void> readPixels({Rect? area}) async {
+    if (sharedMemory) {
+      return;
+    }
+    if (area == null) {
+      Uint8List? currentPixels = await _plugin.getPixels(textureId);
+      buffer.setAll(0, currentPixels!);
+      return;
+    }
+    int x = area.left.toInt();
+    int y = area.top.toInt();
+    int w = area.width.toInt();
+    int h = area.height.toInt();
+    Uint8List? currentPixels =
+        await _plugin.getPixels(textureId, x: x, y: y, w: w, h: h);
+    for (int dy = 0; dy < h; dy++) {
+      buffer.setRange(4 * ((y + dy) * width + x), 4 * ((y + dy) * width + x + w),
+          currentPixels!, 4 * dy * w);
+    }
+  }
+
+  /// Copies the pixels in [area] of the texture, or all of them, to the
+  /// native memory at [pixels] as tightly packed RGBA rows, without going
+  /// through [buffer] or a message copy
+  Future<void> readPixelsTo(Pointer<Uint8> pixels, {Rect? area}) async {
+    int x = area?.left.toInt() ?? 0;
+    int y = area?.top.toInt() ?? 0;
+    int w = area?.width.toInt() ?? width;
+    int h = area?.height.toInt() ?? height;
+    if (_ffi != null && _ffi!.readRect(textureId, pixels, x, y, w, h)) {
+      return;
+    }
+    await _plugin.getPixels(textureId,
+        x: x, y: y, w: w, h: h, address: pixels.address);
   }
 
   /// Redraws the texture
-  Future<void> redraw() async => _plugin.invalidate(textureId);
+  Future<void> redraw() async {
+    if (sharedMemory && _ffi != null) {
+      _ffi!.markFrameAvailable(textureId);
+      return;
+    }
+    return _plugin.invalidate(textureId);
+  }
+
+  /// Performance counters of this texture, see [SwRend.getStats].
+  /// Currently only supported on Linux.
+  Future<Map<String, dynamic>?> getStats({bool reset = false}) =>
+      _plugin.getStats(texId: textureId, reset: reset);
+
+  /// Write every frame presented from now on to a capture file at [path],
+  /// see [SwRend.startRecording]. Currently only supported on Linux.
+  Future<void> startRecording(String path,
+          {CaptureFormat format = CaptureFormat.raw, int fps = 60}) =>
+      _plugin.startRecording(textureId, path, format: format, fps: fps);
+
+  /// Stop recording once the frames captured so far are written
+  Future<Map<String, dynamic>?> stopRecording() =>
+      _plugin.stopRecording(textureId);
+
+  /// Frames of this texture taken by the engine to display
+  ///
+  /// Redraws requested before the engine takes the previous frame are folded
+  /// into it, so drawing once per event paces rendering to the display.
+  /// Currently only supported on Linux.
+  Stream<PresentedFrame> get presentedFrames =>
+      _plugin.presentedFrames.where((frame) => frame.textureId == textureId);
 
   /// Dispose of the underlying resources of this texture
   Future<void> dispose() async => _plugin.dispose(textureId);
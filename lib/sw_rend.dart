@@ -16,17 +16,63 @@ limitations under the License.
 
 import 'dart:typed_data';
 
+import 'capture_format.dart';
+import 'pixel_blend_mode.dart';
+import 'pixel_encoding.dart';
+import 'pixel_format.dart';
+import 'presented_frame.dart';
+import 'resize_anchor.dart';
+import 'scale_filter.dart';
 import 'sw_rend_platform_interface.dart';
 
 class SwRend {
-  Future<int?> init(int w, int h) {
-    return SwRendPlatform.instance.init(w, h);
+  Future<int?> init(int w, int h, {bool tearFree = false}) {
+    return SwRendPlatform.instance.init(w, h, tearFree: tearFree);
   }
-  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List pixels) async {
-    return SwRendPlatform.instance.draw(texId, x, y, w, h, pixels);
+  Future<void> resize(int texId, int w, int h,
+      {ResizeAnchor anchor = ResizeAnchor.topLeft}) {
+    return SwRendPlatform.instance.resize(texId, w, h, anchor: anchor);
   }
-  Future<Uint8List?> getPixels(int texId) {
-    return SwRendPlatform.instance.getPixels(texId);
+  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List? pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw}) async {
+    return SwRendPlatform.instance.draw(texId, x, y, w, h, pixels,
+        format: format, blend: blend, encoding: encoding);
+  }
+  Future<void> drawBatch(Int64List records, Uint8List pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      bool invalidate = false}) {
+    return SwRendPlatform.instance.drawBatch(records, pixels,
+        format: format, blend: blend, invalidate: invalidate);
+  }
+  Future<void> raster(int texId, Int32List commands, {bool invalidate = false}) {
+    return SwRendPlatform.instance.raster(texId, commands, invalidate: invalidate);
+  }
+  Future<void> blit(int texId, int x, int y, int w, int h,
+      {Uint8List? pixels,
+      int? source,
+      int srcX = 0,
+      int srcY = 0,
+      int? srcW,
+      int? srcH,
+      ScaleFilter filter = ScaleFilter.nearest,
+      bool invalidate = false}) {
+    return SwRendPlatform.instance.blit(texId, x, y, w, h,
+        pixels: pixels,
+        source: source,
+        srcX: srcX,
+        srcY: srcY,
+        srcW: srcW,
+        srcH: srcH,
+        filter: filter,
+        invalidate: invalidate);
+  }
+  Future<Uint8List?> getPixels(int texId,
+      {int? x, int? y, int? w, int? h, int? address}) {
+    return SwRendPlatform.instance
+        .getPixels(texId, x: x, y: y, w: w, h: h, address: address);
   }
   Future<void> invalidate(int texId) {
     return SwRendPlatform.instance.invalidate(texId);
@@ -34,9 +80,84 @@ class SwRend {
   Future<Int32List?> getSize(int texId) {
     return SwRendPlatform.instance.getSize(texId);
   }
+  Future<int?> getBufferAddress(int texId) {
+    return SwRendPlatform.instance.getBufferAddress(texId);
+  }
+  Future<Map<String, dynamic>?> getDamage(int texId) {
+    return SwRendPlatform.instance.getDamage(texId);
+  }
   Future<Int64List?> listTextures() {
     return SwRendPlatform.instance.listTextures();
   }
+  Future<Map<String, dynamic>?> configure(
+      {int? workers,
+      int? threshold,
+      bool? renderThread,
+      bool? tracing,
+      String? commandLog,
+      int? spriteCacheBytes}) {
+    return SwRendPlatform.instance.configure(
+        workers: workers, threshold: threshold, renderThread: renderThread, tracing: tracing,
+        commandLog: commandLog, spriteCacheBytes: spriteCacheBytes);
+  }
+  Future<Map<String, dynamic>?> getPoolStats() {
+    return SwRendPlatform.instance.getPoolStats();
+  }
+  Future<String?> dumpTrace({bool clear = true}) {
+    return SwRendPlatform.instance.dumpTrace(clear: clear);
+  }
+  Future<Map<String, dynamic>?> getStats({int? texId, bool reset = false}) {
+    return SwRendPlatform.instance.getStats(texId: texId, reset: reset);
+  }
+  Future<void> startRecording(int texId, String path,
+      {CaptureFormat format = CaptureFormat.raw, int fps = 60}) {
+    return SwRendPlatform.instance.startRecording(texId, path, format: format, fps: fps);
+  }
+  Future<Map<String, dynamic>?> stopRecording(int texId) {
+    return SwRendPlatform.instance.stopRecording(texId);
+  }
+  Future<int?> addSprite(Uint8List pixels, int w, int h) {
+    return SwRendPlatform.instance.addSprite(pixels, w, h);
+  }
+  Future<bool?> removeSprite(int sprite) {
+    return SwRendPlatform.instance.removeSprite(sprite);
+  }
+  Future<bool?> blitSprite(int texId, int sprite, int x, int y,
+      {int alpha = 255,
+      PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) {
+    return SwRendPlatform.instance.blitSprite(texId, sprite, x, y,
+        alpha: alpha, blend: blend, invalidate: invalidate);
+  }
+  Future<Int64List?> blitSprites(int texId, Int64List records,
+      {PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) {
+    return SwRendPlatform.instance.blitSprites(texId, records,
+        blend: blend, invalidate: invalidate);
+  }
+  Future<Map<String, dynamic>?> getSpriteStats() {
+    return SwRendPlatform.instance.getSpriteStats();
+  }
+  Future<int?> setTilemap(int texId, Uint8List tileset, int tilesetW, int tilesetH,
+      int tileW, int tileH, int columns, int rows,
+      {Int32List? tiles, int x = 0, int y = 0, bool invalidate = false}) {
+    return SwRendPlatform.instance.setTilemap(
+        texId, tileset, tilesetW, tilesetH, tileW, tileH, columns, rows,
+        tiles: tiles, x: x, y: y, invalidate: invalidate);
+  }
+  Future<void> removeTilemap(int texId) {
+    return SwRendPlatform.instance.removeTilemap(texId);
+  }
+  Future<void> setTiles(int texId, int column, int row, int w, int h, Int32List tiles,
+      {bool invalidate = false}) {
+    return SwRendPlatform.instance.setTiles(texId, column, row, w, h, tiles, invalidate: invalidate);
+  }
+  Future<void> scrollTilemap(int texId, int x, int y, {bool invalidate = false}) {
+    return SwRendPlatform.instance.scrollTilemap(texId, x, y, invalidate: invalidate);
+  }
+  Stream<PresentedFrame> get presentedFrames {
+    return SwRendPlatform.instance.presentedFrames;
+  }
   Future<void> dispose(int texId) {
     return SwRendPlatform.instance.dispose(texId);
   }
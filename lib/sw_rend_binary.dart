@@ -0,0 +1,126 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+import 'pixel_blend_mode.dart';
+import 'pixel_encoding.dart';
+import 'pixel_format.dart';
+
+/// Thrown when the device rejects a binary command
+class SwRendBinaryException implements Exception {
+  /// Status byte sent back by the device
+  final int status;
+
+  const SwRendBinaryException(this.status);
+
+  @override
+  String toString() => 'SwRendBinaryException: status $status';
+}
+
+/// Sends the hot texture commands over a [BasicMessageChannel] with a fixed
+/// binary layout instead of a [MethodChannel] map of named arguments
+///
+/// Each message is a 32 byte little-endian header followed by an optional
+/// payload; see `linux/include/sw_rend/sw_binary_channel.h` for the layout.
+/// The device decodes it without any per-argument lookups, which matters for
+/// small, frequent updates. Currently only supported on Linux.
+class SwRendBinary {
+  static const int headerSize = 32;
+  static const int _opDraw = 1;
+  static const int _opInvalidate = 2;
+  static const int _opRead = 3;
+  static const int _flagInvalidate = 1;
+
+  static const BasicMessageChannel<ByteData> channel =
+      BasicMessageChannel<ByteData>('com.funguscow/sw_rend/binary', BinaryCodec());
+
+  static ByteData _header(Uint8List message, int opcode, int texId,
+      {int format = 0,
+      int flags = 0,
+      int blend = 0,
+      int encoding = 0,
+      int x = 0,
+      int y = 0,
+      int w = 0,
+      int h = 0}) {
+    ByteData header = ByteData.sublistView(message, 0, headerSize);
+    header.setUint8(0, opcode);
+    header.setUint8(1, format);
+    header.setUint16(2, flags, Endian.little);
+    header.setUint8(4, blend);
+    header.setUint8(5, encoding);
+    header.setInt64(8, texId, Endian.little);
+    header.setInt32(16, x, Endian.little);
+    header.setInt32(20, y, Endian.little);
+    header.setInt32(24, w, Endian.little);
+    header.setInt32(28, h, Endian.little);
+    return header;
+  }
+
+  static Future<ByteData> _send(Uint8List message) async {
+    ByteData? reply = await channel.send(ByteData.sublistView(message));
+    if (reply == null || reply.lengthInBytes == 0) {
+      throw const SwRendBinaryException(-1);
+    }
+    int status = reply.getUint8(0);
+    if (status != 0) {
+      throw SwRendBinaryException(status);
+    }
+    return reply;
+  }
+
+  /// Draw [pixels], the tightly packed rows of a [w] by [h] rect, to ([x], [y])
+  /// in texture [texId], and redraw the texture if [invalidate] is [true]
+  ///
+  /// Unless [encoding] is [PixelEncoding.raw], [pixels] holds the whole
+  /// encoded rect instead.
+  static Future<void> draw(int texId, int x, int y, int w, int h, Uint8List pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw,
+      bool invalidate = false}) async {
+    int length = encoding == PixelEncoding.raw
+        ? w * h * format.bytesPerPixel
+        : pixels.length;
+    Uint8List message = Uint8List(headerSize + length);
+    _header(message, _opDraw, texId,
+        format: format.index,
+        blend: blend.index,
+        encoding: encoding.index,
+        flags: invalidate ? _flagInvalidate : 0,
+        x: x, y: y, w: w, h: h);
+    message.setRange(headerSize, headerSize + length, pixels);
+    await _send(message);
+  }
+
+  /// Redraw texture [texId]
+  static Future<void> invalidate(int texId) async {
+    await _send(_header(Uint8List(headerSize), _opInvalidate, texId)
+        .buffer.asUint8List());
+  }
+
+  /// Read the RGBA pixels of a [w] by [h] rect at ([x], [y]) in texture
+  /// [texId], or of the whole texture if [w] or [h] is 0
+  static Future<Uint8List> read(int texId,
+      {int x = 0, int y = 0, int w = 0, int h = 0}) async {
+    ByteData reply = await _send(_header(Uint8List(headerSize), _opRead, texId,
+        x: x, y: y, w: w, h: h).buffer.asUint8List());
+    return reply.buffer.asUint8List(reply.offsetInBytes + 1, reply.lengthInBytes - 1);
+  }
+}
@@ -0,0 +1,110 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:ffi';
+import 'dart:io';
+
+import 'package:ffi/ffi.dart';
+
+typedef _DrawRectNative = Int32 Function(
+    Int64 texId, Pointer<Uint8> pixels, Int64 x, Int64 y, Int64 w, Int64 h);
+typedef _DrawRect = int Function(
+    int texId, Pointer<Uint8> pixels, int x, int y, int w, int h);
+typedef _DamageRectNative = Int32 Function(
+    Int64 texId, Int64 x, Int64 y, Int64 w, Int64 h);
+typedef _DamageRect = int Function(int texId, int x, int y, int w, int h);
+typedef _MarkFrameAvailableNative = Int32 Function(Int64 texId);
+typedef _MarkFrameAvailable = int Function(int texId);
+typedef _ReadRectNative = Int32 Function(
+    Int64 texId, Pointer<Uint8> pixels, Int64 x, Int64 y, Int64 w, Int64 h);
+typedef _ReadRect = int Function(
+    int texId, Pointer<Uint8> pixels, int x, int y, int w, int h);
+typedef _GetSizeNative = Int32 Function(
+    Int64 texId, Pointer<Int32> w, Pointer<Int32> h);
+typedef _GetSize = int Function(int texId, Pointer<Int32> w, Pointer<Int32> h);
+
+/// Synchronous bindings to the native plugin library
+///
+/// These calls run on the calling isolate's thread and skip the platform
+/// channel entirely, so they finish before returning instead of completing a
+/// [Future] frames later. They are only available where the plugin exports
+/// them, currently Linux; elsewhere [instance] is null.
+class SwRendFfi {
+  static final SwRendFfi? instance = _load();
+
+  final _DrawRect _drawRect;
+  final _DamageRect _damageRect;
+  final _MarkFrameAvailable _markFrameAvailable;
+  final _ReadRect _readRect;
+  final _GetSize _getSize;
+
+  SwRendFfi._(DynamicLibrary lib)
+      : _drawRect = lib.lookupFunction<_DrawRectNative, _DrawRect>(
+            'sw_rend_draw_rect'),
+        _damageRect = lib.lookupFunction<_DamageRectNative, _DamageRect>(
+            'sw_rend_damage_rect'),
+        _markFrameAvailable = lib
+            .lookupFunction<_MarkFrameAvailableNative, _MarkFrameAvailable>(
+                'sw_rend_mark_frame_available'),
+        _readRect =
+            lib.lookupFunction<_ReadRectNative, _ReadRect>('sw_rend_read_rect'),
+        _getSize =
+            lib.lookupFunction<_GetSizeNative, _GetSize>('sw_rend_get_size');
+
+  static SwRendFfi? _load() {
+    if (!Platform.isLinux) {
+      return null;
+    }
+    try {
+      return SwRendFfi._(DynamicLibrary.open('libsw_rend_plugin.so'));
+    } on ArgumentError {
+      return null;
+    }
+  }
+
+  /// Copy a [w] by [h] RGBA rect of native memory at [pixels] to ([x], [y])
+  /// in texture [texId]. Returns [false] if the texture does not exist.
+  bool drawRect(int texId, Pointer<Uint8> pixels, int x, int y, int w, int h) =>
+      _drawRect(texId, pixels, x, y, w, h) != 0;
+
+  /// Record that a rect of texture [texId] was written through its shared
+  /// buffer. Returns [false] if the texture does not exist.
+  bool damageRect(int texId, int x, int y, int w, int h) =>
+      _damageRect(texId, x, y, w, h) != 0;
+
+  /// Redraw texture [texId]. Returns [false] if the texture does not exist.
+  bool markFrameAvailable(int texId) => _markFrameAvailable(texId) != 0;
+
+  /// Copy the [w] by [h] RGBA rect at ([x], [y]) in texture [texId] to
+  /// native memory at [pixels] as tightly packed rows. Returns [false] if the
+  /// texture does not exist or the rect does not lie within it.
+  bool readRect(int texId, Pointer<Uint8> pixels, int x, int y, int w, int h) =>
+      _readRect(texId, pixels, x, y, w, h) > 0;
+
+  /// Returns the width and height of texture [texId], or null if it does not
+  /// exist
+  List<int>? getSize(int texId) {
+    final Pointer<Int32> size = calloc<Int32>(2);
+    try {
+      if (_getSize(texId, size, size.elementAt(1)) == 0) {
+        return null;
+      }
+      return [size[0], size[1]];
+    } finally {
+      calloc.free(size);
+    }
+  }
+}
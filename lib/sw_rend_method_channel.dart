@@ -17,6 +17,13 @@ limitations under the License.
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
+import 'capture_format.dart';
+import 'pixel_blend_mode.dart';
+import 'pixel_encoding.dart';
+import 'pixel_format.dart';
+import 'presented_frame.dart';
+import 'resize_anchor.dart';
+import 'scale_filter.dart';
 import 'sw_rend_platform_interface.dart';
 
 /// An implementation of [SwRendPlatform] that uses method channels.
@@ -25,22 +32,102 @@ class MethodChannelTestNative extends SwRendPlatform {
   @visibleForTesting
   final methodChannel = const MethodChannel('com.funguscow/sw_rend');
 
+  /// The event channel reporting frames taken by the engine.
+  @visibleForTesting
+  final frameChannel = const EventChannel('com.funguscow/sw_rend/frames');
+
+  late final Stream<PresentedFrame> _presentedFrames = frameChannel
+      .receiveBroadcastStream()
+      .map((event) => PresentedFrame(
+          event[0] as int, event[1] as int, Duration(microseconds: event[2] as int)));
+
 
   @override
-  Future<int?> init(int w, int h) async {
-    return await methodChannel.invokeMethod<int>('init', <String, int>{'width': w, 'height': h});
+  Future<int?> init(int w, int h, {bool tearFree = false}) async {
+    return await methodChannel.invokeMethod<int>('init', <String, dynamic>{
+      'width': w, 'height': h, 'tear_free': tearFree
+    });
   }
 
   @override
-  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List pixels) async {
+  Future<void> resize(int texId, int w, int h,
+      {ResizeAnchor anchor = ResizeAnchor.topLeft}) async {
+    return await methodChannel.invokeMethod<void>('resize', <String, dynamic>{
+      'texture': texId, 'width': w, 'height': h,
+      if (anchor != ResizeAnchor.topLeft) 'anchor': anchor.index
+    });
+  }
+
+  @override
+  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List? pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw}) async {
     return await methodChannel.invokeMethod<void>('draw', <String, dynamic>{
-      'x': x, 'y': y, 'width': w, 'height': h, 'pixels': pixels, 'texture': texId
+      'x': x, 'y': y, 'width': w, 'height': h, 'pixels': pixels, 'texture': texId,
+      if (format != PixelFormat.rgba8888) 'format': format.index,
+      if (blend != PixelBlendMode.src) 'blend': blend.index,
+      if (encoding != PixelEncoding.raw) 'encoding': encoding.index
     });
   }
 
   @override
-  Future<Uint8List?> getPixels(int texId) async {
-    return await methodChannel.invokeMethod<Uint8List>('get_pixels', <String, int>{'texture': texId});
+  Future<void> drawBatch(Int64List records, Uint8List pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<void>('draw_batch', <String, dynamic>{
+      'records': records, 'pixels': pixels, 'invalidate': invalidate,
+      if (format != PixelFormat.rgba8888) 'format': format.index,
+      if (blend != PixelBlendMode.src) 'blend': blend.index
+    });
+  }
+
+  @override
+  Future<void> raster(int texId, Int32List commands, {bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<void>('raster', <String, dynamic>{
+      'texture': texId, 'commands': commands, 'invalidate': invalidate
+    });
+  }
+
+  @override
+  Future<void> blit(int texId, int x, int y, int w, int h,
+      {Uint8List? pixels,
+      int? source,
+      int srcX = 0,
+      int srcY = 0,
+      int? srcW,
+      int? srcH,
+      ScaleFilter filter = ScaleFilter.nearest,
+      bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<void>('blit', <String, dynamic>{
+      'texture': texId,
+      'x': x,
+      'y': y,
+      'width': w,
+      'height': h,
+      if (pixels != null) 'pixels': pixels,
+      if (source != null) 'source': source,
+      'src_x': srcX,
+      'src_y': srcY,
+      if (srcW != null) 'src_width': srcW,
+      if (srcH != null) 'src_height': srcH,
+      'filter': filter.index,
+      'invalidate': invalidate,
+    });
+  }
+
+  @override
+  Future<Uint8List?> getPixels(int texId,
+      {int? x, int? y, int? w, int? h, int? address}) async {
+    return await methodChannel.invokeMethod<Uint8List>('get_pixels', <String, int>{
+      'texture': texId,
+      if (x != null) 'x': x,
+      if (y != null) 'y': y,
+      if (w != null) 'width': w,
+      if (h != null) 'height': h,
+      if (address != null) 'address': address,
+    });
   }
 
   @override
@@ -53,11 +140,172 @@ class MethodChannelTestNative extends SwRendPlatform {
     return await methodChannel.invokeMethod<Int32List?>('get_size', <String, int>{'texture': texId});
   }
 
+  @override
+  Future<int?> getBufferAddress(int texId) async {
+    return await methodChannel.invokeMethod<int>('get_buffer_address', <String, int>{'texture': texId});
+  }
+
+  @override
+  Future<Map<String, dynamic>?> getDamage(int texId) async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('get_damage', <String, int>{'texture': texId});
+  }
+
   @override
   Future<Int64List?> listTextures() async {
     return await methodChannel.invokeMethod<Int64List>('list_textures');
   }
 
+  @override
+  Future<Map<String, dynamic>?> configure(
+      {int? workers,
+      int? threshold,
+      bool? renderThread,
+      bool? tracing,
+      String? commandLog,
+      int? spriteCacheBytes}) async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('configure', <String, dynamic>{
+      if (workers != null) 'workers': workers,
+      if (threshold != null) 'threshold': threshold,
+      if (renderThread != null) 'render_thread': renderThread,
+      if (tracing != null) 'tracing': tracing,
+      if (commandLog != null) 'command_log': commandLog,
+      if (spriteCacheBytes != null) 'sprite_cache_bytes': spriteCacheBytes
+    });
+  }
+
+  @override
+  Future<Map<String, dynamic>?> getPoolStats() async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('get_pool_stats');
+  }
+
+  @override
+  Future<String?> dumpTrace({bool clear = true}) async {
+    return await methodChannel.invokeMethod<String>('dump_trace', <String, dynamic>{'clear': clear});
+  }
+
+  @override
+  Future<Map<String, dynamic>?> getStats({int? texId, bool reset = false}) async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('get_stats', <String, dynamic>{
+      if (texId != null) 'texture': texId,
+      'reset': reset
+    });
+  }
+
+  @override
+  Future<void> startRecording(int texId, String path,
+      {CaptureFormat format = CaptureFormat.raw, int fps = 60}) async {
+    return await methodChannel.invokeMethod<void>('start_recording', <String, dynamic>{
+      'texture': texId,
+      'path': path,
+      'format': format.index,
+      'fps': fps
+    });
+  }
+
+  @override
+  Future<Map<String, dynamic>?> stopRecording(int texId) async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('stop_recording', <String, dynamic>{'texture': texId});
+  }
+
+  @override
+  Future<int?> addSprite(Uint8List pixels, int w, int h) async {
+    return await methodChannel.invokeMethod<int>('add_sprite', <String, dynamic>{
+      'pixels': pixels,
+      'width': w,
+      'height': h
+    });
+  }
+
+  @override
+  Future<bool?> removeSprite(int sprite) async {
+    return await methodChannel.invokeMethod<bool>('remove_sprite', <String, dynamic>{'sprite': sprite});
+  }
+
+  @override
+  Future<bool?> blitSprite(int texId, int sprite, int x, int y,
+      {int alpha = 255,
+      PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<bool>('blit_sprite', <String, dynamic>{
+      'texture': texId,
+      'sprite': sprite,
+      'x': x,
+      'y': y,
+      'alpha': alpha,
+      'blend': blend.index,
+      'invalidate': invalidate
+    });
+  }
+
+  @override
+  Future<Int64List?> blitSprites(int texId, Int64List records,
+      {PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<Int64List>('blit_sprites', <String, dynamic>{
+      'texture': texId,
+      'records': records,
+      'blend': blend.index,
+      'invalidate': invalidate
+    });
+  }
+
+  @override
+  Future<Map<String, dynamic>?> getSpriteStats() async {
+    return await methodChannel.invokeMapMethod<String, dynamic>('get_sprite_stats');
+  }
+
+  @override
+  Future<int?> setTilemap(int texId, Uint8List tileset, int tilesetW, int tilesetH,
+      int tileW, int tileH, int columns, int rows,
+      {Int32List? tiles, int x = 0, int y = 0, bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<int>('set_tilemap', <String, dynamic>{
+      'texture': texId,
+      'tileset': tileset,
+      'tileset_width': tilesetW,
+      'tileset_height': tilesetH,
+      'tile_width': tileW,
+      'tile_height': tileH,
+      'columns': columns,
+      'rows': rows,
+      if (tiles != null) 'tiles': tiles,
+      'x': x,
+      'y': y,
+      'invalidate': invalidate
+    });
+  }
+
+  @override
+  Future<void> removeTilemap(int texId) async {
+    return await methodChannel.invokeMethod<void>('remove_tilemap', <String, dynamic>{'texture': texId});
+  }
+
+  @override
+  Future<void> setTiles(int texId, int column, int row, int w, int h, Int32List tiles,
+      {bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<void>('set_tiles', <String, dynamic>{
+      'texture': texId,
+      'column': column,
+      'row': row,
+      'width': w,
+      'height': h,
+      'tiles': tiles,
+      'invalidate': invalidate
+    });
+  }
+
+  @override
+  Future<void> scrollTilemap(int texId, int x, int y, {bool invalidate = false}) async {
+    return await methodChannel.invokeMethod<void>('scroll_tilemap', <String, dynamic>{
+      'texture': texId,
+      'x': x,
+      'y': y,
+      'invalidate': invalidate
+    });
+  }
+
+  @override
+  Stream<PresentedFrame> get presentedFrames => _presentedFrames;
+
   @override
   Future<void> dispose(int texId) async {
     return await methodChannel.invokeMethod<void>('dispose', <String, int>{'texture': texId});
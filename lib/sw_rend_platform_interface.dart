@@ -18,6 +18,13 @@ import 'dart:typed_data';
 
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
+import 'capture_format.dart';
+import 'pixel_blend_mode.dart';
+import 'pixel_encoding.dart';
+import 'pixel_format.dart';
+import 'presented_frame.dart';
+import 'resize_anchor.dart';
+import 'scale_filter.dart';
 import 'sw_rend_method_channel.dart';
 
 abstract class SwRendPlatform extends PlatformInterface {
@@ -41,15 +48,67 @@ abstract class SwRendPlatform extends PlatformInterface {
     _instance = instance;
   }
 
-  Future<int?> init(int w, int h) {
+  Future<int?> init(int w, int h, {bool tearFree = false}) {
     throw UnimplementedError();
   }
 
-  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List pixels) {
+  /// Change the size of texture [texId] in place, keeping its ID, with its
+  /// content laid out according to [anchor]
+  Future<void> resize(int texId, int w, int h,
+      {ResizeAnchor anchor = ResizeAnchor.topLeft}) {
     throw UnimplementedError();
   }
 
-  Future<Uint8List?> getPixels(int texId) {
+  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List? pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw}) {
+    throw UnimplementedError();
+  }
+
+  /// Draw several rects, possibly to different textures, from one buffer
+  ///
+  /// [records] holds six values per rect: texture ID, x, y, width, height, and
+  /// the offset in [pixels] where its tightly packed rows start. If
+  /// [invalidate] is [true], each texture drawn to is redrawn afterwards.
+  Future<void> drawBatch(Int64List records, Uint8List pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Rasterize an encoded [RasterCommands] list into texture [texId], and
+  /// redraw it if [invalidate] is [true]
+  Future<void> raster(int texId, Int32List commands, {bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Scale a source image onto the [w] by [h] rect at ([x], [y]) in texture
+  /// [texId], and redraw it if [invalidate] is [true]
+  ///
+  /// The source is either [pixels], tightly packed RGBA rows of a [srcW] by
+  /// [srcH] image, or the [srcW] by [srcH] rect at ([srcX], [srcY]) of texture
+  /// [source], all of it by default.
+  Future<void> blit(int texId, int x, int y, int w, int h,
+      {Uint8List? pixels,
+      int? source,
+      int srcX = 0,
+      int srcY = 0,
+      int? srcW,
+      int? srcH,
+      ScaleFilter filter = ScaleFilter.nearest,
+      bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Read the RGBA pixels of a [w] by [h] rect at ([x], [y]) in texture
+  /// [texId], or of the whole texture if none is given
+  ///
+  /// If [address] is given, the rect is written to the native memory it
+  /// points to as tightly packed rows and null is returned instead.
+  Future<Uint8List?> getPixels(int texId,
+      {int? x, int? y, int? w, int? h, int? address}) {
     throw UnimplementedError();
   }
 
@@ -61,10 +120,165 @@ abstract class SwRendPlatform extends PlatformInterface {
     throw UnimplementedError();
   }
 
+  Future<int?> getBufferAddress(int texId) {
+    throw UnimplementedError();
+  }
+
+  /// Returns the damage recorded for a texture: `pending_rects` and
+  /// `pending_area` for the frame being drawn, `last_frame_area` for the last
+  /// redrawn frame, and `total_area` over all `frames` redrawn so far
+  Future<Map<String, dynamic>?> getDamage(int texId) {
+    throw UnimplementedError();
+  }
+
   Future<Int64List?> listTextures() {
     throw UnimplementedError();
   }
 
+  /// Set how many threads share large draws, fills and copies, and how many
+  /// bytes a job must touch before it is split. If [renderThread] is [true],
+  /// methods that touch textures run in order on a dedicated native thread
+  /// instead of the platform thread. [tracing] turns event tracing on or
+  /// off, see [dumpTrace]. [commandLog] starts logging the calls that
+  /// change textures to a file at that path for `sw_rend_replay`, or stops
+  /// if empty. [spriteCacheBytes] sets how much memory sprites may take, see
+  /// [addSprite]. Returns the settings in effect afterwards; omitted values
+  /// are left as they are.
+  Future<Map<String, dynamic>?> configure(
+      {int? workers,
+      int? threshold,
+      bool? renderThread,
+      bool? tracing,
+      String? commandLog,
+      int? spriteCacheBytes}) {
+    throw UnimplementedError();
+  }
+
+  /// Counters of the pool that texture memory is allocated from: "hits" and
+  /// "misses" for allocations that did and did not reuse a disposed
+  /// texture's memory, and "cached_bytes" held for reuse
+  Future<Map<String, dynamic>?> getPoolStats() {
+    throw UnimplementedError();
+  }
+
+  /// Events traced since tracing was turned on, or since the last dump that
+  /// cleared them, as Chrome trace JSON that chrome://tracing and Perfetto
+  /// load. Timestamps share the clock of the Flutter timeline. Tracing is
+  /// turned on with [configure], or at start-up by setting the
+  /// SW_REND_TRACE environment variable.
+  Future<String?> dumpTrace({bool clear = true}) {
+    throw UnimplementedError();
+  }
+
+  /// Performance counters of texture [texId], or summed over every texture
+  /// created so far if omitted: "draw_calls", "bytes_ingested" and
+  /// "draw_time_us" for draws, blits and command lists, "bytes_copied" by
+  /// presents and resizes, "invalidations", "frames_dropped" for
+  /// invalidations the engine never saw on their own, and
+  /// "copy_pixels_calls" for frames the engine asked for. A single texture
+  /// also reports "frames_presented". [reset] zeroes the counters read.
+  Future<Map<String, dynamic>?> getStats({int? texId, bool reset = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Write every frame texture [texId] presents from now on to a capture file
+  /// at [path], in [format]. [fps] is the frame rate a Y4M stream is labelled
+  /// with. Only the pixels that changed are copied as frames are presented;
+  /// the file is written on a background thread, which drops frames rather
+  /// than hold up drawing when it falls behind.
+  Future<void> startRecording(int texId, String path,
+      {CaptureFormat format = CaptureFormat.raw, int fps = 60}) {
+    throw UnimplementedError();
+  }
+
+  /// Stop recording texture [texId] once the frames captured so far are
+  /// written. Returns the "frames" and "bytes" written and the frames
+  /// "dropped".
+  Future<Map<String, dynamic>?> stopRecording(int texId) {
+    throw UnimplementedError();
+  }
+
+  /// Upload [pixels], tightly packed RGBA rows of a [w] by [h] image, to the
+  /// sprite cache shared by every texture. Returns the ID to draw it with.
+  /// Once sprites take up more than the cache holds, the least recently
+  /// used ones are evicted, and drawing them misses until they are added
+  /// again under a new ID.
+  Future<int?> addSprite(Uint8List pixels, int w, int h) {
+    throw UnimplementedError();
+  }
+
+  /// Drop sprite [sprite] from the cache. Returns whether it was there.
+  Future<bool?> removeSprite(int sprite) {
+    throw UnimplementedError();
+  }
+
+  /// Draw sprite [sprite] with its top-left corner at ([x], [y]) in texture
+  /// [texId], with [alpha] scaling its opacity, and redraw the texture if
+  /// [invalidate] is [true]. Returns false if the sprite was evicted.
+  Future<bool?> blitSprite(int texId, int sprite, int x, int y,
+      {int alpha = 255,
+      PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Draw many sprites into texture [texId] with one platform message
+  ///
+  /// [records] holds four values per sprite: sprite ID, x, y and alpha.
+  /// Returns the IDs of the sprites that were evicted and not drawn.
+  Future<Int64List?> blitSprites(int texId, Int64List records,
+      {PixelBlendMode blend = PixelBlendMode.srcOver,
+      bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Counters of the sprite cache: blit "hits" and "misses", "evictions",
+  /// the "sprites" and "bytes" held, and the "capacity" in bytes
+  Future<Map<String, dynamic>?> getSpriteStats() {
+    throw UnimplementedError();
+  }
+
+  /// Bind a [columns] by [rows] tilemap to texture [texId] and draw it,
+  /// replacing any tilemap bound before
+  ///
+  /// [tileset] holds tightly packed RGBA rows of a [tilesetW] by [tilesetH]
+  /// atlas of [tileW] by [tileH] tiles, numbered left to right, then top to
+  /// bottom. [tiles] gives the tile index of every cell, row by row; cells
+  /// are empty (-1) if omitted. The texture shows the map from ([x], [y]) in
+  /// map pixels. Returns the number of tiles in the tileset.
+  Future<int?> setTilemap(int texId, Uint8List tileset, int tilesetW, int tilesetH,
+      int tileW, int tileH, int columns, int rows,
+      {Int32List? tiles, int x = 0, int y = 0, bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Unbind the tilemap of texture [texId], leaving its content as it is
+  Future<void> removeTilemap(int texId) {
+    throw UnimplementedError();
+  }
+
+  /// Set the [w] by [h] cells at ([column], [row]) of the tilemap of texture
+  /// [texId] to [tiles], row by row. Only the cells that changed are
+  /// redrawn.
+  Future<void> setTiles(int texId, int column, int row, int w, int h, Int32List tiles,
+      {bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Show the tilemap of texture [texId] from ([x], [y]) in map pixels. What
+  /// stays in view is moved within the texture, and only the strips that
+  /// scroll into view are drawn.
+  Future<void> scrollTilemap(int texId, int x, int y, {bool invalidate = false}) {
+    throw UnimplementedError();
+  }
+
+  /// Every frame the engine takes from any texture. Invalidating a texture
+  /// again before the engine has taken its last frame does not ask for
+  /// another, so waiting for the next event paces drawing to the display.
+  Stream<PresentedFrame> get presentedFrames {
+    throw UnimplementedError();
+  }
+
   Future<void> dispose(int texId) {
     throw UnimplementedError();
   }
@@ -0,0 +1,76 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_BINARY_CHANNEL_H_
+#define INCLUDE_SW_BINARY_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include "sw_render_thread.h"
+
+// Name of the BasicMessageChannel carrying binary commands
+#define SW_BINARY_CHANNEL_NAME "com.funguscow/sw_rend/binary"
+
+// Every binary command starts with this fixed little-endian header:
+//
+//   0  uint8   opcode (SwBinaryOpcode)
+//   1  uint8   pixel format of the payload (SwPixelFormat), for draws
+//   2  uint16  flags (SwBinaryFlags)
+//   4  uint8   blend mode (SwBlendMode), for draws
+//   5  uint8   pixel encoding of the payload (SwEncoding), for draws
+//   6  uint8[2] reserved, must be 0
+//   8  int64   texture ID
+//  16  int32   x
+//  20  int32   y
+//  24  int32   width
+//  28  int32   height
+//  32  payload, the tightly packed pixels of the rect for draws
+//
+// The reply is a single SwBinaryStatus byte, followed for reads by the
+// tightly packed RGBA pixels of the rect.
+#define SW_BINARY_HEADER_SIZE 32
+
+typedef enum {
+  SW_BINARY_OP_DRAW = 1,
+  SW_BINARY_OP_INVALIDATE = 2,
+  // Reads the whole texture if width or height is 0
+  SW_BINARY_OP_READ = 3,
+} SwBinaryOpcode;
+
+typedef enum {
+  // Invalidate the texture once a draw is done
+  SW_BINARY_FLAG_INVALIDATE = 1,
+} SwBinaryFlags;
+
+typedef enum {
+  SW_BINARY_OK = 0,
+  SW_BINARY_NO_TEXTURE = 1,
+  SW_BINARY_MALFORMED = 2,
+  SW_BINARY_UNKNOWN_OP = 3,
+} SwBinaryStatus;
+
+// Returns the thread binary commands should run on, or nullptr to run them
+// on the platform thread
+typedef SwRenderThread* (*SwBinaryThreadFunc)(gpointer user_data);
+
+// Start handling binary commands sent through |messenger|. Each command runs
+// on the thread |get_thread| returns as it arrives, so that commands keep
+// their order relative to method calls run there. |destroy_notify| is called
+// on |user_data| once the channel is gone.
+void sw_binary_channel_register(FlBinaryMessenger* messenger, SwBinaryThreadFunc get_thread, gpointer user_data,
+                                GDestroyNotify destroy_notify);
+
+#endif //INCLUDE_SW_BINARY_CHANNEL_H_
@@ -0,0 +1,57 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_COMMAND_LOGGER_H_
+#define INCLUDE_SW_COMMAND_LOGGER_H_
+
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+
+#include "sw_command_log.h"
+
+// Writes the method calls that change textures to a command log for
+// sw_rend_replay: init, dispose, resize, draw, draw_batch (as one draw per
+// record), raster and invalidate, along with binary draws and invalidates and
+// FFI draws, damage and frame notifications. Blits, sprites, tilemaps and
+// native producers are only marked, so that a replay can tell which textures
+// diverge from the app. Other methods do not change textures and are not
+// logged. Logging a
+// call only copies it; a thread of its own writes the log and flushes it at
+// least every 100 ms, so a killed app loses at most its last moments.
+typedef struct _SwCommandLogger SwCommandLogger;
+
+// Create a command log at |path|. Returns nullptr and sets |error| if the
+// file cannot be created.
+SwCommandLogger* sw_command_logger_new(const gchar* path, GError** error);
+
+// Log a call of |method| with |arguments|. Init is logged once it has run,
+// with its |response| giving the texture ID; |response| is ignored for every
+// other method, which is logged as it arrives.
+void sw_command_logger_log(SwCommandLogger* logger, const gchar* method, FlValue* arguments,
+                           FlMethodResponse* response);
+
+// Log |command| in every open log, for writes that reach textures without a
+// method call, such as binary commands and FFI calls
+void sw_command_logger_log_all(SwCommand* command);
+
+// Mark |texture| as changed by |source| in every open log, for writes the log
+// cannot capture, such as native producers
+void sw_command_logger_mark_unlogged_all(int64_t texture, const gchar* source);
+
+// Close the log and free |logger|
+void sw_command_logger_free(SwCommandLogger* logger);
+
+#endif //INCLUDE_SW_COMMAND_LOGGER_H_
@@ -0,0 +1,31 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_DRAW_BATCH_H_
+#define INCLUDE_SW_DRAW_BATCH_H_
+
+// Fields of each record in a draw_batch "records" list
+enum {
+  SW_BATCH_TEXTURE,
+  SW_BATCH_X,
+  SW_BATCH_Y,
+  SW_BATCH_WIDTH,
+  SW_BATCH_HEIGHT,
+  SW_BATCH_OFFSET,
+  SW_BATCH_RECORD_SIZE,
+};
+
+#endif //INCLUDE_SW_DRAW_BATCH_H_
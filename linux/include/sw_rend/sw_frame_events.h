@@ -0,0 +1,41 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_FRAME_EVENTS_H_
+#define INCLUDE_SW_FRAME_EVENTS_H_
+
+#include <cstdint>
+
+#include <flutter_linux/flutter_linux.h>
+
+// Name of the EventChannel reporting frames taken by the engine. Each event
+// is an Int64List of the texture ID, the number of frames the engine has
+// taken from it so far, and the monotonic time in microseconds it took the
+// last one.
+#define SW_FRAME_EVENTS_CHANNEL_NAME "com.funguscow/sw_rend/frames"
+
+// Start reporting frames of textures registered with |registrar| on an event
+// channel through |messenger|
+void sw_frame_events_register(FlBinaryMessenger* messenger, FlTextureRegistrar* registrar);
+
+// Stop reporting frames of textures registered with |registrar|
+void sw_frame_events_unregister(FlTextureRegistrar* registrar);
+
+// Report that the engine took frame |frame| of |texture| at |time|. Must be
+// called on the platform thread; does nothing while Dart is not listening.
+void sw_frame_events_send(FlTextureRegistrar* registrar, int64_t texture, int64_t frame, int64_t time);
+
+#endif //INCLUDE_SW_FRAME_EVENTS_H_
@@ -22,20 +22,212 @@ limitations under the License.
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 
+#include "sw_blend.h"
+#include "sw_capture.h"
+#include "sw_damage.h"
+#include "sw_pixel_convert.h"
+#include "sw_recorder.h"
+#include "sw_rle.h"
+#include "sw_scale.h"
+#include "sw_sprite_cache.h"
+#include "sw_surface.h"
+#include "sw_tilemap.h"
+#include "sw_worker_pool.h"
+
+// Number of frame slots in a mailbox-mode SwPixelBuffer
+#define SW_PIXEL_BUFFER_SLOTS 3
+
+typedef enum {
+  // The engine reads straight out of |buffer|, so it may observe a frame
+  // that is still being drawn
+  SW_PIXEL_BUFFER_DIRECT,
+  // Each present publishes a snapshot of |buffer| through a triple-buffered
+  // mailbox; the engine always reads the latest complete frame and frames
+  // presented faster than they are consumed are dropped
+  SW_PIXEL_BUFFER_MAILBOX,
+} SwPixelBufferMode;
+
+// Where existing content ends up when a buffer is resized.
+// The values are part of the method channel protocol.
+typedef enum {
+  // Keep the top-left corner in place
+  SW_RESIZE_TOP_LEFT = 0,
+  // Keep the content centered, cropping or padding evenly on each side
+  SW_RESIZE_CENTER = 1,
+  // Drop the content
+  SW_RESIZE_CLEAR = 2,
+} SwResizeAnchor;
+
+#define SW_RESIZE_ANCHOR_COUNT 3
+
+// Counters kept for telemetry
+typedef struct {
+  // Draws, encoded draws, blits and raster command lists applied
+  int64_t draw_calls;
+  // Bytes of pixels, encoded data or commands those were given
+  int64_t bytes_ingested;
+  // Time spent applying them, in microseconds
+  int64_t draw_time_us;
+  // Bytes copied between stores by presents and resizes
+  int64_t bytes_copied;
+  int64_t invalidations;
+  // Invalidations folded into a frame the engine had yet to take, so never
+  // shown on their own
+  int64_t frames_dropped;
+  // Times the engine asked for a frame
+  int64_t copy_pixels_calls;
+} SwPixelBufferStats;
+
 typedef struct _SwPixelBuffer { // extends FlPixelBufferTexture
   FlPixelBufferTexture parent_instance;
   uint8_t* buffer;
   int64_t width;
   int64_t height;
+  SwPixelBufferMode mode;
+  // Mailbox slots, only allocated in SW_PIXEL_BUFFER_MAILBOX mode.
+  // |back| is owned by the writer and |front| by the raster thread, while
+  // |pending| is exchanged atomically between the two.
+  uint8_t* slots[SW_PIXEL_BUFFER_SLOTS];
+  // What each slot is missing compared to |buffer|
+  SwDamage slot_damage[SW_PIXEL_BUFFER_SLOTS];
+  gint back;
+  gint pending;
+  gint front;
+  // Registrar the texture is registered with, or nullptr
+  FlTextureRegistrar* registrar;
+  // Regions changed since the last present
+  SwDamage damage;
+  // Damaged area of the last presented frame, and totals over all frames
+  int64_t last_frame_damage_area;
+  int64_t total_damage_area;
+  int64_t frames_presented;
+  // Set while the engine has been told about a frame it has not taken yet,
+  // so that further invalidations until then only update the frame
+  gint frame_pending;
+  // Frames the engine has taken, only touched by the raster thread
+  int64_t frames_consumed;
+  // Set once |buffer| is handed out for direct writes, after which a present
+  // with no damage recorded assumes the whole buffer changed
+  gboolean shared;
+  // Splits large draws, fills and slot copies into row bands, or nullptr
+  SwWorkerPool* workers;
+  // Serializes writers, which may run on the platform thread or, through the
+  // FFI entry points, on the Dart UI thread
+  GMutex lock;
+  // Guards the stores and size handed to the engine against resizes, and is
+  // taken after |lock|
+  GMutex frame_lock;
+  // Stores replaced by a resize that the engine may still be reading, freed
+  // the next time it asks for a frame
+  GSList* retired;
+  // Stores replaced by a resize once |shared| is set, which the app may still
+  // be writing to through the address it was given. Guarded by |lock|, and
+  // moved to |retired| the next time the app asks for the address.
+  GSList* shared_retired;
+  // Guarded by |lock|, except |copy_pixels_calls| which is guarded by
+  // |frame_lock|
+  SwPixelBufferStats stats;
+  // Writes each presented frame to a capture file, or nullptr. Guarded by
+  // |lock|, like |record_key|, which is set when the next frame recorded
+  // must not depend on earlier ones.
+  SwRecorder* recorder;
+  gboolean record_key;
+  // Tilemap drawn into |buffer|, or nullptr. Guarded by |lock|.
+  SwTilemap* tilemap;
 } SwPixelBuffer;
 
 typedef struct { // extends FlPixelBufferTextureClass
   FlPixelBufferTextureClass parent_class;
 } SwPixelBufferClass;
 
-SwPixelBuffer* sw_pixel_buffer_new(int64_t width, int64_t height);
+// The buffer keeps a reference to |workers| if given
+SwPixelBuffer* sw_pixel_buffer_new(int64_t width, int64_t height, SwPixelBufferMode mode = SW_PIXEL_BUFFER_DIRECT,
+                                   SwWorkerPool* workers = nullptr);
 void sw_pixel_buffer_dispose(SwPixelBuffer* buffer);
-void sw_pixel_buffer_draw_rect(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t x, int64_t y, int64_t width, int64_t height);
+// Draw a |width| x |height| rect of tightly packed |format| pixels to (|x|, |y|)
+void sw_pixel_buffer_draw_rect(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t x, int64_t y, int64_t width, int64_t height,
+                               SwPixelFormat format = SW_PIXEL_FORMAT_RGBA8888, SwBlendMode blend = SW_BLEND_SRC);
+// Decode |length| bytes of |encoding| encoded RGBA pixels into the |width| x
+// |height| rect at (|x|, |y|), which must lie within |buffer|. Returns FALSE,
+// leaving |buffer| untouched, if the rect does not fit or the data is
+// malformed.
+gboolean sw_pixel_buffer_decode_rect(SwPixelBuffer* buffer, const uint8_t* data, size_t length,
+                                     int64_t x, int64_t y, int64_t width, int64_t height, SwEncoding encoding);
+// Copy the |width| x |height| rect at (|x|, |y|) to |dst| as tightly packed
+// RGBA rows. Returns FALSE if the rect does not lie within |buffer|.
+gboolean sw_pixel_buffer_read_rect(SwPixelBuffer* buffer, uint8_t* dst, int64_t x, int64_t y, int64_t width, int64_t height);
+// Scale the |src_width| x |src_height| RGBA image at |pixels|, whose rows are
+// |src_stride| bytes apart, onto the |width| x |height| rect at (|x|, |y|),
+// clipped to |buffer|
+void sw_pixel_buffer_blit_scaled(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t src_stride,
+                                 int64_t src_width, int64_t src_height,
+                                 int64_t x, int64_t y, int64_t width, int64_t height, SwScaleFilter filter);
+// Scale the |src_width| x |src_height| rect at (|src_x|, |src_y|) of |source|,
+// which may be |buffer| itself, onto the |width| x |height| rect at (|x|, |y|).
+// Returns FALSE if the source rect does not lie within |source|.
+gboolean sw_pixel_buffer_blit_from(SwPixelBuffer* buffer, SwPixelBuffer* source,
+                                   int64_t src_x, int64_t src_y, int64_t src_width, int64_t src_height,
+                                   int64_t x, int64_t y, int64_t width, int64_t height, SwScaleFilter filter);
+// Draw sprite |id| of |sprites| with its top-left corner at (|x|, |y|), see
+// sw_sprite_cache_draw. Returns FALSE if the sprite is not in the cache.
+gboolean sw_pixel_buffer_blit_sprite(SwPixelBuffer* buffer, SwSpriteCache* sprites, int64_t id,
+                                     int64_t x, int64_t y, uint8_t alpha, SwBlendMode blend);
+// Bind |tilemap| to |buffer|, which takes ownership of it, and draw all of
+// it, replacing any tilemap bound before. Passing nullptr unbinds the
+// tilemap and leaves the content as it is.
+void sw_pixel_buffer_set_tilemap(SwPixelBuffer* buffer, SwTilemap* tilemap);
+// Change cells of the bound tilemap, see sw_tilemap_set_tiles. Returns FALSE
+// if there is no tilemap or the cells do not lie within it.
+gboolean sw_pixel_buffer_set_tiles(SwPixelBuffer* buffer, int64_t column, int64_t row, int64_t width, int64_t height,
+                                   const int32_t* tiles);
+// Scroll the bound tilemap to (|x|, |y|), see sw_tilemap_scroll. Returns
+// FALSE if there is no tilemap.
+gboolean sw_pixel_buffer_scroll_tilemap(SwPixelBuffer* buffer, int64_t x, int64_t y);
+// Change the size of |buffer| in place, keeping its ID, and lay out the
+// existing content according to |anchor|. Any new area is cleared, or drawn
+// from the bound tilemap, which then fills the whole buffer. Addresses from
+// before the resize must not be written to afterwards.
+void sw_pixel_buffer_resize(SwPixelBuffer* buffer, int64_t width, int64_t height, SwResizeAnchor anchor);
+// Run a command list checked with sw_raster_validate against |buffer|
+void sw_pixel_buffer_raster(SwPixelBuffer* buffer, const int32_t* commands, size_t length);
+// Hand out the address of |buffer|'s pixels for direct writes, after which
+// presents without recorded damage take the whole buffer as changed
+uint8_t* sw_pixel_buffer_share(SwPixelBuffer* buffer);
+// Record that a region of |buffer| was written to directly
+void sw_pixel_buffer_damage(SwPixelBuffer* buffer, int64_t x, int64_t y, int64_t width, int64_t height);
+// Publish the current contents of |buffer| as the next frame for the engine
+// and start accumulating damage for the next one.
+void sw_pixel_buffer_present(SwPixelBuffer* buffer);
+// Present |buffer| and tell the engine a new frame is available, unless it
+// has not yet taken the last one, which then picks up this frame instead.
+// May be called from any thread; the engine is notified from the platform
+// thread.
+void sw_pixel_buffer_invalidate(SwPixelBuffer* buffer);
+
+// Start writing every frame presented from now on to a capture file at
+// |path|. Returns FALSE and sets |error| if |buffer| is already being
+// recorded or the file cannot be created.
+gboolean sw_pixel_buffer_start_recording(SwPixelBuffer* buffer, const gchar* path, SwCaptureFormat format, int fps,
+                                         GError** error);
+// Stop recording |buffer| once the frames captured so far are written, and
+// report what was written to |stats|. Returns FALSE if it was not being
+// recorded.
+gboolean sw_pixel_buffer_stop_recording(SwPixelBuffer* buffer, SwRecorderStats* stats);
+
+// Copy the counters of |buffer| to |stats|, then zero them if |reset| is set
+void sw_pixel_buffer_get_stats(SwPixelBuffer* buffer, SwPixelBufferStats* stats, gboolean reset);
+// Sum the counters of every registered buffer and every buffer since
+// finalized into |stats|, then zero them all if |reset| is set
+void sw_pixel_buffer_get_global_stats(SwPixelBufferStats* stats, gboolean reset);
+
+// Register |buffer| with the engine and make it reachable by ID from any thread
+gboolean sw_pixel_buffer_register(SwPixelBuffer* buffer, FlTextureRegistrar* registrar);
+// Make |buffer| unreachable by ID. May be called from any thread; the engine
+// forgets the texture on the platform thread.
+void sw_pixel_buffer_unregister(SwPixelBuffer* buffer);
+// Look up a registered buffer by ID from any thread. Returns a new reference
+// that must be released with g_object_unref, or nullptr.
+SwPixelBuffer* sw_pixel_buffer_lookup(int64_t id);
 
 inline int64_t sw_pixel_buffer_get_id(SwPixelBuffer* buffer) {
   return (int64_t)(&buffer->parent_instance);
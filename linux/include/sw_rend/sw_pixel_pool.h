@@ -0,0 +1,56 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_PIXEL_POOL_H_
+#define INCLUDE_SW_PIXEL_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glib.h>
+
+// Alignment of every pixel store, enough for any SIMD row copy and for
+// handing stores to Dart as-is
+#define SW_PIXEL_POOL_ALIGNMENT 64
+
+// Stores at least this large are mapped directly and backed by huge pages
+// where the kernel allows
+#define SW_PIXEL_POOL_HUGE_THRESHOLD (2 * 1024 * 1024)
+
+// Most bytes kept in freed stores waiting to be reused
+#define SW_PIXEL_POOL_MAX_CACHED (64 * 1024 * 1024)
+
+typedef struct {
+  // Allocations served from a freed store, and ones that needed new memory
+  int64_t hits;
+  int64_t misses;
+  // Bytes currently held in freed stores
+  int64_t cached_bytes;
+} SwPixelPoolStats;
+
+// Allocate a store of at least |size| bytes. Freed stores of the same size
+// class are reused, and only cleared to 0 if |zero| is set.
+uint8_t* sw_pixel_pool_alloc(size_t size, gboolean zero);
+
+// Return a store from sw_pixel_pool_alloc, given the same |size|
+void sw_pixel_pool_free(uint8_t* store, size_t size);
+
+void sw_pixel_pool_get_stats(SwPixelPoolStats* stats);
+
+// Release every cached store back to the system
+void sw_pixel_pool_trim();
+
+#endif //INCLUDE_SW_PIXEL_POOL_H_
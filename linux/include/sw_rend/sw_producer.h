@@ -0,0 +1,101 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FLUTTER_PLUGIN_SW_PRODUCER_H_
+#define FLUTTER_PLUGIN_SW_PRODUCER_H_
+
+// Entry points for native renderers linked into the app, such as emulator
+// cores or video decoders, to draw into a texture without going through Dart.
+// Every function may be called from any thread.
+//
+// A producer locks the texture, writes RGBA pixels into the frame it gets
+// back and submits them:
+//
+//   SwProducer* producer = sw_producer_acquire(texture_id);
+//   SwProducerFrame frame;
+//   if (producer != NULL && sw_producer_lock(producer, &frame)) {
+//     render(frame.pixels, frame.width, frame.height, frame.stride);
+//     sw_producer_submit(producer, NULL, 0);
+//   }
+//   sw_producer_release(producer);
+//
+// Submitting presents the frame and tells the engine about it from the
+// platform thread. Frames submitted before the engine takes the previous one
+// are folded into it, so a producer running faster than the display only
+// costs the copies, not extra engine work.
+//
+// The lock is the texture's own buffer lock and is not reentrant. Between
+// locking and unlocking or submitting, the producer must not call anything
+// else that touches the texture: no other sw_producer_* function on it, no
+// sw_pixel_buffer_* function, and no plugin entry point, such as the FFI
+// draw functions or a method channel handler run from the same thread.
+// Doing so deadlocks.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sw_rend_plugin.h"
+
+G_BEGIN_DECLS
+
+// A texture held by a producer
+typedef struct _SwProducer SwProducer;
+
+// Pixels of a locked texture, valid until it is unlocked or submitted
+typedef struct {
+  uint8_t* pixels;
+  int64_t width;
+  int64_t height;
+  // Bytes between the starts of consecutive rows
+  int64_t stride;
+} SwProducerFrame;
+
+// A region written since the texture was locked
+typedef struct {
+  int64_t x;
+  int64_t y;
+  int64_t width;
+  int64_t height;
+} SwProducerRect;
+
+// Look up a texture by ID. Returns NULL if it is not registered. The
+// texture stays valid, though possibly no longer displayed, until released.
+FLUTTER_PLUGIN_EXPORT SwProducer* sw_producer_acquire(int64_t texture);
+
+// Drop a texture returned by sw_producer_acquire. Accepts NULL.
+FLUTTER_PLUGIN_EXPORT void sw_producer_release(SwProducer* producer);
+
+// Lock the texture for writing, waiting for any other writer, and fill in
+// |frame|. The size cannot change until the texture is unlocked. Returns 1.
+// Calling into the texture or the plugin before unlocking deadlocks.
+FLUTTER_PLUGIN_EXPORT int32_t sw_producer_lock(SwProducer* producer, SwProducerFrame* frame);
+
+// Like sw_producer_lock, but returns 0 instead of waiting if another writer
+// holds the texture
+FLUTTER_PLUGIN_EXPORT int32_t sw_producer_try_lock(SwProducer* producer, SwProducerFrame* frame);
+
+// Record the |count| |rects| written, or the whole texture if |count| is 0,
+// and unlock the texture without presenting. The writes show up with the next
+// frame presented.
+FLUTTER_PLUGIN_EXPORT void sw_producer_unlock(SwProducer* producer, const SwProducerRect* rects, size_t count);
+
+// Unlock the texture as sw_producer_unlock does, then present it as a new
+// frame
+FLUTTER_PLUGIN_EXPORT void sw_producer_submit(SwProducer* producer, const SwProducerRect* rects, size_t count);
+
+G_END_DECLS
+
+#endif  // FLUTTER_PLUGIN_SW_PRODUCER_H_
@@ -0,0 +1,61 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_RECORDER_H_
+#define INCLUDE_SW_RECORDER_H_
+
+#include <cstdint>
+
+#include <glib.h>
+
+#include "sw_capture.h"
+
+// Bytes of pixels that may wait to be written before frames are dropped
+#define SW_RECORDER_MAX_BACKLOG (64 * 1024 * 1024)
+
+typedef struct {
+  int64_t frames_written;
+  // Frames skipped because the writer fell behind, or, in Y4M, because the
+  // texture changed size
+  int64_t frames_dropped;
+  int64_t bytes_written;
+} SwRecorderStats;
+
+// Writes captured frames to a file on a thread of its own, so that the
+// thread presenting them only copies the pixels that changed. Rather than
+// wait for the writer, frames are dropped once SW_RECORDER_MAX_BACKLOG bytes
+// are queued.
+typedef struct _SwRecorder SwRecorder;
+
+// Create |path| and start writing |format| frames to it, labelling a Y4M
+// stream as |fps| frames per second. Returns nullptr and sets |error| if the
+// file cannot be created.
+SwRecorder* sw_recorder_new(const gchar* path, SwCaptureFormat format, int fps, GError** error);
+
+// Reserve room in the backlog for a frame with |bytes| bytes of pixels, to
+// be pushed next. Returns FALSE, counting the frame as dropped, if there is
+// no room; the next frame pushed should then be a key frame.
+gboolean sw_recorder_reserve(SwRecorder* recorder, int64_t bytes);
+
+// Queue |frame| to be written, taking ownership of it and of its pixels,
+// which must both be allocated with g_malloc
+void sw_recorder_push(SwRecorder* recorder, SwCaptureFrame* frame);
+
+// Write every queued frame, close the file and free |recorder|, reporting
+// what it did to |stats| if not nullptr
+void sw_recorder_free(SwRecorder* recorder, SwRecorderStats* stats);
+
+#endif //INCLUDE_SW_RECORDER_H_
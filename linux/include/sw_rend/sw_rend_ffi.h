@@ -0,0 +1,50 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef FLUTTER_PLUGIN_SW_REND_FFI_H_
+#define FLUTTER_PLUGIN_SW_REND_FFI_H_
+
+// Synchronous entry points for dart:ffi. Unlike the method channel these run
+// on the calling (Dart UI) thread and return as soon as the work is done.
+// Each returns 1 on success and 0 if |texture| is not a registered texture ID.
+
+#include <cstdint>
+
+#include "sw_rend_plugin.h"
+
+G_BEGIN_DECLS
+
+// Copy a |width| x |height| RGBA rect from |pixels| to (|x|, |y|) in the texture
+FLUTTER_PLUGIN_EXPORT int32_t sw_rend_draw_rect(int64_t texture, const uint8_t* pixels,
+                                                int64_t x, int64_t y, int64_t width, int64_t height);
+
+// Record that a rect of the texture was written through its shared buffer
+FLUTTER_PLUGIN_EXPORT int32_t sw_rend_damage_rect(int64_t texture, int64_t x, int64_t y, int64_t width, int64_t height);
+
+// Present the texture and notify the engine that a new frame is available
+FLUTTER_PLUGIN_EXPORT int32_t sw_rend_mark_frame_available(int64_t texture);
+
+// Copy the |width| x |height| rect at (|x|, |y|) of the texture to |pixels| as
+// tightly packed RGBA rows. Returns -1 if the rect does not lie within the
+// texture.
+FLUTTER_PLUGIN_EXPORT int32_t sw_rend_read_rect(int64_t texture, uint8_t* pixels,
+                                                int64_t x, int64_t y, int64_t width, int64_t height);
+
+FLUTTER_PLUGIN_EXPORT int32_t sw_rend_get_size(int64_t texture, int32_t* width, int32_t* height);
+
+G_END_DECLS
+
+#endif  // FLUTTER_PLUGIN_SW_REND_FFI_H_
@@ -0,0 +1,44 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_RENDER_THREAD_H_
+#define INCLUDE_SW_RENDER_THREAD_H_
+
+#include <glib.h>
+
+// Commands that can be queued before the producer has to wait
+#define SW_RENDER_RING_SIZE 256
+
+// Runs one command on the render thread. |owner| is the pointer the thread
+// was created with.
+typedef void (*SwRenderTask)(gpointer owner, gpointer data, gpointer user_data);
+
+// A thread that runs commands in the order they were pushed. Commands pass
+// through a lock-free single-producer/single-consumer ring, so pushing never
+// takes a lock unless the render thread is asleep or the ring is full.
+// Only one thread may push.
+typedef struct _SwRenderThread SwRenderThread;
+
+SwRenderThread* sw_render_thread_new(gpointer owner);
+
+// Queue |task| to run on the render thread with |data| and |user_data|.
+// Waits for space if SW_RENDER_RING_SIZE commands are already queued.
+void sw_render_thread_push(SwRenderThread* thread, SwRenderTask task, gpointer data, gpointer user_data);
+
+// Run every queued command, then stop and free the thread
+void sw_render_thread_free(SwRenderThread* thread);
+
+#endif //INCLUDE_SW_RENDER_THREAD_H_
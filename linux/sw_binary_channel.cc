@@ -0,0 +1,279 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_binary_channel.h"
+#include "include/sw_rend/sw_command_logger.h"
+#include "include/sw_rend/sw_pixel_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+typedef struct {
+  uint8_t opcode;
+  uint8_t format;
+  uint16_t flags;
+  uint8_t blend;
+  uint8_t encoding;
+  int64_t texture;
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+} SwBinaryHeader;
+
+static uint16_t sw_read_le16(const uint8_t* data) {
+  return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t sw_read_le32(const uint8_t* data) {
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t sw_read_le64(const uint8_t* data) {
+  return (uint64_t)sw_read_le32(data) | ((uint64_t)sw_read_le32(data + 4) << 32);
+}
+
+static void sw_binary_header_parse(SwBinaryHeader* header, const uint8_t* data) {
+  header->opcode = data[0];
+  header->format = data[1];
+  header->flags = sw_read_le16(data + 2);
+  header->blend = data[4];
+  header->encoding = data[5];
+  header->texture = (int64_t)sw_read_le64(data + 8);
+  header->x = (int32_t)sw_read_le32(data + 16);
+  header->y = (int32_t)sw_read_le32(data + 20);
+  header->width = (int32_t)sw_read_le32(data + 24);
+  header->height = (int32_t)sw_read_le32(data + 28);
+}
+
+// Log a draw or invalidate in any open command log, as the method channel
+// does for its own
+static void sw_binary_log(const SwBinaryHeader* header, const uint8_t* payload, size_t payload_length) {
+  SwCommand command = {};
+  command.texture = header->texture;
+  if (header->opcode == SW_BINARY_OP_DRAW) {
+    command.op = SW_COMMAND_DRAW;
+    command.x = header->x;
+    command.y = header->y;
+    command.width = header->width;
+    command.height = header->height;
+    command.format = header->format;
+    command.blend = header->blend;
+    command.encoding = header->encoding;
+    command.payload = payload;
+    command.payload_length = payload_length;
+    sw_command_logger_log_all(&command);
+    if (!(header->flags & SW_BINARY_FLAG_INVALIDATE)) {
+      return;
+    }
+    command = {};
+    command.texture = header->texture;
+  }
+  command.op = SW_COMMAND_INVALIDATE;
+  sw_command_logger_log_all(&command);
+}
+
+static FlValue* sw_binary_status(SwBinaryStatus status) {
+  uint8_t byte = status;
+  return fl_value_new_uint8_list(&byte, 1);
+}
+
+static FlValue* sw_binary_draw(SwPixelBuffer* buffer, const SwBinaryHeader* header, const uint8_t* payload, size_t payload_length) {
+  if (!sw_pixel_format_is_valid(header->format) || !sw_blend_mode_is_valid(header->blend) ||
+      !sw_encoding_is_valid(header->encoding) || header->width < 0 || header->height < 0) {
+    return sw_binary_status(SW_BINARY_MALFORMED);
+  }
+  if (header->encoding != SW_ENCODING_RAW) {
+    if (header->format != SW_PIXEL_FORMAT_RGBA8888 || header->blend != SW_BLEND_SRC ||
+        !sw_pixel_buffer_decode_rect(buffer, payload, payload_length, header->x, header->y, header->width,
+                                     header->height, (SwEncoding)header->encoding)) {
+      return sw_binary_status(SW_BINARY_MALFORMED);
+    }
+    if (header->flags & SW_BINARY_FLAG_INVALIDATE) {
+      sw_pixel_buffer_invalidate(buffer);
+    }
+    return sw_binary_status(SW_BINARY_OK);
+  }
+  SwPixelFormat format = (SwPixelFormat)header->format;
+  if (payload_length / sw_pixel_format_bytes_per_pixel(format) / MAX(header->width, 1) < (size_t)header->height) {
+    return sw_binary_status(SW_BINARY_MALFORMED);
+  }
+  sw_pixel_buffer_draw_rect(buffer, payload, header->x, header->y, header->width, header->height, format,
+                            (SwBlendMode)header->blend);
+  if (header->flags & SW_BINARY_FLAG_INVALIDATE) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return sw_binary_status(SW_BINARY_OK);
+}
+
+static FlValue* sw_binary_read(SwPixelBuffer* buffer, const SwBinaryHeader* header) {
+  SwRect rect = {header->x, header->y, header->width, header->height};
+  if (rect.width == 0 || rect.height == 0) {
+    rect = {0, 0, buffer->width, buffer->height};
+  }
+  // Check the rect before allocating for it; reading checks it again under
+  // the lock in case the texture is resized in between
+  if (rect.x < 0 || rect.y < 0 || rect.width < 0 || rect.height < 0 || rect.x > buffer->width - rect.width ||
+      rect.y > buffer->height - rect.height) {
+    return sw_binary_status(SW_BINARY_MALFORMED);
+  }
+  size_t size = 4 * rect.width * rect.height;
+  uint8_t* reply = (uint8_t*)g_malloc(1 + size);
+  reply[0] = SW_BINARY_OK;
+  if (!sw_pixel_buffer_read_rect(buffer, reply + 1, rect.x, rect.y, rect.width, rect.height)) {
+    g_free(reply);
+    return sw_binary_status(SW_BINARY_MALFORMED);
+  }
+  FlValue* result = fl_value_new_uint8_list(reply, 1 + size);
+  g_free(reply);
+  return result;
+}
+
+// Run a command against |buffer|, which it releases
+static FlValue* sw_binary_run(SwPixelBuffer* buffer, const SwBinaryHeader* header, FlValue* message) {
+  const uint8_t* payload = fl_value_get_uint8_list(message) + SW_BINARY_HEADER_SIZE;
+  size_t payload_length = fl_value_get_length(message) - SW_BINARY_HEADER_SIZE;
+  FlValue* reply;
+  switch (header->opcode) {
+    case SW_BINARY_OP_DRAW:
+      reply = sw_binary_draw(buffer, header, payload, payload_length);
+      break;
+    case SW_BINARY_OP_INVALIDATE:
+      sw_pixel_buffer_invalidate(buffer);
+      reply = sw_binary_status(SW_BINARY_OK);
+      break;
+    case SW_BINARY_OP_READ:
+      reply = sw_binary_read(buffer, header);
+      break;
+    default:
+      reply = sw_binary_status(SW_BINARY_UNKNOWN_OP);
+      break;
+  }
+  g_object_unref(buffer);
+  return reply;
+}
+
+static void sw_binary_respond(FlBasicMessageChannel* channel, FlBasicMessageChannelResponseHandle* response_handle,
+                              FlValue* reply) {
+  g_autoptr(GError) error = nullptr;
+  if (!fl_basic_message_channel_respond(channel, response_handle, reply, &error)) {
+    g_warning("Failed to respond to binary command: %s", error->message);
+  }
+}
+
+typedef struct {
+  SwBinaryThreadFunc get_thread;
+  gpointer user_data;
+  GDestroyNotify destroy_notify;
+} SwBinaryHandler;
+
+static void sw_binary_handler_free(gpointer user_data) {
+  SwBinaryHandler* handler = (SwBinaryHandler*)user_data;
+  if (handler->destroy_notify != nullptr) {
+    handler->destroy_notify(handler->user_data);
+  }
+  g_free(handler);
+}
+
+// A command on its way through the render thread and back
+typedef struct {
+  FlBasicMessageChannel* channel;
+  FlBasicMessageChannelResponseHandle* response_handle;
+  FlValue* message;
+  SwPixelBuffer* buffer;
+  SwBinaryHeader header;
+  FlValue* reply;
+} SwBinaryPending;
+
+static gboolean sw_binary_respond_cb(gpointer user_data) {
+  SwBinaryPending* pending = (SwBinaryPending*)user_data;
+  sw_binary_respond(pending->channel, pending->response_handle, pending->reply);
+  return G_SOURCE_REMOVE;
+}
+
+static void sw_binary_pending_free(gpointer user_data) {
+  SwBinaryPending* pending = (SwBinaryPending*)user_data;
+  g_object_unref(pending->channel);
+  g_object_unref(pending->response_handle);
+  fl_value_unref(pending->message);
+  fl_value_unref(pending->reply);
+  g_free(pending);
+}
+
+static void sw_binary_run_offloaded(gpointer owner, gpointer data, gpointer user_data) {
+  SwBinaryPending* pending = (SwBinaryPending*)data;
+  pending->reply = sw_binary_run(pending->buffer, &pending->header, pending->message);
+  // Respond from the platform thread, as method calls run here do
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(source, sw_binary_respond_cb, pending, sw_binary_pending_free);
+  g_source_attach(source, g_main_context_default());
+  g_source_unref(source);
+}
+
+static void sw_binary_message_cb(FlBasicMessageChannel* channel, FlValue* message,
+                                 FlBasicMessageChannelResponseHandle* response_handle, gpointer user_data) {
+  SwBinaryHandler* handler = (SwBinaryHandler*)user_data;
+  if (message == nullptr || fl_value_get_type(message) != FL_VALUE_TYPE_UINT8_LIST ||
+      fl_value_get_length(message) < SW_BINARY_HEADER_SIZE) {
+    g_autoptr(FlValue) reply = sw_binary_status(SW_BINARY_MALFORMED);
+    sw_binary_respond(channel, response_handle, reply);
+    return;
+  }
+  const uint8_t* data = fl_value_get_uint8_list(message);
+  SwBinaryHeader header;
+  sw_binary_header_parse(&header, data);
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(header.texture);
+  if (buffer == nullptr) {
+    g_autoptr(FlValue) reply = sw_binary_status(SW_BINARY_NO_TEXTURE);
+    sw_binary_respond(channel, response_handle, reply);
+    return;
+  }
+  // Logged on arrival, like method calls, so the log keeps the order the
+  // app sent them in
+  if (header.opcode == SW_BINARY_OP_DRAW) {
+    sw_binary_log(&header, data + SW_BINARY_HEADER_SIZE, fl_value_get_length(message) - SW_BINARY_HEADER_SIZE);
+  } else if (header.opcode == SW_BINARY_OP_INVALIDATE) {
+    sw_binary_log(&header, nullptr, 0);
+  }
+  SwRenderThread* thread = handler->get_thread != nullptr ? handler->get_thread(handler->user_data) : nullptr;
+  if (thread != nullptr) {
+    SwBinaryPending* pending = g_new0(SwBinaryPending, 1);
+    pending->channel = FL_BASIC_MESSAGE_CHANNEL(g_object_ref(channel));
+    pending->response_handle = FL_BASIC_MESSAGE_CHANNEL_RESPONSE_HANDLE(g_object_ref(response_handle));
+    pending->message = fl_value_ref(message);
+    pending->buffer = buffer;
+    pending->header = header;
+    sw_render_thread_push(thread, sw_binary_run_offloaded, pending, nullptr);
+    return;
+  }
+  g_autoptr(FlValue) reply = sw_binary_run(buffer, &header, message);
+  sw_binary_respond(channel, response_handle, reply);
+}
+
+void sw_binary_channel_register(FlBinaryMessenger* messenger, SwBinaryThreadFunc get_thread, gpointer user_data,
+                                GDestroyNotify destroy_notify) {
+  SwBinaryHandler* handler = g_new(SwBinaryHandler, 1);
+  handler->get_thread = get_thread;
+  handler->user_data = user_data;
+  handler->destroy_notify = destroy_notify;
+  g_autoptr(FlBinaryCodec) codec = fl_binary_codec_new();
+  g_autoptr(FlBasicMessageChannel) channel =
+      fl_basic_message_channel_new(messenger, SW_BINARY_CHANNEL_NAME, FL_MESSAGE_CODEC(codec));
+  fl_basic_message_channel_set_message_handler(channel, sw_binary_message_cb, handler, sw_binary_handler_free);
+}
@@ -0,0 +1,361 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_command_logger.h"
+#include "include/sw_rend/sw_draw_batch.h"
+#include "sw_command_log.h"
+#include "sw_pixel_convert.h"
+#include "sw_trace.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <flutter_linux/flutter_linux.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+// Longest a logged command waits before it is written and flushed
+#define SW_COMMAND_LOGGER_FLUSH_INTERVAL_US (100 * 1000)
+
+// Bytes of commands that wake the writer before the interval is up
+#define SW_COMMAND_LOGGER_CHUNK (4 * 1024 * 1024)
+
+// Bytes of commands that may wait to be written before logging blocks.
+// Unlike frames, commands cannot be dropped without breaking the replay.
+#define SW_COMMAND_LOGGER_MAX_BACKLOG (64 * 1024 * 1024)
+
+struct _SwCommandLogger {
+  GThread* thread;
+  // Only touched by the writer once it has started
+  FILE* file;
+  // Monotonic time the log started at
+  gint64 start;
+  // Guards everything below. |cond| is signalled when the writer should wake
+  // up and when it has taken the pending commands.
+  GMutex lock;
+  GCond cond;
+  // Encoded commands waiting for the writer
+  GByteArray* pending;
+  gboolean stopping;
+  gboolean failed;
+};
+
+static int64_t sw_command_logger_get_int_or(FlValue* arguments, const char* key, int64_t fallback) {
+  FlValue* ptr = fl_value_lookup_string(arguments, key);
+  return ptr == nullptr || fl_value_get_type(ptr) != FL_VALUE_TYPE_INT ? fallback : fl_value_get_int(ptr);
+}
+
+static gboolean sw_command_logger_get_bool(FlValue* arguments, const char* key) {
+  FlValue* ptr = fl_value_lookup_string(arguments, key);
+  return ptr != nullptr && fl_value_get_type(ptr) == FL_VALUE_TYPE_BOOL && fl_value_get_bool(ptr);
+}
+
+// |key| of |arguments| if it is a list of |type|, or nullptr
+static FlValue* sw_command_logger_get_list(FlValue* arguments, const char* key, FlValueType type) {
+  FlValue* ptr = fl_value_lookup_string(arguments, key);
+  return ptr != nullptr && fl_value_get_type(ptr) == type ? ptr : nullptr;
+}
+
+static SwCommand sw_command_logger_command(SwCommandOp op, int64_t texture) {
+  SwCommand command = {};
+  command.op = op;
+  command.texture = texture;
+  return command;
+}
+
+// Queue |command| for the writer. Only its encoding and payload are copied
+// on the calling thread.
+static void sw_command_logger_write(SwCommandLogger* logger, SwCommand* command) {
+  command->timestamp_us = g_get_monotonic_time() - logger->start;
+  uint8_t record[SW_COMMAND_LOG_RECORD_SIZE];
+  sw_command_log_encode(command, record);
+  g_mutex_lock(&logger->lock);
+  while (!logger->failed && logger->pending->len >= SW_COMMAND_LOGGER_MAX_BACKLOG) {
+    g_cond_wait(&logger->cond, &logger->lock);
+  }
+  if (!logger->failed) {
+    g_byte_array_append(logger->pending, record, sizeof(record));
+    if (command->payload_length > 0) {
+      g_byte_array_append(logger->pending, command->payload, command->payload_length);
+    }
+    if (logger->pending->len >= SW_COMMAND_LOGGER_CHUNK) {
+      g_cond_broadcast(&logger->cond);
+    }
+  }
+  g_mutex_unlock(&logger->lock);
+}
+
+// Writes whatever has been logged every SW_COMMAND_LOGGER_FLUSH_INTERVAL_US,
+// or as soon as a chunk's worth is waiting, and flushes it to the file
+static gpointer sw_command_logger_run(gpointer user_data) {
+  SwCommandLogger* logger = (SwCommandLogger*)user_data;
+  sw_trace_set_thread_name("sw_rend command log");
+  GByteArray* writing = g_byte_array_new();
+  g_mutex_lock(&logger->lock);
+  while (TRUE) {
+    gint64 deadline = g_get_monotonic_time() + SW_COMMAND_LOGGER_FLUSH_INTERVAL_US;
+    while (!logger->stopping && logger->pending->len < SW_COMMAND_LOGGER_CHUNK) {
+      if (!g_cond_wait_until(&logger->cond, &logger->lock, deadline)) {
+        break;
+      }
+    }
+    GByteArray* taken = logger->pending;
+    logger->pending = writing;
+    writing = taken;
+    gboolean stopping = logger->stopping;
+    // Let loggers waiting for room carry on
+    g_cond_broadcast(&logger->cond);
+    g_mutex_unlock(&logger->lock);
+    gboolean failed = FALSE;
+    if (writing->len > 0) {
+      SW_TRACE_SCOPE("sw_rend", "write_command_log");
+      failed = fwrite(writing->data, 1, writing->len, logger->file) != writing->len || fflush(logger->file) != 0;
+      if (failed) {
+        g_warning("Failed to write command log: %s", g_strerror(errno));
+      }
+      g_byte_array_set_size(writing, 0);
+    }
+    g_mutex_lock(&logger->lock);
+    if (failed) {
+      logger->failed = TRUE;
+      g_byte_array_set_size(logger->pending, 0);
+      g_cond_broadcast(&logger->cond);
+    }
+    if (stopping || logger->failed) {
+      break;
+    }
+  }
+  g_mutex_unlock(&logger->lock);
+  g_byte_array_unref(writing);
+  return nullptr;
+}
+
+static void sw_command_logger_log_init(SwCommandLogger* logger, FlValue* arguments, FlMethodResponse* response) {
+  if (response == nullptr || !FL_IS_METHOD_SUCCESS_RESPONSE(response)) {
+    return;
+  }
+  FlValue* result = fl_method_success_response_get_result(FL_METHOD_SUCCESS_RESPONSE(response));
+  SwCommand command = sw_command_logger_command(SW_COMMAND_INIT, fl_value_get_int(result));
+  command.width = (int32_t)sw_command_logger_get_int_or(arguments, "width", 0);
+  command.height = (int32_t)sw_command_logger_get_int_or(arguments, "height", 0);
+  if (sw_command_logger_get_bool(arguments, "tear_free")) {
+    command.flags |= SW_COMMAND_FLAG_TEAR_FREE;
+  }
+  sw_command_logger_write(logger, &command);
+}
+
+static void sw_command_logger_log_draw(SwCommandLogger* logger, FlValue* arguments, int64_t texture) {
+  SwCommand command = sw_command_logger_command(SW_COMMAND_DRAW, texture);
+  command.x = (int32_t)sw_command_logger_get_int_or(arguments, "x", 0);
+  command.y = (int32_t)sw_command_logger_get_int_or(arguments, "y", 0);
+  command.width = (int32_t)sw_command_logger_get_int_or(arguments, "width", -1);
+  command.height = (int32_t)sw_command_logger_get_int_or(arguments, "height", -1);
+  command.format = (uint8_t)sw_command_logger_get_int_or(arguments, "format", SW_PIXEL_FORMAT_RGBA8888);
+  command.blend = (uint8_t)sw_command_logger_get_int_or(arguments, "blend", 0);
+  command.encoding = (uint8_t)sw_command_logger_get_int_or(arguments, "encoding", 0);
+  FlValue* pixels = sw_command_logger_get_list(arguments, "pixels", FL_VALUE_TYPE_UINT8_LIST);
+  if (pixels == nullptr) {
+    command.flags |= SW_COMMAND_FLAG_IN_PLACE;
+  } else {
+    command.payload = fl_value_get_uint8_list(pixels);
+    command.payload_length = fl_value_get_length(pixels);
+  }
+  sw_command_logger_write(logger, &command);
+}
+
+static void sw_command_logger_log_draw_batch(SwCommandLogger* logger, FlValue* arguments) {
+  FlValue* records = sw_command_logger_get_list(arguments, "records", FL_VALUE_TYPE_INT64_LIST);
+  FlValue* pixels = sw_command_logger_get_list(arguments, "pixels", FL_VALUE_TYPE_UINT8_LIST);
+  if (records == nullptr || pixels == nullptr) {
+    return;
+  }
+  int64_t format = sw_command_logger_get_int_or(arguments, "format", SW_PIXEL_FORMAT_RGBA8888);
+  int bpp = sw_pixel_format_is_valid(format) ? sw_pixel_format_bytes_per_pixel((SwPixelFormat)format) : 4;
+  size_t pixels_length = fl_value_get_length(pixels);
+  size_t count = fl_value_get_length(records) / SW_BATCH_RECORD_SIZE;
+  GHashTable* touched = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (size_t i = 0; i < count; i++) {
+    const int64_t* record = fl_value_get_int64_list(records) + i * SW_BATCH_RECORD_SIZE;
+    SwCommand command = sw_command_logger_command(SW_COMMAND_DRAW, record[SW_BATCH_TEXTURE]);
+    command.x = (int32_t)record[SW_BATCH_X];
+    command.y = (int32_t)record[SW_BATCH_Y];
+    command.width = (int32_t)record[SW_BATCH_WIDTH];
+    command.height = (int32_t)record[SW_BATCH_HEIGHT];
+    command.format = (uint8_t)format;
+    command.blend = (uint8_t)sw_command_logger_get_int_or(arguments, "blend", 0);
+    int64_t offset = record[SW_BATCH_OFFSET];
+    int64_t width = record[SW_BATCH_WIDTH], height = record[SW_BATCH_HEIGHT];
+    if (offset >= 0 && (size_t)offset <= pixels_length && width > 0 && height > 0) {
+      // Records the plugin refuses for running past the pixels keep what
+      // there is, so the replay refuses them too
+      size_t available = pixels_length - offset;
+      command.payload = fl_value_get_uint8_list(pixels) + offset;
+      command.payload_length =
+          available / bpp / width < (size_t)height ? available : (size_t)width * (size_t)height * bpp;
+    }
+    sw_command_logger_write(logger, &command);
+    g_hash_table_add(touched, (gpointer)record[SW_BATCH_TEXTURE]);
+  }
+  if (sw_command_logger_get_bool(arguments, "invalidate")) {
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, touched);
+    while (g_hash_table_iter_next(&iter, &key, nullptr)) {
+      SwCommand command = sw_command_logger_command(SW_COMMAND_INVALIDATE, (int64_t)key);
+      sw_command_logger_write(logger, &command);
+    }
+  }
+  g_hash_table_destroy(touched);
+}
+
+// Every open logger, for writes that do not arrive as method calls. Read
+// without the lock to skip logging quickly while no log is open.
+static GMutex sw_command_logger_open_lock;
+static GSList* sw_command_logger_open = nullptr;
+
+void sw_command_logger_log_all(SwCommand* command) {
+  if (g_atomic_pointer_get(&sw_command_logger_open) == nullptr) {
+    return;
+  }
+  g_mutex_lock(&sw_command_logger_open_lock);
+  for (GSList* link = sw_command_logger_open; link != nullptr; link = link->next) {
+    sw_command_logger_write((SwCommandLogger*)link->data, command);
+  }
+  g_mutex_unlock(&sw_command_logger_open_lock);
+}
+
+void sw_command_logger_mark_unlogged_all(int64_t texture, const gchar* source) {
+  SwCommand command = sw_command_logger_command(SW_COMMAND_UNLOGGED, texture);
+  command.payload = (const uint8_t*)source;
+  command.payload_length = strlen(source);
+  sw_command_logger_log_all(&command);
+}
+
+// Methods that change a texture in ways the log has no record for
+static const gchar* const sw_command_logger_unlogged_methods[] = {
+  "blit", "blit_sprite", "blit_sprites", "set_tilemap", "set_tiles", "scroll_tilemap",
+};
+
+static gboolean sw_command_logger_is_unlogged(const gchar* method) {
+  for (const gchar* unlogged : sw_command_logger_unlogged_methods) {
+    if (strcmp(method, unlogged) == 0) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+SwCommandLogger* sw_command_logger_new(const gchar* path, GError** error) {
+  FILE* file = g_fopen(path, "wb");
+  if (file == nullptr) {
+    int saved_errno = errno;
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno), "Failed to create %s: %s", path,
+                g_strerror(saved_errno));
+    return nullptr;
+  }
+  SwCommandLogger* logger = g_new0(SwCommandLogger, 1);
+  logger->file = file;
+  logger->start = g_get_monotonic_time();
+  g_mutex_init(&logger->lock);
+  g_cond_init(&logger->cond);
+  logger->pending = g_byte_array_new();
+  logger->failed = !sw_command_log_write_header(file);
+  if (logger->failed) {
+    g_warning("Failed to write command log: %s", g_strerror(errno));
+  } else {
+    logger->thread = g_thread_new("sw_rend command log", sw_command_logger_run, logger);
+  }
+  g_mutex_lock(&sw_command_logger_open_lock);
+  g_atomic_pointer_set(&sw_command_logger_open, g_slist_prepend(sw_command_logger_open, logger));
+  g_mutex_unlock(&sw_command_logger_open_lock);
+  return logger;
+}
+
+void sw_command_logger_log(SwCommandLogger* logger, const gchar* method, FlValue* arguments,
+                           FlMethodResponse* response) {
+  if (arguments == nullptr || fl_value_get_type(arguments) != FL_VALUE_TYPE_MAP) {
+    return;
+  }
+  if (strcmp(method, "init") == 0) {
+    sw_command_logger_log_init(logger, arguments, response);
+  } else if (strcmp(method, "draw_batch") == 0) {
+    sw_command_logger_log_draw_batch(logger, arguments);
+  } else {
+    int64_t texture = sw_command_logger_get_int_or(arguments, "texture", 0);
+    if (strcmp(method, "dispose") == 0) {
+      SwCommand command = sw_command_logger_command(SW_COMMAND_DISPOSE, texture);
+      sw_command_logger_write(logger, &command);
+    } else if (strcmp(method, "resize") == 0) {
+      SwCommand command = sw_command_logger_command(SW_COMMAND_RESIZE, texture);
+      command.width = (int32_t)sw_command_logger_get_int_or(arguments, "width", 0);
+      command.height = (int32_t)sw_command_logger_get_int_or(arguments, "height", 0);
+      command.anchor = (uint8_t)sw_command_logger_get_int_or(arguments, "anchor", 0);
+      sw_command_logger_write(logger, &command);
+    } else if (strcmp(method, "draw") == 0) {
+      sw_command_logger_log_draw(logger, arguments, texture);
+    } else if (strcmp(method, "raster") == 0) {
+      FlValue* commands = sw_command_logger_get_list(arguments, "commands", FL_VALUE_TYPE_INT32_LIST);
+      if (commands == nullptr) {
+        return;
+      }
+      // Int32 lists arrive in host order, which is little-endian on every
+      // platform Flutter supports
+      SwCommand command = sw_command_logger_command(SW_COMMAND_RASTER, texture);
+      command.payload = (const uint8_t*)fl_value_get_int32_list(commands);
+      command.payload_length = sizeof(int32_t) * fl_value_get_length(commands);
+      sw_command_logger_write(logger, &command);
+      if (sw_command_logger_get_bool(arguments, "invalidate")) {
+        command = sw_command_logger_command(SW_COMMAND_INVALIDATE, texture);
+        sw_command_logger_write(logger, &command);
+      }
+    } else if (strcmp(method, "invalidate") == 0) {
+      SwCommand command = sw_command_logger_command(SW_COMMAND_INVALIDATE, texture);
+      sw_command_logger_write(logger, &command);
+    } else if (sw_command_logger_is_unlogged(method)) {
+      // Mark where the replay stops matching, and redraw the texture if the
+      // call would have
+      SwCommand command = sw_command_logger_command(SW_COMMAND_UNLOGGED, texture);
+      command.payload = (const uint8_t*)method;
+      command.payload_length = strlen(method);
+      sw_command_logger_write(logger, &command);
+      if (sw_command_logger_get_bool(arguments, "invalidate")) {
+        command = sw_command_logger_command(SW_COMMAND_INVALIDATE, texture);
+        sw_command_logger_write(logger, &command);
+      }
+    } else {
+      return;
+    }
+  }
+}
+
+void sw_command_logger_free(SwCommandLogger* logger) {
+  g_mutex_lock(&sw_command_logger_open_lock);
+  g_atomic_pointer_set(&sw_command_logger_open, g_slist_remove(sw_command_logger_open, logger));
+  g_mutex_unlock(&sw_command_logger_open_lock);
+  if (logger->thread != nullptr) {
+    g_mutex_lock(&logger->lock);
+    logger->stopping = TRUE;
+    g_cond_broadcast(&logger->cond);
+    g_mutex_unlock(&logger->lock);
+    g_thread_join(logger->thread);
+  }
+  fclose(logger->file);
+  g_byte_array_unref(logger->pending);
+  g_cond_clear(&logger->cond);
+  g_mutex_clear(&logger->lock);
+  g_free(logger);
+}
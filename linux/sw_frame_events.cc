@@ -0,0 +1,82 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_frame_events.h"
+
+#include <cstdint>
+#include <flutter_linux/flutter_linux.h>
+#include <gtk/gtk.h>
+
+typedef struct {
+  FlEventChannel* channel;
+  gboolean listening;
+} SwFrameEvents;
+
+// SwFrameEvents by the registrar whose textures they report. Only touched on
+// the platform thread.
+static GHashTable* frame_events = nullptr;
+
+static void sw_frame_events_free(gpointer data) {
+  SwFrameEvents* events = (SwFrameEvents*)data;
+  fl_event_channel_set_stream_handlers(events->channel, nullptr, nullptr, nullptr, nullptr);
+  g_object_unref(events->channel);
+  g_free(events);
+}
+
+static FlMethodErrorResponse* sw_frame_events_listen_cb(FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ((SwFrameEvents*)user_data)->listening = TRUE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* sw_frame_events_cancel_cb(FlEventChannel* channel, FlValue* args, gpointer user_data) {
+  ((SwFrameEvents*)user_data)->listening = FALSE;
+  return nullptr;
+}
+
+void sw_frame_events_register(FlBinaryMessenger* messenger, FlTextureRegistrar* registrar) {
+  if (frame_events == nullptr) {
+    frame_events = g_hash_table_new_full(g_direct_hash, g_direct_equal, nullptr, sw_frame_events_free);
+  }
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  SwFrameEvents* events = g_new(SwFrameEvents, 1);
+  events->channel = fl_event_channel_new(messenger, SW_FRAME_EVENTS_CHANNEL_NAME, FL_METHOD_CODEC(codec));
+  events->listening = FALSE;
+  fl_event_channel_set_stream_handlers(events->channel, sw_frame_events_listen_cb, sw_frame_events_cancel_cb,
+                                       events, nullptr);
+  g_hash_table_insert(frame_events, registrar, events);
+}
+
+void sw_frame_events_unregister(FlTextureRegistrar* registrar) {
+  if (frame_events != nullptr) {
+    g_hash_table_remove(frame_events, registrar);
+  }
+}
+
+void sw_frame_events_send(FlTextureRegistrar* registrar, int64_t texture, int64_t frame, int64_t time) {
+  if (frame_events == nullptr) {
+    return;
+  }
+  SwFrameEvents* events = (SwFrameEvents*)g_hash_table_lookup(frame_events, registrar);
+  if (events == nullptr || !events->listening) {
+    return;
+  }
+  int64_t event[3] = {texture, frame, time};
+  g_autoptr(FlValue) value = fl_value_new_int64_list(event, 3);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_event_channel_send(events->channel, value, nullptr, &error)) {
+    g_warning("Failed to send frame event: %s", error->message);
+  }
+}
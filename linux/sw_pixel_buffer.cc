@@ -15,8 +15,15 @@ limitations under the License.
  */
 
 #include "include/sw_rend/sw_pixel_buffer.h"
+#include "include/sw_rend/sw_frame_events.h"
+#include "include/sw_rend/sw_pixel_pool.h"
+#include "sw_damage.h"
+#include "sw_raster.h"
+#include "sw_surface.h"
+#include "sw_trace.h"
 
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
@@ -28,28 +35,173 @@ limitations under the License.
   (G_TYPE_CHECK_INSTANCE_CAST((obj), sw_pixel_buffer_get_type(), \
                               SwPixelBuffer))
 
+// Set on SwPixelBuffer::pending while the slot it names has not been read
+#define SW_SLOT_FRESH 0x100
+#define SW_SLOT_MASK 0xff
+
 G_DEFINE_TYPE(SwPixelBuffer, sw_pixel_buffer, fl_pixel_buffer_texture_get_type())
 
+// Registered buffers by ID, shared by every plugin instance
+static GHashTable* registered = nullptr;
+G_LOCK_DEFINE_STATIC(registered);
+
+// Counters of buffers since finalized
+static SwPixelBufferStats finalized_stats = {};
+G_LOCK_DEFINE_STATIC(finalized_stats);
+
+static gint sw_atomic_int_exchange(volatile gint* atomic, gint value) {
+  gint old;
+  do {
+    old = g_atomic_int_get(atomic);
+  } while (!g_atomic_int_compare_and_exchange(atomic, old, value));
+  return old;
+}
+
+// Queue |func| to run on the platform thread, whichever thread this is
+// called from. g_main_context_invoke would instead run it right away on any
+// thread that manages to acquire the default context.
+static void sw_pixel_buffer_post(GSourceFunc func, gpointer user_data, GDestroyNotify notify) {
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(source, func, user_data, notify);
+  g_source_attach(source, g_main_context_default());
+  g_source_unref(source);
+}
+
+// A frame taken by the engine, on its way to the platform thread
+typedef struct {
+  SwPixelBuffer* buffer;
+  int64_t frame;
+  int64_t time;
+} SwConsumedFrame;
+
+static gboolean sw_pixel_buffer_frame_consumed_cb(gpointer user_data) {
+  SwConsumedFrame* consumed = (SwConsumedFrame*)user_data;
+  SwPixelBuffer* buffer = consumed->buffer;
+  if (buffer->registrar != nullptr) {
+    sw_frame_events_send(buffer->registrar, sw_pixel_buffer_get_id(buffer), consumed->frame, consumed->time);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static void sw_pixel_buffer_free_consumed_frame(gpointer user_data) {
+  SwConsumedFrame* consumed = (SwConsumedFrame*)user_data;
+  g_object_unref(consumed->buffer);
+  g_free(consumed);
+}
+
+// A store replaced by a resize
+typedef struct {
+  uint8_t* store;
+  size_t size;
+} SwRetiredStore;
+
+static void sw_pixel_buffer_free_stores(GSList** stores) {
+  for (GSList* link = *stores; link != nullptr; link = link->next) {
+    SwRetiredStore* retired = (SwRetiredStore*)link->data;
+    sw_pixel_pool_free(retired->store, retired->size);
+    g_free(retired);
+  }
+  g_slist_free(*stores);
+  *stores = nullptr;
+}
+
+static void sw_pixel_buffer_free_retired(SwPixelBuffer* buffer) {
+  sw_pixel_buffer_free_stores(&buffer->retired);
+}
+
+static void sw_pixel_buffer_retire_to(GSList** stores, uint8_t* store, size_t size) {
+  SwRetiredStore* retired = g_new(SwRetiredStore, 1);
+  retired->store = store;
+  retired->size = size;
+  *stores = g_slist_prepend(*stores, retired);
+}
+
+static void sw_pixel_buffer_retire(SwPixelBuffer* buffer, uint8_t* store, size_t size) {
+  sw_pixel_buffer_retire_to(&buffer->retired, store, size);
+}
+
 static gboolean sw_pixel_buffer_copy_pixels(FlPixelBufferTexture* texture, const uint8_t** dst, uint32_t* width, uint32_t *height, GError** error) {
+  SW_TRACE_SCOPE("sw_rend", "copy_pixels");
   SwPixelBuffer* buffer = SW_PIXEL_BUFFER(texture);
-  *dst = buffer->buffer;
+  g_mutex_lock(&buffer->frame_lock);
+  // The engine is done with whatever it was handed last time
+  sw_pixel_buffer_free_retired(buffer);
+  // From here on the engine needs telling about anything invalidated. This
+  // comes before taking the pending frame, so that a frame presented after
+  // it is either taken now or marked available by its own invalidation.
+  g_atomic_int_set(&buffer->frame_pending, 0);
+  if (buffer->mode == SW_PIXEL_BUFFER_MAILBOX) {
+    // The engine is done with the previous front slot by the time it asks
+    // again, so trade it for the newest frame if one has been presented
+    if (g_atomic_int_get(&buffer->pending) & SW_SLOT_FRESH) {
+      buffer->front = sw_atomic_int_exchange(&buffer->pending, buffer->front) & SW_SLOT_MASK;
+    }
+    *dst = buffer->slots[buffer->front];
+  } else {
+    *dst = buffer->buffer;
+  }
   *width = buffer->width;
   *height = buffer->height;
+  buffer->stats.copy_pixels_calls++;
+  g_mutex_unlock(&buffer->frame_lock);
+  SwConsumedFrame* consumed = g_new(SwConsumedFrame, 1);
+  consumed->buffer = SW_PIXEL_BUFFER(g_object_ref(buffer));
+  consumed->frame = ++buffer->frames_consumed;
+  consumed->time = g_get_monotonic_time();
+  sw_pixel_buffer_post(sw_pixel_buffer_frame_consumed_cb, consumed, sw_pixel_buffer_free_consumed_frame);
   return TRUE;
 }
 
 static void _sw_pixel_buffer_dispose(GObject* object) {
   SwPixelBuffer* buffer = SW_PIXEL_BUFFER(object);
   g_print("Disposing of SwPixelBuffer at %p\n", buffer);
+  size_t size = 4 * buffer->width * buffer->height;
   if (buffer->buffer != nullptr) {
-    g_free(buffer->buffer);
+    sw_pixel_pool_free(buffer->buffer, size);
     buffer->buffer = nullptr;
   }
+  for (int i = 0; i < SW_PIXEL_BUFFER_SLOTS; i++) {
+    sw_pixel_pool_free(buffer->slots[i], size);
+    buffer->slots[i] = nullptr;
+  }
+  sw_pixel_buffer_free_retired(buffer);
+  sw_pixel_buffer_free_stores(&buffer->shared_retired);
+  sw_pixel_buffer_stop_recording(buffer, nullptr);
+  if (buffer->tilemap != nullptr) {
+    sw_tilemap_free(buffer->tilemap);
+    buffer->tilemap = nullptr;
+  }
+  if (buffer->workers != nullptr) {
+    sw_worker_pool_unref(buffer->workers);
+    buffer->workers = nullptr;
+  }
   G_OBJECT_CLASS(sw_pixel_buffer_parent_class)->dispose(object);
 }
 
+static void sw_pixel_buffer_stats_add(SwPixelBufferStats* total, const SwPixelBufferStats* stats) {
+  total->draw_calls += stats->draw_calls;
+  total->bytes_ingested += stats->bytes_ingested;
+  total->draw_time_us += stats->draw_time_us;
+  total->bytes_copied += stats->bytes_copied;
+  total->invalidations += stats->invalidations;
+  total->frames_dropped += stats->frames_dropped;
+  total->copy_pixels_calls += stats->copy_pixels_calls;
+}
+
+static void _sw_pixel_buffer_finalize(GObject* object) {
+  SwPixelBuffer* buffer = SW_PIXEL_BUFFER(object);
+  G_LOCK(finalized_stats);
+  sw_pixel_buffer_stats_add(&finalized_stats, &buffer->stats);
+  G_UNLOCK(finalized_stats);
+  g_mutex_clear(&buffer->lock);
+  g_mutex_clear(&buffer->frame_lock);
+  G_OBJECT_CLASS(sw_pixel_buffer_parent_class)->finalize(object);
+}
+
 static void sw_pixel_buffer_class_init(SwPixelBufferClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = _sw_pixel_buffer_dispose;
+  G_OBJECT_CLASS(klass)->finalize = _sw_pixel_buffer_finalize;
   klass->parent_class.copy_pixels = sw_pixel_buffer_copy_pixels;
 }
 
@@ -57,13 +209,56 @@ static void sw_pixel_buffer_init(SwPixelBuffer* buffer) {
   buffer->width = -1;
   buffer->height = -1;
   buffer->buffer = nullptr;
+  buffer->mode = SW_PIXEL_BUFFER_DIRECT;
+  for (int i = 0; i < SW_PIXEL_BUFFER_SLOTS; i++) {
+    buffer->slots[i] = nullptr;
+    sw_damage_clear(&buffer->slot_damage[i]);
+  }
+  buffer->back = 0;
+  buffer->pending = 1;
+  buffer->front = 2;
+  buffer->registrar = nullptr;
+  sw_damage_clear(&buffer->damage);
+  buffer->last_frame_damage_area = 0;
+  buffer->total_damage_area = 0;
+  buffer->frames_presented = 0;
+  buffer->frame_pending = 0;
+  buffer->frames_consumed = 0;
+  buffer->shared = FALSE;
+  buffer->workers = nullptr;
+  g_mutex_init(&buffer->lock);
+  g_mutex_init(&buffer->frame_lock);
+  buffer->retired = nullptr;
+  buffer->shared_retired = nullptr;
+  buffer->tilemap = nullptr;
+}
+
+// Allocate new |width| x |height| mailbox slots. The engine may be handed
+// the front slot before anything is presented, so it starts as a copy of
+// |content|; the others are filled from |buffer| when first presented.
+static void sw_pixel_buffer_alloc_slots(SwPixelBuffer* buffer, const uint8_t* content, int64_t width, int64_t height) {
+  size_t size = 4 * width * height;
+  for (int i = 0; i < SW_PIXEL_BUFFER_SLOTS; i++) {
+    buffer->slots[i] = sw_pixel_pool_alloc(size, FALSE);
+    sw_damage_clear(&buffer->slot_damage[i]);
+    if (i == buffer->front) {
+      memcpy(buffer->slots[i], content, size);
+    } else {
+      sw_damage_add(&buffer->slot_damage[i], {0, 0, width, height});
+    }
+  }
 }
 
-SwPixelBuffer* sw_pixel_buffer_new(int64_t width, int64_t height) {
+SwPixelBuffer* sw_pixel_buffer_new(int64_t width, int64_t height, SwPixelBufferMode mode, SwWorkerPool* workers) {
   SwPixelBuffer* buffer = SW_PIXEL_BUFFER(g_object_new(sw_pixel_buffer_get_type(), nullptr));
   buffer->width = width;
   buffer->height = height;
-  buffer->buffer = g_new0(uint8_t, width * height * 4);
+  buffer->mode = mode;
+  buffer->workers = workers != nullptr ? sw_worker_pool_ref(workers) : nullptr;
+  buffer->buffer = sw_pixel_pool_alloc(width * height * 4, TRUE);
+  if (mode == SW_PIXEL_BUFFER_MAILBOX) {
+    sw_pixel_buffer_alloc_slots(buffer, buffer->buffer, width, height);
+  }
   return buffer;
 }
 
@@ -71,12 +266,482 @@ void sw_pixel_buffer_dispose(SwPixelBuffer* buffer) {
   g_object_unref(buffer);
 }
 
-void sw_pixel_buffer_draw_rect(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t x, int64_t y, int64_t width, int64_t height) {
-  int64_t num_rows = MIN(height, buffer->height - y);
-  int64_t num_cols = MIN(width, buffer->width - x);
-  for (int dy = 0; dy < num_rows; dy++) {
-    uint8_t* dst = buffer->buffer + 4 * ((y + dy) * buffer->width + x);
-    const uint8_t* src = pixels + 4 * (dy * width);
-    memcpy(dst, src, 4 * num_cols);
+// The canonical store as a surface, only valid under |lock|
+static SwSurface sw_pixel_buffer_surface(SwPixelBuffer* buffer) {
+  return {buffer->buffer, buffer->width, buffer->height};
+}
+
+static SwRect sw_pixel_buffer_clip(SwPixelBuffer* buffer, int64_t x, int64_t y, int64_t width, int64_t height) {
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  return sw_surface_clip(&surface, {x, y, width, height});
+}
+
+// Count a draw of |bytes| of input that started at |start|, under |lock|
+static void sw_pixel_buffer_count_draw(SwPixelBuffer* buffer, int64_t bytes, gint64 start) {
+  buffer->stats.draw_calls++;
+  buffer->stats.bytes_ingested += bytes;
+  buffer->stats.draw_time_us += g_get_monotonic_time() - start;
+}
+
+void sw_pixel_buffer_draw_rect(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t x, int64_t y, int64_t width, int64_t height,
+                               SwPixelFormat format, SwBlendMode blend) {
+  SW_TRACE_SCOPE("sw_rend", "draw_rect");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  sw_damage_add(&buffer->damage,
+                sw_surface_draw_rect(&surface, pixels, x, y, width, height, format, blend, buffer->workers));
+  sw_pixel_buffer_count_draw(buffer, MAX(width, 0) * MAX(height, 0) * sw_pixel_format_bytes_per_pixel(format), start);
+  g_mutex_unlock(&buffer->lock);
+}
+
+gboolean sw_pixel_buffer_decode_rect(SwPixelBuffer* buffer, const uint8_t* data, size_t length,
+                                     int64_t x, int64_t y, int64_t width, int64_t height, SwEncoding encoding) {
+  if (width < 0 || height < 0) {
+    return FALSE;
+  }
+  if (encoding == SW_ENCODING_RAW) {
+    if (length / 4 / MAX(width, 1) < (size_t)height) {
+      return FALSE;
+    }
+    sw_pixel_buffer_draw_rect(buffer, data, x, y, width, height);
+    return TRUE;
+  }
+  if (!sw_rle_validate(data, length, width * height)) {
+    return FALSE;
+  }
+  if (width == 0 || height == 0) {
+    return TRUE;
+  }
+  SW_TRACE_SCOPE("sw_rend", "decode_rect");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  SwRect rect = {x, y, width, height};
+  SwRect clip = sw_pixel_buffer_clip(buffer, x, y, width, height);
+  if (clip.x != rect.x || clip.y != rect.y || clip.width != rect.width || clip.height != rect.height) {
+    g_mutex_unlock(&buffer->lock);
+    return FALSE;
+  }
+  SwRect changed = sw_rle_decode(buffer->buffer + 4 * (y * buffer->width + x), 4 * buffer->width, width, height,
+                                 data, length, encoding == SW_ENCODING_XOR_RLE);
+  sw_damage_add(&buffer->damage, {x + changed.x, y + changed.y, changed.width, changed.height});
+  sw_pixel_buffer_count_draw(buffer, length, start);
+  g_mutex_unlock(&buffer->lock);
+  return TRUE;
+}
+
+void sw_pixel_buffer_blit_scaled(SwPixelBuffer* buffer, const uint8_t* pixels, int64_t src_stride,
+                                 int64_t src_width, int64_t src_height,
+                                 int64_t x, int64_t y, int64_t width, int64_t height, SwScaleFilter filter) {
+  SW_TRACE_SCOPE("sw_rend", "blit_scaled");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  sw_damage_add(&buffer->damage, sw_surface_blit_scaled(&surface, pixels, src_stride, src_width, src_height,
+                                                        x, y, width, height, filter, buffer->workers));
+  sw_pixel_buffer_count_draw(buffer, MAX(src_stride, 0) * MAX(src_height, 0), start);
+  g_mutex_unlock(&buffer->lock);
+}
+
+gboolean sw_pixel_buffer_blit_from(SwPixelBuffer* buffer, SwPixelBuffer* source,
+                                   int64_t src_x, int64_t src_y, int64_t src_width, int64_t src_height,
+                                   int64_t x, int64_t y, int64_t width, int64_t height, SwScaleFilter filter) {
+  // Snapshot the source so that only one buffer is locked at a time, which
+  // also makes blits within a buffer safe. The source is usually the small side.
+  // The rect is checked before allocating for it, so a bogus one is refused
+  // rather than running out of memory
+  uint8_t* pixels = nullptr;
+  g_mutex_lock(&source->lock);
+  if (src_x >= 0 && src_y >= 0 && src_width >= 0 && src_height >= 0 && src_x <= source->width - src_width &&
+      src_y <= source->height - src_height) {
+    SwSurface surface = sw_pixel_buffer_surface(source);
+    pixels = (uint8_t*)g_malloc(MAX(4 * src_width * src_height, 1));
+    sw_surface_read_rect(&surface, pixels, src_x, src_y, src_width, src_height);
+  }
+  g_mutex_unlock(&source->lock);
+  if (pixels == nullptr) {
+    return FALSE;
+  }
+  sw_pixel_buffer_blit_scaled(buffer, pixels, 4 * src_width, src_width, src_height, x, y, width, height, filter);
+  g_free(pixels);
+  return TRUE;
+}
+
+gboolean sw_pixel_buffer_blit_sprite(SwPixelBuffer* buffer, SwSpriteCache* sprites, int64_t id,
+                                     int64_t x, int64_t y, uint8_t alpha, SwBlendMode blend) {
+  SW_TRACE_SCOPE("sw_rend", "blit_sprite");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  SwRect drawn;
+  gboolean hit = sw_sprite_cache_draw(sprites, id, &surface, x, y, alpha, blend, &drawn, buffer->workers);
+  if (hit) {
+    sw_damage_add(&buffer->damage, drawn);
+    // Only the ID and position came in
+    sw_pixel_buffer_count_draw(buffer, 0, start);
+  }
+  g_mutex_unlock(&buffer->lock);
+  return hit;
+}
+
+gboolean sw_pixel_buffer_read_rect(SwPixelBuffer* buffer, uint8_t* dst, int64_t x, int64_t y, int64_t width, int64_t height) {
+  g_mutex_lock(&buffer->lock);
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  gboolean read = sw_surface_read_rect(&surface, dst, x, y, width, height);
+  g_mutex_unlock(&buffer->lock);
+  return read;
+}
+
+// Lay out the |width| x |height| image in |src| on a new |new_width| x
+// |new_height| store, shifted by (|dx|, |dy|), clearing everything else
+static uint8_t* sw_pixel_buffer_relayout(const uint8_t* src, int64_t width, int64_t height,
+                                         int64_t new_width, int64_t new_height, int64_t dx, int64_t dy) {
+  SwSurface from = {(uint8_t*)src, width, height};
+  SwSurface to = {sw_pixel_pool_alloc(4 * new_width * new_height, FALSE), new_width, new_height};
+  sw_surface_relayout(&to, &from, dx, dy);
+  return to.pixels;
+}
+
+void sw_pixel_buffer_resize(SwPixelBuffer* buffer, int64_t width, int64_t height, SwResizeAnchor anchor) {
+  SW_TRACE_SCOPE("sw_rend", "resize");
+  g_mutex_lock(&buffer->lock);
+  if (width == buffer->width && height == buffer->height && anchor != SW_RESIZE_CLEAR) {
+    g_mutex_unlock(&buffer->lock);
+    return;
+  }
+  int64_t dx = 0, dy = 0;
+  if (anchor == SW_RESIZE_CENTER) {
+    dx = (width - buffer->width) / 2;
+    dy = (height - buffer->height) / 2;
+  }
+  uint8_t* store = anchor == SW_RESIZE_CLEAR
+                       ? sw_pixel_pool_alloc(4 * width * height, TRUE)
+                       : sw_pixel_buffer_relayout(buffer->buffer, buffer->width, buffer->height, width, height, dx, dy);
+  size_t old_size = 4 * buffer->width * buffer->height;
+  size_t size = 4 * width * height;
+  if (anchor != SW_RESIZE_CLEAR) {
+    buffer->stats.bytes_copied += size;
+  }
+
+  g_mutex_lock(&buffer->frame_lock);
+  // The engine may be reading the store it was handed last, which is
+  // |buffer| or the front slot, until it asks for another frame
+  if (buffer->shared) {
+    // The app may still write through the old address until it asks again
+    sw_pixel_buffer_retire_to(&buffer->shared_retired, buffer->buffer, old_size);
+  } else if (buffer->mode == SW_PIXEL_BUFFER_MAILBOX) {
+    sw_pixel_pool_free(buffer->buffer, old_size);
+  } else {
+    sw_pixel_buffer_retire(buffer, buffer->buffer, old_size);
+  }
+  if (buffer->mode == SW_PIXEL_BUFFER_MAILBOX) {
+    for (int i = 0; i < SW_PIXEL_BUFFER_SLOTS; i++) {
+      if (i == buffer->front) {
+        sw_pixel_buffer_retire(buffer, buffer->slots[i], old_size);
+      } else {
+        sw_pixel_pool_free(buffer->slots[i], old_size);
+      }
+    }
+    // Whatever was pending no longer matches the new size, and the front
+    // slot shows the resized content until the next present
+    g_atomic_int_set(&buffer->pending, g_atomic_int_get(&buffer->pending) & SW_SLOT_MASK);
+    sw_pixel_buffer_alloc_slots(buffer, store, width, height);
+    buffer->stats.bytes_copied += size;
+  }
+  buffer->buffer = store;
+  buffer->width = width;
+  buffer->height = height;
+  g_mutex_unlock(&buffer->frame_lock);
+
+  sw_damage_clear(&buffer->damage);
+  sw_damage_add(&buffer->damage, {0, 0, width, height});
+  if (buffer->tilemap != nullptr) {
+    SwSurface surface = sw_pixel_buffer_surface(buffer);
+    sw_tilemap_render(buffer->tilemap, &surface, {0, 0, width, height}, &buffer->damage, buffer->workers);
+  }
+  buffer->record_key = TRUE;
+  g_mutex_unlock(&buffer->lock);
+}
+
+void sw_pixel_buffer_set_tilemap(SwPixelBuffer* buffer, SwTilemap* tilemap) {
+  SW_TRACE_SCOPE("sw_rend", "set_tilemap");
+  g_mutex_lock(&buffer->lock);
+  if (buffer->tilemap != nullptr) {
+    sw_tilemap_free(buffer->tilemap);
+  }
+  buffer->tilemap = tilemap;
+  if (tilemap != nullptr) {
+    gint64 start = g_get_monotonic_time();
+    SwSurface surface = sw_pixel_buffer_surface(buffer);
+    sw_tilemap_render(tilemap, &surface, {0, 0, buffer->width, buffer->height}, &buffer->damage, buffer->workers);
+    sw_pixel_buffer_count_draw(buffer, 0, start);
+  }
+  g_mutex_unlock(&buffer->lock);
+}
+
+gboolean sw_pixel_buffer_set_tiles(SwPixelBuffer* buffer, int64_t column, int64_t row, int64_t width, int64_t height,
+                                   const int32_t* tiles) {
+  SW_TRACE_SCOPE("sw_rend", "set_tiles");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  gboolean set = buffer->tilemap != nullptr &&
+                 sw_tilemap_set_tiles(buffer->tilemap, &surface, column, row, width, height, tiles, &buffer->damage,
+                                      buffer->workers);
+  if (set) {
+    sw_pixel_buffer_count_draw(buffer, sizeof(int32_t) * width * height, start);
+  }
+  g_mutex_unlock(&buffer->lock);
+  return set;
+}
+
+gboolean sw_pixel_buffer_scroll_tilemap(SwPixelBuffer* buffer, int64_t x, int64_t y) {
+  SW_TRACE_SCOPE("sw_rend", "scroll_tilemap");
+  g_mutex_lock(&buffer->lock);
+  if (buffer->tilemap == nullptr) {
+    g_mutex_unlock(&buffer->lock);
+    return FALSE;
+  }
+  gint64 start = g_get_monotonic_time();
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  sw_tilemap_scroll(buffer->tilemap, &surface, x, y, &buffer->damage, buffer->workers);
+  // Only the offset came in
+  sw_pixel_buffer_count_draw(buffer, 0, start);
+  g_mutex_unlock(&buffer->lock);
+  return TRUE;
+}
+
+void sw_pixel_buffer_raster(SwPixelBuffer* buffer, const int32_t* commands, size_t length) {
+  SW_TRACE_SCOPE("sw_rend", "raster");
+  g_mutex_lock(&buffer->lock);
+  gint64 start = g_get_monotonic_time();
+  sw_raster_execute(buffer->buffer, buffer->width, buffer->height, commands, length, &buffer->damage, buffer->workers);
+  sw_pixel_buffer_count_draw(buffer, sizeof(int32_t) * length, start);
+  g_mutex_unlock(&buffer->lock);
+}
+
+uint8_t* sw_pixel_buffer_share(SwPixelBuffer* buffer) {
+  g_mutex_lock(&buffer->lock);
+  buffer->shared = TRUE;
+  // The app has let go of any address from before a resize, but in direct
+  // mode the engine may still be reading the store, so leave it to the
+  // next frame to free
+  if (buffer->shared_retired != nullptr) {
+    g_mutex_lock(&buffer->frame_lock);
+    buffer->retired = g_slist_concat(buffer->shared_retired, buffer->retired);
+    g_mutex_unlock(&buffer->frame_lock);
+    buffer->shared_retired = nullptr;
+  }
+  uint8_t* pixels = buffer->buffer;
+  g_mutex_unlock(&buffer->lock);
+  return pixels;
+}
+
+void sw_pixel_buffer_damage(SwPixelBuffer* buffer, int64_t x, int64_t y, int64_t width, int64_t height) {
+  g_mutex_lock(&buffer->lock);
+  sw_damage_add(&buffer->damage, sw_pixel_buffer_clip(buffer, x, y, width, height));
+  g_mutex_unlock(&buffer->lock);
+}
+
+static void sw_pixel_buffer_copy_damage(SwPixelBuffer* buffer, uint8_t* dst, const SwDamage* damage) {
+  SwSurface from = sw_pixel_buffer_surface(buffer);
+  SwSurface to = {dst, buffer->width, buffer->height};
+  for (int i = 0; i < damage->count; i++) {
+    sw_surface_copy_rect(&to, &from, damage->rects[i], buffer->workers);
+  }
+  buffer->stats.bytes_copied += 4 * sw_damage_area(damage);
+}
+
+// Hand the recorder a copy of what changed in the frame being presented
+static void sw_pixel_buffer_record_locked(SwPixelBuffer* buffer) {
+  SwCaptureFrame* frame = g_new(SwCaptureFrame, 1);
+  frame->timestamp_us = g_get_monotonic_time();
+  frame->width = buffer->width;
+  frame->height = buffer->height;
+  frame->key = buffer->record_key;
+  frame->damage = buffer->damage;
+  if (frame->key) {
+    sw_damage_clear(&frame->damage);
+    sw_damage_add(&frame->damage, {0, 0, buffer->width, buffer->height});
+  }
+  int64_t size = 4 * sw_damage_area(&frame->damage);
+  if (!sw_recorder_reserve(buffer->recorder, size)) {
+    // What this frame changed is lost, so the next one has to start over
+    buffer->record_key = TRUE;
+    g_free(frame);
+    return;
+  }
+  frame->pixels = (uint8_t*)g_malloc(MAX(size, 1));
+  SwSurface surface = sw_pixel_buffer_surface(buffer);
+  sw_capture_read_damage(&surface, &frame->damage, frame->pixels);
+  buffer->record_key = FALSE;
+  sw_recorder_push(buffer->recorder, frame);
+}
+
+static void sw_pixel_buffer_present_locked(SwPixelBuffer* buffer) {
+  if (buffer->shared && buffer->damage.count == 0) {
+    sw_damage_add(&buffer->damage, {0, 0, buffer->width, buffer->height});
+  }
+  if (buffer->recorder != nullptr) {
+    sw_pixel_buffer_record_locked(buffer);
+  }
+  buffer->last_frame_damage_area = sw_damage_area(&buffer->damage);
+  buffer->total_damage_area += buffer->last_frame_damage_area;
+  buffer->frames_presented++;
+  if (buffer->mode == SW_PIXEL_BUFFER_MAILBOX) {
+    // Bring the back slot up to date with everything drawn since it last
+    // held a frame, which for a recycled slot spans more than this frame
+    for (int i = 0; i < SW_PIXEL_BUFFER_SLOTS; i++) {
+      sw_damage_add_damage(&buffer->slot_damage[i], &buffer->damage);
+    }
+    sw_pixel_buffer_copy_damage(buffer, buffer->slots[buffer->back], &buffer->slot_damage[buffer->back]);
+    sw_damage_clear(&buffer->slot_damage[buffer->back]);
+    // Whatever was pending is recycled as the next back slot; if the raster
+    // thread never picked it up, that frame is simply dropped
+    buffer->back = sw_atomic_int_exchange(&buffer->pending, buffer->back | SW_SLOT_FRESH) & SW_SLOT_MASK;
+  }
+  sw_damage_clear(&buffer->damage);
+}
+
+void sw_pixel_buffer_present(SwPixelBuffer* buffer) {
+  g_mutex_lock(&buffer->lock);
+  sw_pixel_buffer_present_locked(buffer);
+  g_mutex_unlock(&buffer->lock);
+}
+
+static gboolean sw_pixel_buffer_mark_frame_available_cb(gpointer user_data) {
+  SwPixelBuffer* buffer = SW_PIXEL_BUFFER(user_data);
+  // The texture may have been unregistered while this was queued
+  if (buffer->registrar != nullptr) {
+    fl_texture_registrar_mark_texture_frame_available(buffer->registrar, FL_TEXTURE(buffer));
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void sw_pixel_buffer_invalidate(SwPixelBuffer* buffer) {
+  SW_TRACE_SCOPE("sw_rend", "invalidate");
+  g_mutex_lock(&buffer->lock);
+  sw_pixel_buffer_present_locked(buffer);
+  // The engine has yet to take the frame it was last told about, and will
+  // read this one when it does. A texture the engine never draws therefore
+  // stops being marked until it is drawn.
+  gboolean notify = g_atomic_int_compare_and_exchange(&buffer->frame_pending, 0, 1);
+  buffer->stats.invalidations++;
+  if (!notify) {
+    buffer->stats.frames_dropped++;
+  }
+  g_mutex_unlock(&buffer->lock);
+  if (!notify) {
+    return;
+  }
+  // Producers and the render thread invalidate from their own threads, but
+  // the registrar is only told on the platform thread
+  sw_pixel_buffer_post(sw_pixel_buffer_mark_frame_available_cb, g_object_ref(buffer), g_object_unref);
+}
+
+gboolean sw_pixel_buffer_start_recording(SwPixelBuffer* buffer, const gchar* path, SwCaptureFormat format, int fps,
+                                         GError** error) {
+  g_mutex_lock(&buffer->lock);
+  if (buffer->recorder != nullptr) {
+    g_mutex_unlock(&buffer->lock);
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_BUSY, "Texture is already being recorded");
+    return FALSE;
+  }
+  buffer->recorder = sw_recorder_new(path, format, fps, error);
+  buffer->record_key = TRUE;
+  gboolean started = buffer->recorder != nullptr;
+  g_mutex_unlock(&buffer->lock);
+  return started;
+}
+
+gboolean sw_pixel_buffer_stop_recording(SwPixelBuffer* buffer, SwRecorderStats* stats) {
+  g_mutex_lock(&buffer->lock);
+  SwRecorder* recorder = buffer->recorder;
+  buffer->recorder = nullptr;
+  g_mutex_unlock(&buffer->lock);
+  if (recorder == nullptr) {
+    return FALSE;
+  }
+  // Waits for the writer, so the lock is not held
+  sw_recorder_free(recorder, stats);
+  return TRUE;
+}
+
+void sw_pixel_buffer_get_stats(SwPixelBuffer* buffer, SwPixelBufferStats* stats, gboolean reset) {
+  g_mutex_lock(&buffer->lock);
+  g_mutex_lock(&buffer->frame_lock);
+  *stats = buffer->stats;
+  if (reset) {
+    buffer->stats = {};
+  }
+  g_mutex_unlock(&buffer->frame_lock);
+  g_mutex_unlock(&buffer->lock);
+}
+
+void sw_pixel_buffer_get_global_stats(SwPixelBufferStats* stats, gboolean reset) {
+  G_LOCK(finalized_stats);
+  *stats = finalized_stats;
+  if (reset) {
+    finalized_stats = {};
+  }
+  G_UNLOCK(finalized_stats);
+  G_LOCK(registered);
+  if (registered != nullptr) {
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, registered);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+      SwPixelBufferStats buffer_stats;
+      sw_pixel_buffer_get_stats(SW_PIXEL_BUFFER(value), &buffer_stats, reset);
+      sw_pixel_buffer_stats_add(stats, &buffer_stats);
+    }
+  }
+  G_UNLOCK(registered);
+}
+
+gboolean sw_pixel_buffer_register(SwPixelBuffer* buffer, FlTextureRegistrar* registrar) {
+  if (!fl_texture_registrar_register_texture(registrar, FL_TEXTURE(buffer))) {
+    return FALSE;
+  }
+  buffer->registrar = registrar;
+  G_LOCK(registered);
+  if (registered == nullptr) {
+    registered = g_hash_table_new(g_direct_hash, g_direct_equal);
+  }
+  g_hash_table_insert(registered, (gpointer)sw_pixel_buffer_get_id(buffer), buffer);
+  G_UNLOCK(registered);
+  return TRUE;
+}
+
+static gboolean sw_pixel_buffer_unregister_cb(gpointer user_data) {
+  SwPixelBuffer* buffer = SW_PIXEL_BUFFER(user_data);
+  if (buffer->registrar != nullptr) {
+    fl_texture_registrar_unregister_texture(buffer->registrar, FL_TEXTURE(buffer));
+    buffer->registrar = nullptr;
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void sw_pixel_buffer_unregister(SwPixelBuffer* buffer) {
+  G_LOCK(registered);
+  if (registered != nullptr) {
+    g_hash_table_remove(registered, (gpointer)sw_pixel_buffer_get_id(buffer));
   }
+  G_UNLOCK(registered);
+  // Textures are disposed of on the render thread when it is enabled, or over
+  // FFI from any thread, but the registrar belongs to the platform thread
+  sw_pixel_buffer_post(sw_pixel_buffer_unregister_cb, g_object_ref(buffer), g_object_unref);
+}
+
+SwPixelBuffer* sw_pixel_buffer_lookup(int64_t id) {
+  SwPixelBuffer* buffer = nullptr;
+  G_LOCK(registered);
+  if (registered != nullptr) {
+    buffer = (SwPixelBuffer*)g_hash_table_lookup(registered, (gpointer)id);
+    if (buffer != nullptr) {
+      g_object_ref(buffer);
+    }
+  }
+  G_UNLOCK(registered);
+  return buffer;
 }
@@ -0,0 +1,157 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_pixel_pool.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <glib.h>
+#include <sys/mman.h>
+
+// Smallest size class
+#define SW_PIXEL_POOL_MIN_CLASS 4096
+
+// Freed stores by size class, linked through their first bytes
+static GHashTable* free_stores = nullptr;
+static SwPixelPoolStats stats = {0, 0, 0};
+G_LOCK_DEFINE_STATIC(free_stores);
+
+// Round |size| up to its size class. Classes are spaced four to each power
+// of two, so no more than a fifth of a store goes unused, and huge stores
+// are whole huge pages.
+static size_t sw_pixel_pool_class(size_t size) {
+  if (size <= SW_PIXEL_POOL_MIN_CLASS) {
+    return SW_PIXEL_POOL_MIN_CLASS;
+  }
+  if (size >= SW_PIXEL_POOL_HUGE_THRESHOLD) {
+    return (size + SW_PIXEL_POOL_HUGE_THRESHOLD - 1) / SW_PIXEL_POOL_HUGE_THRESHOLD * SW_PIXEL_POOL_HUGE_THRESHOLD;
+  }
+  size_t step = 1;
+  while (step * 8 < size) {
+    step <<= 1;
+  }
+  return (size + step - 1) / step * step;
+}
+
+static uint8_t* sw_pixel_pool_map(size_t size, gboolean* zeroed) {
+  if (size >= SW_PIXEL_POOL_HUGE_THRESHOLD) {
+    void* store = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (store != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+      madvise(store, size, MADV_HUGEPAGE);
+#endif
+      // Fresh anonymous mappings are already zero
+      *zeroed = TRUE;
+      return (uint8_t*)store;
+    }
+  } else {
+    void* store = nullptr;
+    if (posix_memalign(&store, SW_PIXEL_POOL_ALIGNMENT, size) == 0) {
+      *zeroed = FALSE;
+      return (uint8_t*)store;
+    }
+  }
+  g_error("Failed to allocate %" G_GSIZE_FORMAT " bytes of pixel data", size);
+  return nullptr;
+}
+
+static void sw_pixel_pool_unmap(uint8_t* store, size_t size) {
+  if (size >= SW_PIXEL_POOL_HUGE_THRESHOLD) {
+    munmap(store, size);
+  } else {
+    free(store);
+  }
+}
+
+uint8_t* sw_pixel_pool_alloc(size_t size, gboolean zero) {
+  size_t size_class = sw_pixel_pool_class(size);
+  uint8_t* store = nullptr;
+  G_LOCK(free_stores);
+  if (free_stores != nullptr) {
+    store = (uint8_t*)g_hash_table_lookup(free_stores, GSIZE_TO_POINTER(size_class));
+  }
+  if (store != nullptr) {
+    uint8_t* next;
+    memcpy(&next, store, sizeof(next));
+    if (next != nullptr) {
+      g_hash_table_insert(free_stores, GSIZE_TO_POINTER(size_class), next);
+    } else {
+      g_hash_table_remove(free_stores, GSIZE_TO_POINTER(size_class));
+    }
+    stats.hits++;
+    stats.cached_bytes -= size_class;
+  } else {
+    stats.misses++;
+  }
+  G_UNLOCK(free_stores);
+  gboolean zeroed = FALSE;
+  if (store == nullptr) {
+    store = sw_pixel_pool_map(size_class, &zeroed);
+  }
+  if (zero && !zeroed) {
+    memset(store, 0, size);
+  }
+  return store;
+}
+
+void sw_pixel_pool_free(uint8_t* store, size_t size) {
+  if (store == nullptr) {
+    return;
+  }
+  size_t size_class = sw_pixel_pool_class(size);
+  G_LOCK(free_stores);
+  if (stats.cached_bytes + (int64_t)size_class > SW_PIXEL_POOL_MAX_CACHED) {
+    G_UNLOCK(free_stores);
+    sw_pixel_pool_unmap(store, size_class);
+    return;
+  }
+  if (free_stores == nullptr) {
+    free_stores = g_hash_table_new(g_direct_hash, g_direct_equal);
+  }
+  uint8_t* next = (uint8_t*)g_hash_table_lookup(free_stores, GSIZE_TO_POINTER(size_class));
+  memcpy(store, &next, sizeof(next));
+  g_hash_table_insert(free_stores, GSIZE_TO_POINTER(size_class), store);
+  stats.cached_bytes += size_class;
+  G_UNLOCK(free_stores);
+}
+
+void sw_pixel_pool_get_stats(SwPixelPoolStats* out) {
+  G_LOCK(free_stores);
+  *out = stats;
+  G_UNLOCK(free_stores);
+}
+
+void sw_pixel_pool_trim() {
+  G_LOCK(free_stores);
+  if (free_stores != nullptr) {
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, free_stores);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+      uint8_t* store = (uint8_t*)value;
+      while (store != nullptr) {
+        uint8_t* next;
+        memcpy(&next, store, sizeof(next));
+        sw_pixel_pool_unmap(store, GPOINTER_TO_SIZE(key));
+        store = next;
+      }
+    }
+    g_hash_table_remove_all(free_stores);
+  }
+  stats.cached_bytes = 0;
+  G_UNLOCK(free_stores);
+}
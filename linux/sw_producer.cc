@@ -0,0 +1,83 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_producer.h"
+#include "include/sw_rend/sw_command_logger.h"
+#include "include/sw_rend/sw_pixel_buffer.h"
+
+#include <cstdint>
+
+// A producer is just a reference to the texture's buffer
+static SwPixelBuffer* sw_producer_get_buffer(SwProducer* producer) {
+  return (SwPixelBuffer*)producer;
+}
+
+static void sw_producer_fill_frame(SwPixelBuffer* buffer, SwProducerFrame* frame) {
+  frame->pixels = buffer->buffer;
+  frame->width = buffer->width;
+  frame->height = buffer->height;
+  frame->stride = 4 * buffer->width;
+}
+
+SwProducer* sw_producer_acquire(int64_t texture) {
+  return (SwProducer*)sw_pixel_buffer_lookup(texture);
+}
+
+void sw_producer_release(SwProducer* producer) {
+  if (producer != nullptr) {
+    g_object_unref(sw_producer_get_buffer(producer));
+  }
+}
+
+int32_t sw_producer_lock(SwProducer* producer, SwProducerFrame* frame) {
+  SwPixelBuffer* buffer = sw_producer_get_buffer(producer);
+  g_mutex_lock(&buffer->lock);
+  sw_producer_fill_frame(buffer, frame);
+  return 1;
+}
+
+int32_t sw_producer_try_lock(SwProducer* producer, SwProducerFrame* frame) {
+  SwPixelBuffer* buffer = sw_producer_get_buffer(producer);
+  if (!g_mutex_trylock(&buffer->lock)) {
+    return 0;
+  }
+  sw_producer_fill_frame(buffer, frame);
+  return 1;
+}
+
+void sw_producer_unlock(SwProducer* producer, const SwProducerRect* rects, size_t count) {
+  SwPixelBuffer* buffer = sw_producer_get_buffer(producer);
+  SwRect bounds = {0, 0, buffer->width, buffer->height};
+  if (count == 0) {
+    sw_damage_add(&buffer->damage, bounds);
+  }
+  for (size_t i = 0; i < count; i++) {
+    sw_damage_add(&buffer->damage, sw_rect_intersect(bounds, {rects[i].x, rects[i].y, rects[i].width, rects[i].height}));
+  }
+  g_mutex_unlock(&buffer->lock);
+  // What the producer wrote is only in the texture, so a replay cannot follow
+  sw_command_logger_mark_unlogged_all(sw_pixel_buffer_get_id(buffer), "producer");
+}
+
+void sw_producer_submit(SwProducer* producer, const SwProducerRect* rects, size_t count) {
+  sw_producer_unlock(producer, rects, count);
+  SwCommand command = {};
+  command.op = SW_COMMAND_INVALIDATE;
+  command.texture = sw_pixel_buffer_get_id(sw_producer_get_buffer(producer));
+  sw_command_logger_log_all(&command);
+  // Presents, then queues a coalesced frame notification on the platform thread
+  sw_pixel_buffer_invalidate(sw_producer_get_buffer(producer));
+}
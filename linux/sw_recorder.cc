@@ -0,0 +1,169 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_recorder.h"
+#include "sw_capture.h"
+#include "sw_trace.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+// Buffer between the writer and the file, so that writes reach the kernel in
+// large chunks
+#define SW_RECORDER_FILE_BUFFER (1024 * 1024)
+
+struct _SwRecorder {
+  GThread* thread;
+  GAsyncQueue* queue;
+  FILE* file;
+  SwCaptureFormat format;
+  int fps;
+  // Guards |backlog| and |stats.frames_dropped|, which the presenting thread
+  // changes. The rest of |stats| is only touched by the writer.
+  GMutex lock;
+  int64_t backlog;
+  SwRecorderStats stats;
+  // Y4M only: the frame rebuilt from the rects captured so far, and space to
+  // convert it in
+  SwSurface canvas;
+  uint8_t* scratch;
+  gboolean failed;
+};
+
+// Queued after the last frame to stop the writer
+static SwCaptureFrame sw_recorder_stop;
+
+static void sw_recorder_write_y4m(SwRecorder* recorder, SwCaptureFrame* frame) {
+  if (recorder->canvas.pixels == nullptr) {
+    recorder->canvas = {(uint8_t*)g_malloc0(MAX(4 * frame->width * frame->height, 1)), frame->width, frame->height};
+    recorder->scratch = (uint8_t*)g_malloc(MAX(sw_capture_y4m_frame_size(frame->width, frame->height), 1));
+    if (!sw_capture_write_y4m_header(recorder->file, frame->width, frame->height, recorder->fps)) {
+      recorder->failed = TRUE;
+      return;
+    }
+  }
+  // The stream has the size of its first frame
+  if (frame->width != recorder->canvas.width || frame->height != recorder->canvas.height) {
+    g_mutex_lock(&recorder->lock);
+    recorder->stats.frames_dropped++;
+    g_mutex_unlock(&recorder->lock);
+    return;
+  }
+  sw_capture_apply(&recorder->canvas, frame);
+  if (!sw_capture_write_y4m_frame(recorder->file, &recorder->canvas, recorder->scratch)) {
+    recorder->failed = TRUE;
+    return;
+  }
+  recorder->stats.frames_written++;
+  recorder->stats.bytes_written += 6 + sw_capture_y4m_frame_size(frame->width, frame->height);
+}
+
+static void sw_recorder_write_raw(SwRecorder* recorder, SwCaptureFrame* frame) {
+  if (!sw_capture_write_frame(recorder->file, frame)) {
+    recorder->failed = TRUE;
+    return;
+  }
+  recorder->stats.frames_written++;
+  recorder->stats.bytes_written +=
+      SW_CAPTURE_FRAME_HEADER_SIZE + 16 * frame->damage.count + 4 * sw_damage_area(&frame->damage);
+}
+
+static gpointer sw_recorder_run(gpointer user_data) {
+  SwRecorder* recorder = (SwRecorder*)user_data;
+  sw_trace_set_thread_name("sw_rend recorder");
+  while (TRUE) {
+    SwCaptureFrame* frame = (SwCaptureFrame*)g_async_queue_pop(recorder->queue);
+    if (frame == &sw_recorder_stop) {
+      break;
+    }
+    int64_t bytes = 4 * sw_damage_area(&frame->damage);
+    if (!recorder->failed) {
+      SW_TRACE_SCOPE("sw_rend", "record_frame");
+      if (recorder->format == SW_CAPTURE_Y4M) {
+        sw_recorder_write_y4m(recorder, frame);
+      } else {
+        sw_recorder_write_raw(recorder, frame);
+      }
+      if (recorder->failed) {
+        g_warning("Failed to write captured frame: %s", g_strerror(errno));
+      }
+    }
+    g_free(frame->pixels);
+    g_free(frame);
+    g_mutex_lock(&recorder->lock);
+    recorder->backlog -= bytes;
+    g_mutex_unlock(&recorder->lock);
+  }
+  return nullptr;
+}
+
+SwRecorder* sw_recorder_new(const gchar* path, SwCaptureFormat format, int fps, GError** error) {
+  FILE* file = g_fopen(path, "wb");
+  if (file == nullptr) {
+    int saved_errno = errno;
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno), "Failed to create %s: %s", path,
+                g_strerror(saved_errno));
+    return nullptr;
+  }
+  setvbuf(file, nullptr, _IOFBF, SW_RECORDER_FILE_BUFFER);
+  SwRecorder* recorder = g_new0(SwRecorder, 1);
+  recorder->file = file;
+  recorder->format = format;
+  recorder->fps = MAX(fps, 1);
+  g_mutex_init(&recorder->lock);
+  if (format == SW_CAPTURE_RAW) {
+    recorder->failed = !sw_capture_write_header(file);
+  }
+  recorder->queue = g_async_queue_new();
+  recorder->thread = g_thread_new("sw_rend recorder", sw_recorder_run, recorder);
+  return recorder;
+}
+
+gboolean sw_recorder_reserve(SwRecorder* recorder, int64_t bytes) {
+  g_mutex_lock(&recorder->lock);
+  // A frame larger than the whole backlog still goes through on its own
+  gboolean fits = recorder->backlog == 0 || recorder->backlog + bytes <= SW_RECORDER_MAX_BACKLOG;
+  if (fits) {
+    recorder->backlog += bytes;
+  } else {
+    recorder->stats.frames_dropped++;
+  }
+  g_mutex_unlock(&recorder->lock);
+  return fits;
+}
+
+void sw_recorder_push(SwRecorder* recorder, SwCaptureFrame* frame) {
+  g_async_queue_push(recorder->queue, frame);
+}
+
+void sw_recorder_free(SwRecorder* recorder, SwRecorderStats* stats) {
+  g_async_queue_push(recorder->queue, &sw_recorder_stop);
+  g_thread_join(recorder->thread);
+  g_async_queue_unref(recorder->queue);
+  if (fclose(recorder->file) != 0) {
+    g_warning("Failed to finish capture file: %s", g_strerror(errno));
+  }
+  if (stats != nullptr) {
+    *stats = recorder->stats;
+  }
+  g_free(recorder->canvas.pixels);
+  g_free(recorder->scratch);
+  g_mutex_clear(&recorder->lock);
+  g_free(recorder);
+}
@@ -0,0 +1,100 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_rend_ffi.h"
+#include "include/sw_rend/sw_command_logger.h"
+#include "include/sw_rend/sw_pixel_buffer.h"
+
+#include <cstdint>
+
+// Log a draw in any open command log, as the method channel does for its own.
+// Without |pixels| the rect was written in place.
+static void sw_rend_ffi_log_draw(int64_t texture, const uint8_t* pixels,
+                                 int64_t x, int64_t y, int64_t width, int64_t height) {
+  SwCommand command = {};
+  command.op = SW_COMMAND_DRAW;
+  command.texture = texture;
+  command.x = (int32_t)x;
+  command.y = (int32_t)y;
+  command.width = (int32_t)width;
+  command.height = (int32_t)height;
+  if (pixels == nullptr) {
+    command.flags = SW_COMMAND_FLAG_IN_PLACE;
+  } else if (width > 0 && height > 0) {
+    command.payload = pixels;
+    command.payload_length = 4 * (size_t)width * (size_t)height;
+  }
+  sw_command_logger_log_all(&command);
+}
+
+int32_t sw_rend_draw_rect(int64_t texture, const uint8_t* pixels,
+                          int64_t x, int64_t y, int64_t width, int64_t height) {
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(texture);
+  if (buffer == nullptr) {
+    return 0;
+  }
+  sw_rend_ffi_log_draw(texture, pixels, x, y, width, height);
+  sw_pixel_buffer_draw_rect(buffer, pixels, x, y, width, height);
+  g_object_unref(buffer);
+  return 1;
+}
+
+int32_t sw_rend_damage_rect(int64_t texture, int64_t x, int64_t y, int64_t width, int64_t height) {
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(texture);
+  if (buffer == nullptr) {
+    return 0;
+  }
+  sw_rend_ffi_log_draw(texture, nullptr, x, y, width, height);
+  sw_pixel_buffer_damage(buffer, x, y, width, height);
+  g_object_unref(buffer);
+  return 1;
+}
+
+int32_t sw_rend_mark_frame_available(int64_t texture) {
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(texture);
+  if (buffer == nullptr) {
+    return 0;
+  }
+  SwCommand command = {};
+  command.op = SW_COMMAND_INVALIDATE;
+  command.texture = texture;
+  sw_command_logger_log_all(&command);
+  sw_pixel_buffer_invalidate(buffer);
+  g_object_unref(buffer);
+  return 1;
+}
+
+int32_t sw_rend_read_rect(int64_t texture, uint8_t* pixels,
+                          int64_t x, int64_t y, int64_t width, int64_t height) {
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(texture);
+  if (buffer == nullptr) {
+    return 0;
+  }
+  gboolean read = sw_pixel_buffer_read_rect(buffer, pixels, x, y, width, height);
+  g_object_unref(buffer);
+  return read ? 1 : -1;
+}
+
+int32_t sw_rend_get_size(int64_t texture, int32_t* width, int32_t* height) {
+  SwPixelBuffer* buffer = sw_pixel_buffer_lookup(texture);
+  if (buffer == nullptr) {
+    return 0;
+  }
+  *width = (int32_t)buffer->width;
+  *height = (int32_t)buffer->height;
+  g_object_unref(buffer);
+  return 1;
+}
@@ -16,6 +16,17 @@ limitations under the License.
 
 #include "include/sw_rend/sw_rend_plugin.h"
 #include "include/sw_rend/sw_pixel_buffer.h"
+#include "include/sw_rend/sw_pixel_pool.h"
+#include "include/sw_rend/sw_binary_channel.h"
+#include "include/sw_rend/sw_command_logger.h"
+#include "include/sw_rend/sw_draw_batch.h"
+#include "include/sw_rend/sw_frame_events.h"
+#include "include/sw_rend/sw_render_thread.h"
+#include "sw_raster.h"
+#include "sw_sprite_cache.h"
+#include "sw_tilemap.h"
+#include "sw_trace.h"
+#include "sw_worker_pool.h"
 
 #include <gmodule.h>
 #include <glib-object.h>
@@ -24,8 +35,10 @@ limitations under the License.
 #include <flutter_linux/flutter_linux.h>
 #include <gtk/gtk.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 
 #include <cstring>
+#include <string>
 
 #define SW_REND_PLUGIN(obj) \
   (G_TYPE_CHECK_INSTANCE_CAST((obj), sw_rend_plugin_get_type(), \
@@ -34,13 +47,40 @@ limitations under the License.
 struct _SwRendPlugin {
   GObject parent_instance;
   GHashTable* textures;
+  // Guards |textures|, which init changes on the platform thread while
+  // offloaded methods read it on the render thread
+  GMutex textures_lock;
   FlTextureRegistrar* registrar;
+  // Shared by every texture the plugin creates
+  SwWorkerPool* workers;
+  // Runs offloadable methods when enabled, or nullptr
+  SwRenderThread* render_thread;
+  // Logs incoming calls when enabled, or nullptr. Only used on the platform
+  // thread.
+  SwCommandLogger* command_log;
+  // Images uploaded once and drawn into any texture by ID
+  SwSpriteCache* sprites;
 };
 
 G_DEFINE_TYPE(SwRendPlugin, sw_rend_plugin, g_object_get_type())
 
 typedef FlMethodResponse* (*MethodCallback)(SwRendPlugin* plugin, FlValue* arguments);
 
+typedef struct {
+  MethodCallback func;
+  // Whether the method may run on the render thread. Methods that touch a
+  // texture all do, so that they keep their order relative to each other and
+  // to dispose.
+  gboolean offload;
+} MethodEntry;
+
+static SwPixelBuffer* sw_rend_plugin_lookup(SwRendPlugin* plugin, int64_t buffer_id) {
+  g_mutex_lock(&plugin->textures_lock);
+  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  g_mutex_unlock(&plugin->textures_lock);
+  return buffer;
+}
+
 static FlMethodResponse* sw_rend_plugin_method_init(SwRendPlugin* plugin, FlValue* arguments){
   FlValue *ptr = fl_value_lookup_string(arguments, "width");
   if (ptr == nullptr) {
@@ -52,13 +92,21 @@ static FlMethodResponse* sw_rend_plugin_method_init(SwRendPlugin* plugin, FlValu
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify height", fl_value_new_null()));
   }
   int height = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = sw_pixel_buffer_new(width, height);
-  gboolean success = fl_texture_registrar_register_texture(plugin->registrar, (FlTexture*)(&buffer->parent_instance));
+  SwPixelBufferMode mode = SW_PIXEL_BUFFER_DIRECT;
+  ptr = fl_value_lookup_string(arguments, "tear_free");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    mode = SW_PIXEL_BUFFER_MAILBOX;
+  }
+  SwPixelBuffer* buffer = sw_pixel_buffer_new(width, height, mode, plugin->workers);
+  gboolean success = sw_pixel_buffer_register(buffer, plugin->registrar);
   if(!success) {
+    sw_pixel_buffer_dispose(buffer);
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Failed to register texture", fl_value_new_null()));
   }
   int64_t buffer_id = sw_pixel_buffer_get_id(buffer);
+  g_mutex_lock(&plugin->textures_lock);
   g_hash_table_insert(plugin->textures, (gpointer)buffer_id, (gpointer)buffer);
+  g_mutex_unlock(&plugin->textures_lock);
   g_autoptr(FlValue) result = fl_value_new_int(buffer_id);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -69,32 +117,66 @@ static FlMethodResponse* sw_rend_plugin_method_dispose(SwRendPlugin* plugin, FlV
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
   }
   int64_t buffer_id = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
   if (buffer == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
-  fl_texture_registrar_unregister_texture(plugin->registrar, (FlTexture*)(&buffer->parent_instance));
-  sw_pixel_buffer_dispose(buffer);
+  g_mutex_lock(&plugin->textures_lock);
   g_hash_table_remove(plugin->textures, (gpointer)buffer_id);
+  g_mutex_unlock(&plugin->textures_lock);
+  sw_pixel_buffer_unregister(buffer);
+  sw_pixel_buffer_dispose(buffer);
   g_autoptr(FlValue) result = fl_value_new_null();
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-static FlMethodResponse* sw_rend_plugin_method_draw(SwRendPlugin* plugin, FlValue* arguments) {
+static FlMethodResponse* sw_rend_plugin_method_resize(SwRendPlugin* plugin, FlValue* arguments) {
   FlValue *ptr = fl_value_lookup_string(arguments, "texture");
   if (ptr == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
   }
   int64_t buffer_id = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
   if (buffer == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
-  ptr = fl_value_lookup_string(arguments, "pixels");
+  ptr = fl_value_lookup_string(arguments, "width");
   if (ptr == nullptr) {
-    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply pixel data", fl_value_new_null()));
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify width", fl_value_new_null()));
+  }
+  int64_t width = fl_value_get_int(ptr);
+  ptr = fl_value_lookup_string(arguments, "height");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify height", fl_value_new_null()));
+  }
+  int64_t height = fl_value_get_int(ptr);
+  if (width < 0 || height < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Size must not be negative", fl_value_new_null()));
+  }
+  SwResizeAnchor anchor = SW_RESIZE_TOP_LEFT;
+  ptr = fl_value_lookup_string(arguments, "anchor");
+  if (ptr != nullptr) {
+    int64_t value = fl_value_get_int(ptr);
+    if (value < 0 || value >= SW_RESIZE_ANCHOR_COUNT) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown resize anchor", fl_value_new_null()));
+    }
+    anchor = (SwResizeAnchor)value;
+  }
+  sw_pixel_buffer_resize(buffer, width, height, anchor);
+  g_autoptr(FlValue) result = fl_value_new_null();
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_draw(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  int64_t buffer_id = fl_value_get_int(ptr);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
-  const uint8_t* pixels = fl_value_get_uint8_list(ptr);
   ptr = fl_value_lookup_string(arguments, "x");
   int64_t x = 0, y = 0, width = buffer->width, height = buffer->height;
   if (ptr != nullptr) {
@@ -112,7 +194,465 @@ static FlMethodResponse* sw_rend_plugin_method_draw(SwRendPlugin* plugin, FlValu
   if (ptr != nullptr) {
     height = fl_value_get_int(ptr);
   }
-  sw_pixel_buffer_draw_rect(buffer, pixels, x, y, width, height);
+  SwPixelFormat format = SW_PIXEL_FORMAT_RGBA8888;
+  ptr = fl_value_lookup_string(arguments, "format");
+  if (ptr != nullptr) {
+    if (!sw_pixel_format_is_valid(fl_value_get_int(ptr))) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown pixel format", fl_value_new_null()));
+    }
+    format = (SwPixelFormat)fl_value_get_int(ptr);
+  }
+  SwBlendMode blend = SW_BLEND_SRC;
+  ptr = fl_value_lookup_string(arguments, "blend");
+  if (ptr != nullptr) {
+    if (!sw_blend_mode_is_valid(fl_value_get_int(ptr))) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown blend mode", fl_value_new_null()));
+    }
+    blend = (SwBlendMode)fl_value_get_int(ptr);
+  }
+  SwEncoding encoding = SW_ENCODING_RAW;
+  ptr = fl_value_lookup_string(arguments, "encoding");
+  if (ptr != nullptr) {
+    if (!sw_encoding_is_valid(fl_value_get_int(ptr))) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown pixel encoding", fl_value_new_null()));
+    }
+    encoding = (SwEncoding)fl_value_get_int(ptr);
+  }
+  // Without pixel data the caller has already written the region in place
+  // through the address from get_buffer_address, so only record the damage
+  ptr = fl_value_lookup_string(arguments, "pixels");
+  if (ptr == nullptr || fl_value_get_type(ptr) == FL_VALUE_TYPE_NULL) {
+    sw_pixel_buffer_damage(buffer, x, y, width, height);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+  }
+  if (encoding != SW_ENCODING_RAW) {
+    if (format != SW_PIXEL_FORMAT_RGBA8888 || blend != SW_BLEND_SRC) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Encoded pixels must be RGBA and replace the texture", fl_value_new_null()));
+    }
+    if (!sw_pixel_buffer_decode_rect(buffer, fl_value_get_uint8_list(ptr), fl_value_get_length(ptr), x, y, width, height, encoding)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Malformed encoded pixels or rect outside the texture", fl_value_new_null()));
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+  }
+  if (width < 0 || height < 0 ||
+      fl_value_get_length(ptr) / sw_pixel_format_bytes_per_pixel(format) / MAX(width, 1) < (size_t)height) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Pixel data is smaller than the rect", fl_value_new_null()));
+  }
+  const uint8_t* pixels = fl_value_get_uint8_list(ptr);
+  sw_pixel_buffer_draw_rect(buffer, pixels, x, y, width, height, format, blend);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_draw_batch(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "records");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply draw records", fl_value_new_null()));
+  }
+  const int64_t* records = fl_value_get_int64_list(ptr);
+  size_t num_records = fl_value_get_length(ptr) / SW_BATCH_RECORD_SIZE;
+  ptr = fl_value_lookup_string(arguments, "pixels");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply pixel data", fl_value_new_null()));
+  }
+  const uint8_t* pixels = fl_value_get_uint8_list(ptr);
+  int64_t pixels_length = fl_value_get_length(ptr);
+  SwPixelFormat format = SW_PIXEL_FORMAT_RGBA8888;
+  ptr = fl_value_lookup_string(arguments, "format");
+  if (ptr != nullptr) {
+    if (!sw_pixel_format_is_valid(fl_value_get_int(ptr))) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown pixel format", fl_value_new_null()));
+    }
+    format = (SwPixelFormat)fl_value_get_int(ptr);
+  }
+  SwBlendMode blend = SW_BLEND_SRC;
+  ptr = fl_value_lookup_string(arguments, "blend");
+  if (ptr != nullptr) {
+    if (!sw_blend_mode_is_valid(fl_value_get_int(ptr))) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown blend mode", fl_value_new_null()));
+    }
+    blend = (SwBlendMode)fl_value_get_int(ptr);
+  }
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  gboolean invalidate = ptr != nullptr && fl_value_get_bool(ptr);
+  int bpp = sw_pixel_format_bytes_per_pixel(format);
+
+  // Resolve and check every record before drawing any, so that a bad batch
+  // leaves the textures untouched
+  SwPixelBuffer** buffers = g_new(SwPixelBuffer*, num_records);
+  SwPixelBuffer* buffer = nullptr;
+  for (size_t i = 0; i < num_records; i++) {
+    const int64_t* record = records + i * SW_BATCH_RECORD_SIZE;
+    // Batches tend to hit the same texture many times in a row
+    if (buffer == nullptr || sw_pixel_buffer_get_id(buffer) != record[SW_BATCH_TEXTURE]) {
+      buffer = sw_rend_plugin_lookup(plugin, record[SW_BATCH_TEXTURE]);
+    }
+    if (buffer == nullptr) {
+      g_free(buffers);
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_int(i)));
+    }
+    int64_t width = record[SW_BATCH_WIDTH], height = record[SW_BATCH_HEIGHT], offset = record[SW_BATCH_OFFSET];
+    if (width < 0 || height < 0 || offset < 0 || offset > pixels_length ||
+        (width > 0 && (pixels_length - offset) / bpp / width < height)) {
+      g_free(buffers);
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Record lies outside the pixel data", fl_value_new_int(i)));
+    }
+    buffers[i] = buffer;
+  }
+
+  GHashTable* touched = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for (size_t i = 0; i < num_records; i++) {
+    const int64_t* record = records + i * SW_BATCH_RECORD_SIZE;
+    sw_pixel_buffer_draw_rect(buffers[i], pixels + record[SW_BATCH_OFFSET], record[SW_BATCH_X], record[SW_BATCH_Y],
+                              record[SW_BATCH_WIDTH], record[SW_BATCH_HEIGHT], format, blend);
+    g_hash_table_add(touched, buffers[i]);
+  }
+  if (invalidate) {
+    GHashTableIter iter;
+    gpointer key;
+    g_hash_table_iter_init(&iter, touched);
+    while (g_hash_table_iter_next(&iter, &key, nullptr)) {
+      sw_pixel_buffer_invalidate((SwPixelBuffer*)key);
+    }
+  }
+  g_hash_table_destroy(touched);
+  g_free(buffers);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_raster(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  int64_t buffer_id = fl_value_get_int(ptr);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "commands");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply raster commands", fl_value_new_null()));
+  }
+  const int32_t* commands = fl_value_get_int32_list(ptr);
+  size_t length = fl_value_get_length(ptr);
+  int64_t bad_command = sw_raster_validate(commands, length);
+  if (bad_command >= 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Malformed raster command", fl_value_new_int(bad_command)));
+  }
+  sw_pixel_buffer_raster(buffer, commands, length);
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static int64_t sw_rend_plugin_get_int_or(FlValue* arguments, const char* key, int64_t fallback) {
+  FlValue* ptr = fl_value_lookup_string(arguments, key);
+  return ptr == nullptr ? fallback : fl_value_get_int(ptr);
+}
+
+static FlMethodResponse* sw_rend_plugin_method_blit(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  int64_t buffer_id = fl_value_get_int(ptr);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  int64_t x = sw_rend_plugin_get_int_or(arguments, "x", 0);
+  int64_t y = sw_rend_plugin_get_int_or(arguments, "y", 0);
+  int64_t width = sw_rend_plugin_get_int_or(arguments, "width", buffer->width);
+  int64_t height = sw_rend_plugin_get_int_or(arguments, "height", buffer->height);
+  int64_t filter = sw_rend_plugin_get_int_or(arguments, "filter", SW_SCALE_NEAREST);
+  if (!sw_scale_filter_is_valid(filter)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown scale filter", fl_value_new_null()));
+  }
+  if (!sw_scale_size_is_valid(width, height)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Invalid rect", fl_value_new_null()));
+  }
+  // The source is either uploaded pixels or a rect of another texture
+  ptr = fl_value_lookup_string(arguments, "source");
+  if (ptr != nullptr) {
+    SwPixelBuffer* source = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+    if (source == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Source texture ID is not registered", fl_value_new_null()));
+    }
+    if (!sw_pixel_buffer_blit_from(buffer, source, sw_rend_plugin_get_int_or(arguments, "src_x", 0),
+                                   sw_rend_plugin_get_int_or(arguments, "src_y", 0),
+                                   sw_rend_plugin_get_int_or(arguments, "src_width", source->width),
+                                   sw_rend_plugin_get_int_or(arguments, "src_height", source->height),
+                                   x, y, width, height, (SwScaleFilter)filter)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Source rect lies outside the source texture", fl_value_new_null()));
+    }
+  } else {
+    ptr = fl_value_lookup_string(arguments, "pixels");
+    if (ptr == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply pixels or a source texture", fl_value_new_null()));
+    }
+    FlValue* src_width = fl_value_lookup_string(arguments, "src_width");
+    FlValue* src_height = fl_value_lookup_string(arguments, "src_height");
+    if (src_width == nullptr || src_height == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify the size of the pixels", fl_value_new_null()));
+    }
+    int64_t w = fl_value_get_int(src_width), h = fl_value_get_int(src_height);
+    if (!sw_scale_size_is_valid(w, h) || fl_value_get_length(ptr) / 4 / MAX(w, 1) < (size_t)h) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Pixel data is smaller than its size", fl_value_new_null()));
+    }
+    sw_pixel_buffer_blit_scaled(buffer, fl_value_get_uint8_list(ptr), 4 * w, w, h, x, y, width, height,
+                                (SwScaleFilter)filter);
+  }
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_add_sprite(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "pixels");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply pixel data", fl_value_new_null()));
+  }
+  FlValue* width = fl_value_lookup_string(arguments, "width");
+  FlValue* height = fl_value_lookup_string(arguments, "height");
+  if (width == nullptr || height == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify the size of the pixels", fl_value_new_null()));
+  }
+  int64_t w = fl_value_get_int(width), h = fl_value_get_int(height);
+  if (w < 0 || h < 0 || fl_value_get_length(ptr) / 4 / MAX(w, 1) < (size_t)h) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Pixel data is smaller than its size", fl_value_new_null()));
+  }
+  int64_t id = sw_sprite_cache_add(plugin->sprites, fl_value_get_uint8_list(ptr), w, h);
+  if (id == 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Sprite is larger than the sprite cache", fl_value_new_null()));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_int(id)));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_remove_sprite(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "sprite");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify sprite ID", fl_value_new_null()));
+  }
+  gboolean removed = sw_sprite_cache_remove(plugin->sprites, fl_value_get_int(ptr));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_bool(removed)));
+}
+
+// Returns whether the sprite was still cached
+static FlMethodResponse* sw_rend_plugin_method_blit_sprite(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "sprite");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify sprite ID", fl_value_new_null()));
+  }
+  int64_t sprite = fl_value_get_int(ptr);
+  int64_t alpha = sw_rend_plugin_get_int_or(arguments, "alpha", 255);
+  int64_t blend = sw_rend_plugin_get_int_or(arguments, "blend", SW_BLEND_SRC_OVER);
+  if (alpha < 0 || alpha > 255) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Alpha must be between 0 and 255", fl_value_new_null()));
+  }
+  if (!sw_blend_mode_is_valid(blend)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown blend mode", fl_value_new_null()));
+  }
+  gboolean hit = sw_pixel_buffer_blit_sprite(buffer, plugin->sprites, sprite, sw_rend_plugin_get_int_or(arguments, "x", 0),
+                                             sw_rend_plugin_get_int_or(arguments, "y", 0), (uint8_t)alpha,
+                                             (SwBlendMode)blend);
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_bool(hit)));
+}
+
+// Fields of each record in a blit_sprites "records" list
+enum {
+  SW_SPRITE_BATCH_SPRITE,
+  SW_SPRITE_BATCH_X,
+  SW_SPRITE_BATCH_Y,
+  SW_SPRITE_BATCH_ALPHA,
+  SW_SPRITE_BATCH_RECORD_SIZE,
+};
+
+// Returns the IDs of the sprites that were no longer cached
+static FlMethodResponse* sw_rend_plugin_method_blit_sprites(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "records");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply sprite records", fl_value_new_null()));
+  }
+  const int64_t* records = fl_value_get_int64_list(ptr);
+  size_t num_records = fl_value_get_length(ptr) / SW_SPRITE_BATCH_RECORD_SIZE;
+  int64_t blend = sw_rend_plugin_get_int_or(arguments, "blend", SW_BLEND_SRC_OVER);
+  if (!sw_blend_mode_is_valid(blend)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown blend mode", fl_value_new_null()));
+  }
+  GArray* missed = g_array_new(FALSE, FALSE, sizeof(int64_t));
+  for (size_t i = 0; i < num_records; i++) {
+    const int64_t* record = records + i * SW_SPRITE_BATCH_RECORD_SIZE;
+    uint8_t alpha = (uint8_t)CLAMP(record[SW_SPRITE_BATCH_ALPHA], 0, 255);
+    if (!sw_pixel_buffer_blit_sprite(buffer, plugin->sprites, record[SW_SPRITE_BATCH_SPRITE], record[SW_SPRITE_BATCH_X],
+                                     record[SW_SPRITE_BATCH_Y], alpha, (SwBlendMode)blend)) {
+      g_array_append_val(missed, record[SW_SPRITE_BATCH_SPRITE]);
+    }
+  }
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  FlValue* result = fl_value_new_int64_list((const int64_t*)missed->data, missed->len);
+  g_array_free(missed, TRUE);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_get_sprite_stats(SwRendPlugin* plugin, FlValue* arguments) {
+  SwSpriteCacheStats stats;
+  sw_sprite_cache_get_stats(plugin->sprites, &stats);
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "hits", fl_value_new_int(stats.hits));
+  fl_value_set_string_take(result, "misses", fl_value_new_int(stats.misses));
+  fl_value_set_string_take(result, "evictions", fl_value_new_int(stats.evictions));
+  fl_value_set_string_take(result, "sprites", fl_value_new_int(stats.sprites));
+  fl_value_set_string_take(result, "bytes", fl_value_new_int(stats.bytes));
+  fl_value_set_string_take(result, "capacity", fl_value_new_int(stats.capacity));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Cells a tilemap may have, so that its grid stays a reasonable allocation
+#define SW_TILEMAP_MAX_CELLS (16 * 1024 * 1024)
+
+static FlMethodResponse* sw_rend_plugin_method_set_tilemap(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  FlValue* tileset = fl_value_lookup_string(arguments, "tileset");
+  if (tileset == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply a tileset", fl_value_new_null()));
+  }
+  int64_t tileset_width = sw_rend_plugin_get_int_or(arguments, "tileset_width", -1);
+  int64_t tileset_height = sw_rend_plugin_get_int_or(arguments, "tileset_height", -1);
+  int64_t tile_width = sw_rend_plugin_get_int_or(arguments, "tile_width", -1);
+  int64_t tile_height = sw_rend_plugin_get_int_or(arguments, "tile_height", -1);
+  int64_t columns = sw_rend_plugin_get_int_or(arguments, "columns", -1);
+  int64_t rows = sw_rend_plugin_get_int_or(arguments, "rows", -1);
+  if (tileset_width < 0 || tileset_height < 0 || tile_width < 0 || tile_height < 0 || columns < 0 || rows < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify the size of the tileset, its tiles and the grid", fl_value_new_null()));
+  }
+  if (tile_width == 0 || tile_height == 0 || tileset_width < tile_width || tileset_height < tile_height) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Tileset must hold at least one tile", fl_value_new_null()));
+  }
+  if (fl_value_get_length(tileset) / 4 / tileset_width < (size_t)tileset_height) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Tileset is smaller than its size", fl_value_new_null()));
+  }
+  if (columns > 0 && rows > SW_TILEMAP_MAX_CELLS / columns) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Tilemap has too many cells", fl_value_new_null()));
+  }
+  FlValue* tiles = fl_value_lookup_string(arguments, "tiles");
+  if (tiles != nullptr && fl_value_get_length(tiles) < (size_t)(columns * rows)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Must supply a tile for every cell", fl_value_new_null()));
+  }
+  SwTilemap* tilemap = sw_tilemap_new(tile_width, tile_height, columns, rows, fl_value_get_uint8_list(tileset),
+                                      tileset_width, tileset_height);
+  // Nothing is drawn until the tilemap is bound, so fill it in against an
+  // empty surface first
+  SwSurface none = {nullptr, 0, 0};
+  SwDamage damage;
+  sw_damage_clear(&damage);
+  if (tiles != nullptr) {
+    sw_tilemap_set_tiles(tilemap, &none, 0, 0, columns, rows, fl_value_get_int32_list(tiles), &damage, nullptr);
+  }
+  sw_tilemap_scroll(tilemap, &none, sw_rend_plugin_get_int_or(arguments, "x", 0),
+                    sw_rend_plugin_get_int_or(arguments, "y", 0), &damage, nullptr);
+  int64_t tile_count = sw_tilemap_get_tile_count(tilemap);
+  sw_pixel_buffer_set_tilemap(buffer, tilemap);
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_int(tile_count)));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_remove_tilemap(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  sw_pixel_buffer_set_tilemap(buffer, nullptr);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_set_tiles(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  FlValue* tiles = fl_value_lookup_string(arguments, "tiles");
+  if (tiles == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must supply tiles", fl_value_new_null()));
+  }
+  int64_t width = sw_rend_plugin_get_int_or(arguments, "width", 1);
+  int64_t height = sw_rend_plugin_get_int_or(arguments, "height", 1);
+  if (width < 0 || height < 0 || fl_value_get_length(tiles) / MAX(width, 1) < (size_t)height) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Must supply a tile for every cell", fl_value_new_null()));
+  }
+  if (!sw_pixel_buffer_set_tiles(buffer, sw_rend_plugin_get_int_or(arguments, "column", 0),
+                                 sw_rend_plugin_get_int_or(arguments, "row", 0), width, height,
+                                 fl_value_get_int32_list(tiles))) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture has no tilemap or the cells lie outside it", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_scroll_tilemap(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  if (!sw_pixel_buffer_scroll_tilemap(buffer, sw_rend_plugin_get_int_or(arguments, "x", 0),
+                                      sw_rend_plugin_get_int_or(arguments, "y", 0))) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture has no tilemap", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "invalidate");
+  if (ptr != nullptr && fl_value_get_bool(ptr)) {
+    sw_pixel_buffer_invalidate(buffer);
+  }
   return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
 }
 
@@ -122,11 +662,11 @@ static FlMethodResponse* sw_rend_plugin_method_invalidate(SwRendPlugin* plugin,
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
   }
   int64_t buffer_id = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
   if (buffer == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
-  fl_texture_registrar_mark_texture_frame_available(plugin->registrar, (FlTexture*)(&buffer->parent_instance));
+  sw_pixel_buffer_invalidate(buffer);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
 }
 
@@ -136,11 +676,93 @@ static FlMethodResponse* sw_rend_plugin_method_read(SwRendPlugin* plugin, FlValu
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
   }
   int64_t buffer_id = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  int64_t x = 0, y = 0, width = buffer->width, height = buffer->height;
+  ptr = fl_value_lookup_string(arguments, "x");
+  if (ptr != nullptr) {
+    x = fl_value_get_int(ptr);
+  }
+  ptr = fl_value_lookup_string(arguments, "y");
+  if (ptr != nullptr) {
+    y = fl_value_get_int(ptr);
+  }
+  ptr = fl_value_lookup_string(arguments, "width");
+  if (ptr != nullptr) {
+    width = fl_value_get_int(ptr);
+  }
+  ptr = fl_value_lookup_string(arguments, "height");
+  if (ptr != nullptr) {
+    height = fl_value_get_int(ptr);
+  }
+  // With an address the caller has provided memory for the rect, usually
+  // allocated through dart:ffi, and nothing is copied into the response
+  ptr = fl_value_lookup_string(arguments, "address");
+  if (ptr != nullptr) {
+    if (!sw_pixel_buffer_read_rect(buffer, (uint8_t*)fl_value_get_int(ptr), x, y, width, height)) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Rect lies outside the texture", fl_value_new_null()));
+    }
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+  }
+  // Check the rect before allocating for it; reading checks it again under
+  // the lock in case the texture is resized in between
+  if (x < 0 || y < 0 || width < 0 || height < 0 || x > buffer->width - width || y > buffer->height - height) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Rect lies outside the texture", fl_value_new_null()));
+  }
+  size_t size = 4 * width * height;
+  uint8_t* pixels = (uint8_t*)g_malloc(MAX(size, 1));
+  if (!sw_pixel_buffer_read_rect(buffer, pixels, x, y, width, height)) {
+    g_free(pixels);
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Rect lies outside the texture", fl_value_new_null()));
+  }
+  FlValue* result = fl_value_new_uint8_list(pixels, size);
+  g_free(pixels);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_get_buffer_address(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  int64_t buffer_id = fl_value_get_int(ptr);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  uint8_t* pixels = sw_pixel_buffer_share(buffer);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_int((int64_t)pixels)));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_get_damage(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  int64_t buffer_id = fl_value_get_int(ptr);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
   if (buffer == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
-  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_uint8_list(buffer->buffer, buffer->width * buffer->height * 4)));
+  g_mutex_lock(&buffer->lock);
+  int64_t rects[4 * SW_DAMAGE_MAX_RECTS];
+  for (int i = 0; i < buffer->damage.count; i++) {
+    SwRect rect = buffer->damage.rects[i];
+    rects[4 * i] = rect.x;
+    rects[4 * i + 1] = rect.y;
+    rects[4 * i + 2] = rect.width;
+    rects[4 * i + 3] = rect.height;
+  }
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "pending_rects", fl_value_new_int64_list(rects, 4 * buffer->damage.count));
+  fl_value_set_string_take(result, "pending_area", fl_value_new_int(sw_damage_area(&buffer->damage)));
+  fl_value_set_string_take(result, "last_frame_area", fl_value_new_int(buffer->last_frame_damage_area));
+  fl_value_set_string_take(result, "total_area", fl_value_new_int(buffer->total_damage_area));
+  fl_value_set_string_take(result, "frames", fl_value_new_int(buffer->frames_presented));
+  g_mutex_unlock(&buffer->lock);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static FlMethodResponse* sw_rend_plugin_method_get_size(SwRendPlugin* plugin, FlValue* arguments) {
@@ -149,7 +771,7 @@ static FlMethodResponse* sw_rend_plugin_method_get_size(SwRendPlugin* plugin, Fl
     return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
   }
   int64_t buffer_id = fl_value_get_int(ptr);
-  SwPixelBuffer* buffer = (SwPixelBuffer*)g_hash_table_lookup(plugin->textures, (gpointer)buffer_id);
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, buffer_id);
   if (buffer == nullptr) {
     return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
   }
@@ -158,6 +780,7 @@ static FlMethodResponse* sw_rend_plugin_method_get_size(SwRendPlugin* plugin, Fl
 }
 
 static FlMethodResponse* sw_rend_plugin_method_list(SwRendPlugin* plugin, FlValue* arguments) {
+  g_mutex_lock(&plugin->textures_lock);
   uint32_t size = g_hash_table_size(plugin->textures);
   int64_t* textures = g_new(int64_t, size);
   GHashTableIter iter;
@@ -167,13 +790,264 @@ static FlMethodResponse* sw_rend_plugin_method_list(SwRendPlugin* plugin, FlValu
     g_hash_table_iter_next(&iter, &key, nullptr);
     textures[i] = (int64_t)key;
   }
+  g_mutex_unlock(&plugin->textures_lock);
   FlMethodResponse* response = FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_int64_list(textures, size)));
   g_free(textures);
   return response;
 }
 
+static FlMethodResponse* sw_rend_plugin_method_configure(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "workers");
+  if (ptr != nullptr) {
+    int64_t workers = fl_value_get_int(ptr);
+    if (workers < 1) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Must use at least one worker", fl_value_new_null()));
+    }
+    sw_worker_pool_set_workers(plugin->workers, (int)MIN(workers, G_MAXINT));
+  }
+  ptr = fl_value_lookup_string(arguments, "threshold");
+  if (ptr != nullptr) {
+    int64_t threshold = fl_value_get_int(ptr);
+    if (threshold < 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Threshold must not be negative", fl_value_new_null()));
+    }
+    sw_worker_pool_set_threshold(plugin->workers, threshold);
+  }
+  ptr = fl_value_lookup_string(arguments, "render_thread");
+  if (ptr != nullptr) {
+    gboolean enable = fl_value_get_bool(ptr);
+    if (enable && plugin->render_thread == nullptr) {
+      plugin->render_thread = sw_render_thread_new(plugin);
+    } else if (!enable && plugin->render_thread != nullptr) {
+      // Waits for the queued methods, whose responses are already posted
+      // back to this thread by the time it returns
+      sw_render_thread_free(plugin->render_thread);
+      plugin->render_thread = nullptr;
+    }
+  }
+  ptr = fl_value_lookup_string(arguments, "tracing");
+  if (ptr != nullptr) {
+    sw_trace_set_enabled(fl_value_get_bool(ptr));
+  }
+  ptr = fl_value_lookup_string(arguments, "sprite_cache_bytes");
+  if (ptr != nullptr) {
+    int64_t capacity = fl_value_get_int(ptr);
+    if (capacity < 0) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Sprite cache size must not be negative", fl_value_new_null()));
+    }
+    sw_sprite_cache_set_capacity(plugin->sprites, capacity);
+  }
+  ptr = fl_value_lookup_string(arguments, "command_log");
+  if (ptr != nullptr) {
+    // An empty path just stops logging
+    if (plugin->command_log != nullptr) {
+      sw_command_logger_free(plugin->command_log);
+      plugin->command_log = nullptr;
+    }
+    const gchar* path = fl_value_get_string(ptr);
+    if (*path != '\0') {
+      g_autoptr(GError) error = nullptr;
+      plugin->command_log = sw_command_logger_new(path, &error);
+      if (plugin->command_log == nullptr) {
+        return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", error->message, fl_value_new_null()));
+      }
+    }
+  }
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "workers", fl_value_new_int(sw_worker_pool_get_workers(plugin->workers)));
+  fl_value_set_string_take(result, "threshold", fl_value_new_int(sw_worker_pool_get_threshold(plugin->workers)));
+  fl_value_set_string_take(result, "render_thread", fl_value_new_bool(plugin->render_thread != nullptr));
+  fl_value_set_string_take(result, "tracing", fl_value_new_bool(sw_trace_is_enabled()));
+  fl_value_set_string_take(result, "command_log", fl_value_new_bool(plugin->command_log != nullptr));
+  SwSpriteCacheStats sprite_stats;
+  sw_sprite_cache_get_stats(plugin->sprites, &sprite_stats);
+  fl_value_set_string_take(result, "sprite_cache_bytes", fl_value_new_int(sprite_stats.capacity));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_get_pool_stats(SwRendPlugin* plugin, FlValue* arguments) {
+  SwPixelPoolStats stats;
+  sw_pixel_pool_get_stats(&stats);
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "hits", fl_value_new_int(stats.hits));
+  fl_value_set_string_take(result, "misses", fl_value_new_int(stats.misses));
+  fl_value_set_string_take(result, "cached_bytes", fl_value_new_int(stats.cached_bytes));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_start_recording(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  ptr = fl_value_lookup_string(arguments, "path");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify capture file path", fl_value_new_null()));
+  }
+  const gchar* path = fl_value_get_string(ptr);
+  int64_t format = sw_rend_plugin_get_int_or(arguments, "format", SW_CAPTURE_RAW);
+  if (!sw_capture_format_is_valid(format)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Unknown capture format", fl_value_new_null()));
+  }
+  int64_t fps = sw_rend_plugin_get_int_or(arguments, "fps", 60);
+  if (fps < 1 || fps > G_MAXINT) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Frame rate must be positive", fl_value_new_null()));
+  }
+  g_autoptr(GError) error = nullptr;
+  if (!sw_pixel_buffer_start_recording(buffer, path, (SwCaptureFormat)format, (int)fps, &error)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", error->message, fl_value_new_null()));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_null()));
+}
+
+static FlMethodResponse* sw_rend_plugin_method_stop_recording(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("MISSING", "Must specify texture ID", fl_value_new_null()));
+  }
+  SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+  if (buffer == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+  }
+  SwRecorderStats stats;
+  if (!sw_pixel_buffer_stop_recording(buffer, &stats)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture is not being recorded", fl_value_new_null()));
+  }
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "frames", fl_value_new_int(stats.frames_written));
+  fl_value_set_string_take(result, "dropped", fl_value_new_int(stats.frames_dropped));
+  fl_value_set_string_take(result, "bytes", fl_value_new_int(stats.bytes_written));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Report the counters of one texture, or summed over every texture if none is
+// given, optionally zeroing them
+static FlMethodResponse* sw_rend_plugin_method_get_stats(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "reset");
+  gboolean reset = ptr != nullptr && fl_value_get_bool(ptr);
+  SwPixelBufferStats stats;
+  int64_t frames_presented = -1;
+  ptr = fl_value_lookup_string(arguments, "texture");
+  if (ptr != nullptr && fl_value_get_type(ptr) != FL_VALUE_TYPE_NULL) {
+    SwPixelBuffer* buffer = sw_rend_plugin_lookup(plugin, fl_value_get_int(ptr));
+    if (buffer == nullptr) {
+      return FL_METHOD_RESPONSE(fl_method_error_response_new("INVALID", "Texture ID is not registered", fl_value_new_null()));
+    }
+    sw_pixel_buffer_get_stats(buffer, &stats, reset);
+    g_mutex_lock(&buffer->lock);
+    frames_presented = buffer->frames_presented;
+    g_mutex_unlock(&buffer->lock);
+  } else {
+    sw_pixel_buffer_get_global_stats(&stats, reset);
+  }
+  FlValue* result = fl_value_new_map();
+  fl_value_set_string_take(result, "draw_calls", fl_value_new_int(stats.draw_calls));
+  fl_value_set_string_take(result, "bytes_ingested", fl_value_new_int(stats.bytes_ingested));
+  fl_value_set_string_take(result, "draw_time_us", fl_value_new_int(stats.draw_time_us));
+  fl_value_set_string_take(result, "bytes_copied", fl_value_new_int(stats.bytes_copied));
+  fl_value_set_string_take(result, "invalidations", fl_value_new_int(stats.invalidations));
+  fl_value_set_string_take(result, "frames_dropped", fl_value_new_int(stats.frames_dropped));
+  fl_value_set_string_take(result, "copy_pixels_calls", fl_value_new_int(stats.copy_pixels_calls));
+  if (frames_presented >= 0) {
+    fl_value_set_string_take(result, "frames_presented", fl_value_new_int(frames_presented));
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Return the events traced so far as Chrome trace JSON, discarding them
+// unless told otherwise
+static FlMethodResponse* sw_rend_plugin_method_dump_trace(SwRendPlugin* plugin, FlValue* arguments) {
+  FlValue *ptr = fl_value_lookup_string(arguments, "clear");
+  gboolean clear = ptr == nullptr || fl_value_get_bool(ptr);
+  std::string json = sw_trace_dump_json(getpid(), clear);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(fl_value_new_string(json.c_str())));
+}
+
+static const struct {
+  const gchar* name;
+  MethodEntry entry;
+} method_entries[] = {
+    {"init", {sw_rend_plugin_method_init, FALSE}},
+    {"dispose", {sw_rend_plugin_method_dispose, TRUE}},
+    {"resize", {sw_rend_plugin_method_resize, TRUE}},
+    {"draw", {sw_rend_plugin_method_draw, TRUE}},
+    {"draw_batch", {sw_rend_plugin_method_draw_batch, TRUE}},
+    {"raster", {sw_rend_plugin_method_raster, TRUE}},
+    {"blit", {sw_rend_plugin_method_blit, TRUE}},
+    {"invalidate", {sw_rend_plugin_method_invalidate, TRUE}},
+    {"get_pixels", {sw_rend_plugin_method_read, TRUE}},
+    {"get_size", {sw_rend_plugin_method_get_size, TRUE}},
+    {"get_buffer_address", {sw_rend_plugin_method_get_buffer_address, TRUE}},
+    {"get_damage", {sw_rend_plugin_method_get_damage, TRUE}},
+    {"list_textures", {sw_rend_plugin_method_list, FALSE}},
+    {"configure", {sw_rend_plugin_method_configure, FALSE}},
+    {"get_pool_stats", {sw_rend_plugin_method_get_pool_stats, FALSE}},
+    {"get_stats", {sw_rend_plugin_method_get_stats, TRUE}},
+    {"start_recording", {sw_rend_plugin_method_start_recording, TRUE}},
+    {"stop_recording", {sw_rend_plugin_method_stop_recording, TRUE}},
+    {"dump_trace", {sw_rend_plugin_method_dump_trace, FALSE}},
+    {"add_sprite", {sw_rend_plugin_method_add_sprite, TRUE}},
+    {"remove_sprite", {sw_rend_plugin_method_remove_sprite, TRUE}},
+    {"blit_sprite", {sw_rend_plugin_method_blit_sprite, TRUE}},
+    {"blit_sprites", {sw_rend_plugin_method_blit_sprites, TRUE}},
+    {"get_sprite_stats", {sw_rend_plugin_method_get_sprite_stats, TRUE}},
+    {"set_tilemap", {sw_rend_plugin_method_set_tilemap, TRUE}},
+    {"remove_tilemap", {sw_rend_plugin_method_remove_tilemap, TRUE}},
+    {"set_tiles", {sw_rend_plugin_method_set_tiles, TRUE}},
+    {"scroll_tilemap", {sw_rend_plugin_method_scroll_tilemap, TRUE}},
+};
+
 static GHashTable* methods = nullptr;
 
+// A response produced on the render thread, on its way back to the
+// platform thread
+typedef struct {
+  FlMethodCall* method_call;
+  FlMethodResponse* response;
+} SwPendingResponse;
+
+static gboolean sw_rend_plugin_respond_cb(gpointer user_data) {
+  SwPendingResponse* pending = (SwPendingResponse*)user_data;
+  fl_method_call_respond(pending->method_call, pending->response, nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+static void sw_rend_plugin_free_response(gpointer user_data) {
+  SwPendingResponse* pending = (SwPendingResponse*)user_data;
+  g_object_unref(pending->method_call);
+  g_object_unref(pending->response);
+  g_free(pending);
+}
+
+// Run |func| on the arguments of |method_call|, traced under the method's name
+static FlMethodResponse* sw_rend_plugin_call(SwRendPlugin* plugin, MethodCallback func, FlMethodCall* method_call) {
+  const gchar* name = sw_trace_is_enabled() ? g_intern_string(fl_method_call_get_name(method_call)) : nullptr;
+  SW_TRACE_SCOPE("method", name);
+  return func(plugin, fl_method_call_get_args(method_call));
+}
+
+static void sw_rend_plugin_run_offloaded(gpointer owner, gpointer data, gpointer user_data) {
+  SwPendingResponse* pending = g_new(SwPendingResponse, 1);
+  pending->method_call = FL_METHOD_CALL(data);
+  pending->response = sw_rend_plugin_call(SW_REND_PLUGIN(owner), (MethodCallback)user_data, pending->method_call);
+  // Always queue the response on the platform thread. g_main_context_invoke
+  // would run it right here whenever the default context is free to acquire.
+  GSource* source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_DEFAULT);
+  g_source_set_callback(source, sw_rend_plugin_respond_cb, pending, sw_rend_plugin_free_response);
+  g_source_attach(source, g_main_context_default());
+  g_source_unref(source);
+}
+
+// Binary commands share the render thread with offloaded methods
+static SwRenderThread* sw_rend_plugin_get_render_thread(gpointer user_data) {
+  return SW_REND_PLUGIN(user_data)->render_thread;
+}
+
 // Called when a method call is received from Flutter.
 static void sw_rend_plugin_handle_method_call(
     SwRendPlugin* self,
@@ -182,12 +1056,23 @@ static void sw_rend_plugin_handle_method_call(
 
   const gchar* method = fl_method_call_get_name(method_call);
 
-  MethodCallback func = (MethodCallback)g_hash_table_lookup(methods, method);
-  if (func == nullptr) {
+  const MethodEntry* entry = (const MethodEntry*)g_hash_table_lookup(methods, method);
+  // Init is logged once it has run, since its result names the texture
+  if (self->command_log != nullptr && entry != nullptr && entry->func != sw_rend_plugin_method_init) {
+    sw_command_logger_log(self->command_log, method, fl_method_call_get_args(method_call), nullptr);
+  }
+  if (entry == nullptr) {
     response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  } else if (entry->offload && self->render_thread != nullptr) {
+    // The render thread responds once it gets to the call
+    sw_render_thread_push(self->render_thread, sw_rend_plugin_run_offloaded, g_object_ref(method_call),
+                          (gpointer)entry->func);
+    return;
   } else {
-    FlValue* args = fl_method_call_get_args(method_call);
-    response = func(self, args);
+    response = sw_rend_plugin_call(self, entry->func, method_call);
+    if (self->command_log != nullptr && entry->func == sw_rend_plugin_method_init) {
+      sw_command_logger_log(self->command_log, method, fl_method_call_get_args(method_call), response);
+    }
   }
 
   fl_method_call_respond(method_call, response, nullptr);
@@ -196,22 +1081,56 @@ static void sw_rend_plugin_handle_method_call(
 static void sw_rend_plugin_dispose(GObject* object) {
   g_print("Disposing of SW REND plugin\n");
   SwRendPlugin* plugin = SW_REND_PLUGIN(object);
+  if (plugin->render_thread != nullptr) {
+    sw_render_thread_free(plugin->render_thread);
+    plugin->render_thread = nullptr;
+  }
+  if (plugin->command_log != nullptr) {
+    sw_command_logger_free(plugin->command_log);
+    plugin->command_log = nullptr;
+  }
+  if (plugin->sprites != nullptr) {
+    sw_sprite_cache_free(plugin->sprites);
+    plugin->sprites = nullptr;
+  }
   GHashTableIter iter;
   g_hash_table_iter_init(&iter, plugin->textures);
   gpointer key, value;
   while(g_hash_table_iter_next(&iter, &key, &value)) {
+    sw_pixel_buffer_unregister((SwPixelBuffer*)value);
     sw_pixel_buffer_dispose((SwPixelBuffer*)value);
   }
   g_hash_table_destroy(plugin->textures);
+  // Give back the memory cached for textures that will not be created now
+  sw_pixel_pool_trim();
+  sw_frame_events_unregister(plugin->registrar);
+  // Textures still referenced elsewhere hold on to the pool until they go
+  if (plugin->workers != nullptr) {
+    sw_worker_pool_unref(plugin->workers);
+    plugin->workers = nullptr;
+  }
   G_OBJECT_CLASS(sw_rend_plugin_parent_class)->dispose(object);
 }
 
+static void sw_rend_plugin_finalize(GObject* object) {
+  SwRendPlugin* plugin = SW_REND_PLUGIN(object);
+  g_mutex_clear(&plugin->textures_lock);
+  G_OBJECT_CLASS(sw_rend_plugin_parent_class)->finalize(object);
+}
+
 static void sw_rend_plugin_class_init(SwRendPluginClass* klass) {
   G_OBJECT_CLASS(klass)->dispose = sw_rend_plugin_dispose;
+  G_OBJECT_CLASS(klass)->finalize = sw_rend_plugin_finalize;
 }
 
 static void sw_rend_plugin_init(SwRendPlugin* self) {
   self->textures = g_hash_table_new(g_direct_hash, g_direct_equal);
+  g_mutex_init(&self->textures_lock);
+  self->render_thread = nullptr;
+  self->command_log = nullptr;
+  self->sprites = sw_sprite_cache_new(SW_SPRITE_CACHE_DEFAULT_CAPACITY);
+  self->workers = sw_worker_pool_new(MIN((int)g_get_num_processors(), SW_WORKER_POOL_DEFAULT_WORKERS),
+                                     SW_WORKER_POOL_DEFAULT_THRESHOLD);
 }
 
 static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
@@ -224,15 +1143,18 @@ void sw_rend_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
   // Set up methods
   if (methods == nullptr) {
     methods = g_hash_table_new(g_str_hash, g_str_equal);
-    g_hash_table_insert(methods, (gpointer)"init", (gpointer)sw_rend_plugin_method_init);
-    g_hash_table_insert(methods, (gpointer)"dispose", (gpointer)sw_rend_plugin_method_dispose);
-    g_hash_table_insert(methods, (gpointer)"draw", (gpointer)sw_rend_plugin_method_draw);
-    g_hash_table_insert(methods, (gpointer)"invalidate", (gpointer)sw_rend_plugin_method_invalidate);
-    g_hash_table_insert(methods, (gpointer)"get_pixels", (gpointer)sw_rend_plugin_method_read);
-    g_hash_table_insert(methods, (gpointer)"get_size", (gpointer)sw_rend_plugin_method_get_size);
-    g_hash_table_insert(methods, (gpointer)"list_textures", (gpointer)sw_rend_plugin_method_list);
+    for (size_t i = 0; i < G_N_ELEMENTS(method_entries); i++) {
+      g_hash_table_insert(methods, (gpointer)method_entries[i].name, (gpointer)&method_entries[i].entry);
+    }
   }
 
+  // Any value other than 0 starts tracing right away, to catch start-up
+  const gchar* trace = g_getenv("SW_REND_TRACE");
+  if (trace != nullptr && *trace != '\0' && strcmp(trace, "0") != 0) {
+    sw_trace_set_enabled(true);
+  }
+  sw_trace_set_thread_name("platform");
+
   SwRendPlugin* plugin = SW_REND_PLUGIN(
       g_object_new(sw_rend_plugin_get_type(), nullptr));
 
@@ -248,7 +1170,20 @@ void sw_rend_plugin_register_with_registrar(FlPluginRegistrar* registrar) {
                                             g_object_ref(plugin),
                                             g_object_unref);
 
+  sw_binary_channel_register(fl_plugin_registrar_get_messenger(registrar), sw_rend_plugin_get_render_thread,
+                             g_object_ref(plugin), g_object_unref);
+  sw_frame_events_register(fl_plugin_registrar_get_messenger(registrar), plugin->registrar);
+
   g_print("Registering plugin and channel \"com.funguscow/sw_rend\"\n");
 
+  const gchar* command_log = g_getenv("SW_REND_COMMAND_LOG");
+  if (command_log != nullptr && *command_log != '\0') {
+    g_autoptr(GError) error = nullptr;
+    plugin->command_log = sw_command_logger_new(command_log, &error);
+    if (plugin->command_log == nullptr) {
+      g_warning("%s", error->message);
+    }
+  }
+
   g_object_unref(plugin);
 }
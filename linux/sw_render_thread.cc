@@ -0,0 +1,117 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "include/sw_rend/sw_render_thread.h"
+#include "sw_trace.h"
+
+#include <glib.h>
+
+typedef struct {
+  SwRenderTask task;
+  gpointer data;
+  gpointer user_data;
+} SwRenderCommand;
+
+struct _SwRenderThread {
+  GThread* thread;
+  gpointer owner;
+  SwRenderCommand ring[SW_RENDER_RING_SIZE];
+  // Free-running counts of commands pushed and taken. |head| is only written
+  // by the producer and |tail| only by the render thread.
+  gint head;
+  gint tail;
+  gint stopping;
+  // Only used to sleep when the ring is empty (render thread) or full
+  // (producer); each side sets its flag before checking the ring one last
+  // time, so the other side knows to wake it
+  GMutex lock;
+  GCond wake;
+  gint producer_waiting;
+  gint consumer_waiting;
+};
+
+static guint sw_render_thread_queued(SwRenderThread* thread) {
+  return (guint)g_atomic_int_get(&thread->head) - (guint)g_atomic_int_get(&thread->tail);
+}
+
+static void sw_render_thread_wake(SwRenderThread* thread, gint* waiting) {
+  if (g_atomic_int_get(waiting)) {
+    g_mutex_lock(&thread->lock);
+    g_cond_broadcast(&thread->wake);
+    g_mutex_unlock(&thread->lock);
+  }
+}
+
+static gpointer sw_render_thread_run(gpointer user_data) {
+  SwRenderThread* thread = (SwRenderThread*)user_data;
+  sw_trace_set_thread_name("sw_rend render");
+  while (TRUE) {
+    if (sw_render_thread_queued(thread) == 0) {
+      g_mutex_lock(&thread->lock);
+      g_atomic_int_set(&thread->consumer_waiting, 1);
+      while (sw_render_thread_queued(thread) == 0 && !g_atomic_int_get(&thread->stopping)) {
+        g_cond_wait(&thread->wake, &thread->lock);
+      }
+      g_atomic_int_set(&thread->consumer_waiting, 0);
+      g_mutex_unlock(&thread->lock);
+      if (sw_render_thread_queued(thread) == 0) {
+        break;
+      }
+    }
+    guint tail = (guint)g_atomic_int_get(&thread->tail);
+    SwRenderCommand command = thread->ring[tail % SW_RENDER_RING_SIZE];
+    g_atomic_int_set(&thread->tail, (gint)(tail + 1));
+    sw_render_thread_wake(thread, &thread->producer_waiting);
+    command.task(thread->owner, command.data, command.user_data);
+  }
+  return nullptr;
+}
+
+SwRenderThread* sw_render_thread_new(gpointer owner) {
+  SwRenderThread* thread = g_new0(SwRenderThread, 1);
+  thread->owner = owner;
+  g_mutex_init(&thread->lock);
+  g_cond_init(&thread->wake);
+  thread->thread = g_thread_new("sw_rend render", sw_render_thread_run, thread);
+  return thread;
+}
+
+void sw_render_thread_push(SwRenderThread* thread, SwRenderTask task, gpointer data, gpointer user_data) {
+  if (sw_render_thread_queued(thread) == SW_RENDER_RING_SIZE) {
+    g_mutex_lock(&thread->lock);
+    g_atomic_int_set(&thread->producer_waiting, 1);
+    while (sw_render_thread_queued(thread) == SW_RENDER_RING_SIZE) {
+      g_cond_wait(&thread->wake, &thread->lock);
+    }
+    g_atomic_int_set(&thread->producer_waiting, 0);
+    g_mutex_unlock(&thread->lock);
+  }
+  guint head = (guint)g_atomic_int_get(&thread->head);
+  thread->ring[head % SW_RENDER_RING_SIZE] = {task, data, user_data};
+  g_atomic_int_set(&thread->head, (gint)(head + 1));
+  sw_render_thread_wake(thread, &thread->consumer_waiting);
+}
+
+void sw_render_thread_free(SwRenderThread* thread) {
+  g_mutex_lock(&thread->lock);
+  g_atomic_int_set(&thread->stopping, 1);
+  g_cond_broadcast(&thread->wake);
+  g_mutex_unlock(&thread->lock);
+  g_thread_join(thread->thread);
+  g_cond_clear(&thread->wake);
+  g_mutex_clear(&thread->lock);
+  g_free(thread);
+}
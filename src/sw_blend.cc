@@ -0,0 +1,146 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_blend.h"
+#include "sw_simd.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(SW_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+// Rounded x / 255 for x in [0, 255 * 255]; the vector kernels use the same
+// formula so that every pixel comes out the same whichever path blends it
+static inline uint32_t sw_div255(uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+static void sw_blend_scalar(uint8_t* dst, const uint8_t* src, int64_t count, SwBlendMode mode) {
+  for (int64_t i = 0; i < count; i++, dst += 4, src += 4) {
+    uint32_t sa = src[3], da = dst[3];
+    uint32_t inv = 255 - sa;
+    switch (mode) {
+      case SW_BLEND_SRC:
+        memcpy(dst, src, 4);
+        break;
+      case SW_BLEND_SRC_OVER:
+        for (int c = 0; c < 4; c++) {
+          dst[c] = std::min<uint32_t>(src[c] + sw_div255(dst[c] * inv), 255);
+        }
+        break;
+      case SW_BLEND_SRC_OVER_STRAIGHT:
+        for (int c = 0; c < 3; c++) {
+          dst[c] = sw_div255(src[c] * sa + dst[c] * inv);
+        }
+        dst[3] = sw_div255(sa * 255 + da * inv);
+        break;
+      case SW_BLEND_ADD:
+        for (int c = 0; c < 4; c++) {
+          dst[c] = std::min<uint32_t>(src[c] + dst[c], 255);
+        }
+        break;
+      case SW_BLEND_MULTIPLY:
+        for (int c = 0; c < 3; c++) {
+          dst[c] = sw_div255(src[c] * dst[c]);
+        }
+        dst[3] = sa + da - sw_div255(sa * da);
+        break;
+      case SW_BLEND_SCREEN:
+        for (int c = 0; c < 4; c++) {
+          dst[c] = src[c] + dst[c] - sw_div255(src[c] * dst[c]);
+        }
+        break;
+    }
+  }
+}
+
+#if defined(SW_HAVE_SSE2)
+
+// The SSE2 kernels widen two pixels at a time to 16-bit lanes
+// [r0 g0 b0 a0 r1 g1 b1 a1], blend, and pack four pixels back per iteration.
+
+static inline __m128i sw_div255_epu16(__m128i x) {
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Broadcast each pixel's alpha lane across its four lanes
+static inline __m128i sw_alpha_epu16(__m128i v) {
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+static inline __m128i sw_blend_epu16(__m128i s, __m128i d, SwBlendMode mode) {
+  const __m128i full = _mm_set1_epi16(255);
+  const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  __m128i sa = sw_alpha_epu16(s);
+  __m128i inv = _mm_sub_epi16(full, sa);
+  switch (mode) {
+    case SW_BLEND_SRC_OVER:
+      return _mm_add_epi16(s, sw_div255_epu16(_mm_mullo_epi16(d, inv)));
+    case SW_BLEND_SRC_OVER_STRAIGHT: {
+      // Weighting the source alpha lane by 255 instead of sa gives
+      // sa + da * (1 - sa) from the same expression
+      __m128i weight = _mm_or_si128(_mm_andnot_si128(alpha_lanes, sa), _mm_and_si128(alpha_lanes, full));
+      return sw_div255_epu16(_mm_add_epi16(_mm_mullo_epi16(s, weight), _mm_mullo_epi16(d, inv)));
+    }
+    case SW_BLEND_MULTIPLY: {
+      __m128i product = sw_div255_epu16(_mm_mullo_epi16(s, d));
+      __m128i screen = _mm_sub_epi16(_mm_add_epi16(s, d), product);
+      return _mm_or_si128(_mm_andnot_si128(alpha_lanes, product), _mm_and_si128(alpha_lanes, screen));
+    }
+    case SW_BLEND_SCREEN:
+      return _mm_sub_epi16(_mm_add_epi16(s, d), sw_div255_epu16(_mm_mullo_epi16(s, d)));
+    default:
+      return s;
+  }
+}
+
+static void sw_blend_sse2(uint8_t* dst, const uint8_t* src, int64_t count, SwBlendMode mode) {
+  const __m128i zero = _mm_setzero_si128();
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + 4 * i));
+    __m128i result;
+    if (mode == SW_BLEND_ADD) {
+      result = _mm_adds_epu8(s, d);
+    } else {
+      __m128i lo = sw_blend_epu16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), mode);
+      __m128i hi = sw_blend_epu16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), mode);
+      result = _mm_packus_epi16(lo, hi);
+    }
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), result);
+  }
+  sw_blend_scalar(dst + 4 * i, src + 4 * i, count - i, mode);
+}
+
+#endif // SW_HAVE_SSE2
+
+void sw_blend_row(uint8_t* dst, const uint8_t* src, int64_t count, SwBlendMode mode) {
+  if (mode == SW_BLEND_SRC) {
+    memcpy(dst, src, 4 * count);
+    return;
+  }
+#if defined(SW_HAVE_SSE2)
+  sw_blend_sse2(dst, src, count, mode);
+#else
+  sw_blend_scalar(dst, src, count, mode);
+#endif
+}
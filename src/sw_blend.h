@@ -0,0 +1,50 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_BLEND_H_
+#define INCLUDE_SW_BLEND_H_
+
+#include <cstdint>
+
+// How drawn pixels combine with what is already in a texture. Every mode
+// works on each 8-bit channel independently; s and d are the source and
+// destination channels, sa and da their alphas, all scaled to [0, 1].
+// The values are part of the method channel protocol.
+typedef enum {
+  // d = s
+  SW_BLEND_SRC = 0,
+  // d = s + d * (1 - sa), for premultiplied sources
+  SW_BLEND_SRC_OVER = 1,
+  // d = s * sa + d * (1 - sa), da = sa + da * (1 - sa), for straight sources
+  SW_BLEND_SRC_OVER_STRAIGHT = 2,
+  // d = min(s + d, 1)
+  SW_BLEND_ADD = 3,
+  // d = s * d for color, da = sa + da - sa * da
+  SW_BLEND_MULTIPLY = 4,
+  // d = s + d - s * d
+  SW_BLEND_SCREEN = 5,
+} SwBlendMode;
+
+#define SW_BLEND_MODE_COUNT 6
+
+inline bool sw_blend_mode_is_valid(int64_t mode) {
+  return mode >= 0 && mode < SW_BLEND_MODE_COUNT;
+}
+
+// Blend |count| RGBA pixels from |src| onto |dst|
+void sw_blend_row(uint8_t* dst, const uint8_t* src, int64_t count, SwBlendMode mode);
+
+#endif //INCLUDE_SW_BLEND_H_
@@ -0,0 +1,130 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_capture.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static void sw_write_le32(uint8_t* data, uint32_t value) {
+  data[0] = (uint8_t)value;
+  data[1] = (uint8_t)(value >> 8);
+  data[2] = (uint8_t)(value >> 16);
+  data[3] = (uint8_t)(value >> 24);
+}
+
+static void sw_write_le64(uint8_t* data, uint64_t value) {
+  sw_write_le32(data, (uint32_t)value);
+  sw_write_le32(data + 4, (uint32_t)(value >> 32));
+}
+
+void sw_capture_read_damage(const SwSurface* surface, const SwDamage* damage, uint8_t* dst) {
+  for (int i = 0; i < damage->count; i++) {
+    SwRect rect = damage->rects[i];
+    sw_surface_read_rect(surface, dst, rect.x, rect.y, rect.width, rect.height);
+    dst += 4 * sw_rect_area(rect);
+  }
+}
+
+void sw_capture_apply(const SwSurface* surface, const SwCaptureFrame* frame) {
+  const uint8_t* src = frame->pixels;
+  for (int i = 0; i < frame->damage.count; i++) {
+    SwRect rect = frame->damage.rects[i];
+    sw_surface_draw_rect(surface, src, rect.x, rect.y, rect.width, rect.height, SW_PIXEL_FORMAT_RGBA8888,
+                         SW_BLEND_SRC, nullptr);
+    src += 4 * sw_rect_area(rect);
+  }
+}
+
+bool sw_capture_write_header(FILE* file) {
+  return fwrite(SW_CAPTURE_MAGIC, 1, SW_CAPTURE_MAGIC_SIZE, file) == SW_CAPTURE_MAGIC_SIZE;
+}
+
+bool sw_capture_write_frame(FILE* file, const SwCaptureFrame* frame) {
+  uint8_t header[SW_CAPTURE_FRAME_HEADER_SIZE + 16 * SW_DAMAGE_MAX_RECTS];
+  sw_write_le32(header, (uint32_t)frame->damage.count);
+  sw_write_le32(header + 4, frame->key ? SW_CAPTURE_FLAG_KEY : 0);
+  sw_write_le64(header + 8, (uint64_t)frame->timestamp_us);
+  sw_write_le32(header + 16, (uint32_t)frame->width);
+  sw_write_le32(header + 20, (uint32_t)frame->height);
+  uint8_t* out = header + SW_CAPTURE_FRAME_HEADER_SIZE;
+  for (int i = 0; i < frame->damage.count; i++) {
+    SwRect rect = frame->damage.rects[i];
+    sw_write_le32(out, (uint32_t)rect.x);
+    sw_write_le32(out + 4, (uint32_t)rect.y);
+    sw_write_le32(out + 8, (uint32_t)rect.width);
+    sw_write_le32(out + 12, (uint32_t)rect.height);
+    out += 16;
+  }
+  size_t header_size = out - header;
+  size_t pixels_size = 4 * sw_damage_area(&frame->damage);
+  return fwrite(header, 1, header_size, file) == header_size &&
+         (pixels_size == 0 || fwrite(frame->pixels, 1, pixels_size, file) == pixels_size);
+}
+
+bool sw_capture_write_y4m_header(FILE* file, int64_t width, int64_t height, int fps) {
+  return fprintf(file, "YUV4MPEG2 W%" PRId64 " H%" PRId64 " F%d:1 Ip A1:1 C420jpeg\n", width, height, fps) > 0;
+}
+
+int64_t sw_capture_y4m_frame_size(int64_t width, int64_t height) {
+  return width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+}
+
+static uint8_t sw_capture_clamp(int32_t value) {
+  return (uint8_t)std::min(std::max(value, 0), 255);
+}
+
+bool sw_capture_write_y4m_frame(FILE* file, const SwSurface* surface, uint8_t* scratch) {
+  int64_t width = surface->width;
+  int64_t height = surface->height;
+  int64_t chroma_width = (width + 1) / 2;
+  int64_t chroma_height = (height + 1) / 2;
+  uint8_t* luma = scratch;
+  uint8_t* cb = luma + width * height;
+  uint8_t* cr = cb + chroma_width * chroma_height;
+  for (int64_t y = 0; y < height; y++) {
+    const uint8_t* src = surface->pixels + 4 * y * width;
+    for (int64_t x = 0; x < width; x++) {
+      luma[y * width + x] = (uint8_t)((19595 * src[4 * x] + 38470 * src[4 * x + 1] + 7471 * src[4 * x + 2] + 32768) >> 16);
+    }
+  }
+  // Chroma is taken from the average of each 2x2 block, or of the part of it
+  // inside the frame along odd edges
+  for (int64_t cy = 0; cy < chroma_height; cy++) {
+    for (int64_t cx = 0; cx < chroma_width; cx++) {
+      int32_t r = 0, g = 0, b = 0, count = 0;
+      for (int64_t y = 2 * cy; y < std::min(2 * cy + 2, height); y++) {
+        for (int64_t x = 2 * cx; x < std::min(2 * cx + 2, width); x++) {
+          const uint8_t* pixel = surface->pixels + 4 * (y * width + x);
+          r += pixel[0];
+          g += pixel[1];
+          b += pixel[2];
+          count++;
+        }
+      }
+      r = (r + count / 2) / count;
+      g = (g + count / 2) / count;
+      b = (b + count / 2) / count;
+      cb[cy * chroma_width + cx] = sw_capture_clamp((-11059 * r - 21709 * g + 32768 * b + (128 << 16) + 32768) >> 16);
+      cr[cy * chroma_width + cx] = sw_capture_clamp((32768 * r - 27439 * g - 5329 * b + (128 << 16) + 32768) >> 16);
+    }
+  }
+  size_t size = sw_capture_y4m_frame_size(width, height);
+  return fputs("FRAME\n", file) >= 0 && fwrite(scratch, 1, size, file) == size;
+}
@@ -0,0 +1,91 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_CAPTURE_H_
+#define INCLUDE_SW_CAPTURE_H_
+
+#include <cstdint>
+#include <cstdio>
+
+#include "sw_damage.h"
+#include "sw_surface.h"
+
+// Capture files record the frames a texture presented. A raw capture is the
+// magic followed by one record per frame, with every integer little-endian:
+//
+//   uint32 rect count, uint32 flags, int64 timestamp in microseconds,
+//   int32 width, int32 height,
+//   rect count x (int32 x, int32 y, int32 width, int32 height),
+//   the pixels of each rect in turn, as tightly packed RGBA rows
+//
+// Each frame only holds the rects that changed since the one before, unless
+// it is a key frame.
+#define SW_CAPTURE_MAGIC "SWCAPT01"
+#define SW_CAPTURE_MAGIC_SIZE 8
+#define SW_CAPTURE_FRAME_HEADER_SIZE 24
+
+// The rects cover the whole frame, which does not depend on earlier ones
+#define SW_CAPTURE_FLAG_KEY 1
+
+// How captured frames are stored.
+// The values are part of the method channel protocol.
+typedef enum {
+  // Changed rects with timestamps, as above
+  SW_CAPTURE_RAW = 0,
+  // Every frame in full as YUV 4:2:0, playable by most video tools but
+  // without timestamps or a change of size
+  SW_CAPTURE_Y4M = 1,
+} SwCaptureFormat;
+
+#define SW_CAPTURE_FORMAT_COUNT 2
+
+inline bool sw_capture_format_is_valid(int64_t format) {
+  return format >= 0 && format < SW_CAPTURE_FORMAT_COUNT;
+}
+
+typedef struct {
+  int64_t timestamp_us;
+  int64_t width;
+  int64_t height;
+  bool key;
+  // Rects of the frame that changed, which never overlap
+  SwDamage damage;
+  // The pixels of each rect of |damage| in turn, as tightly packed RGBA rows
+  uint8_t* pixels;
+} SwCaptureFrame;
+
+// Copy the rects of |damage| out of |surface| into |dst|, laid out as
+// SwCaptureFrame::pixels
+void sw_capture_read_damage(const SwSurface* surface, const SwDamage* damage, uint8_t* dst);
+
+// Bring |surface|, which is the size of |frame|, up to date with |frame|
+void sw_capture_apply(const SwSurface* surface, const SwCaptureFrame* frame);
+
+bool sw_capture_write_header(FILE* file);
+
+bool sw_capture_write_frame(FILE* file, const SwCaptureFrame* frame);
+
+bool sw_capture_write_y4m_header(FILE* file, int64_t width, int64_t height, int fps);
+
+// Bytes of scratch space sw_capture_write_y4m_frame needs for a frame of
+// |width| x |height|
+int64_t sw_capture_y4m_frame_size(int64_t width, int64_t height);
+
+// Convert |surface| to full-range BT.601 YUV 4:2:0 in |scratch| and write it
+// as the next frame, ignoring alpha
+bool sw_capture_write_y4m_frame(FILE* file, const SwSurface* surface, uint8_t* scratch);
+
+#endif //INCLUDE_SW_CAPTURE_H_
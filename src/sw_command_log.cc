@@ -0,0 +1,114 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_command_log.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Largest payload a record may claim, to catch corrupt logs before
+// allocating for them
+#define SW_COMMAND_LOG_MAX_PAYLOAD (1u << 30)
+
+static void sw_write_le32(uint8_t* data, uint32_t value) {
+  data[0] = (uint8_t)value;
+  data[1] = (uint8_t)(value >> 8);
+  data[2] = (uint8_t)(value >> 16);
+  data[3] = (uint8_t)(value >> 24);
+}
+
+static void sw_write_le64(uint8_t* data, uint64_t value) {
+  sw_write_le32(data, (uint32_t)value);
+  sw_write_le32(data + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t sw_read_le32(const uint8_t* data) {
+  return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t sw_read_le64(const uint8_t* data) {
+  return (uint64_t)sw_read_le32(data) | ((uint64_t)sw_read_le32(data + 4) << 32);
+}
+
+bool sw_command_log_write_header(FILE* file) {
+  return fwrite(SW_COMMAND_LOG_MAGIC, 1, SW_COMMAND_LOG_MAGIC_SIZE, file) == SW_COMMAND_LOG_MAGIC_SIZE;
+}
+
+void sw_command_log_encode(const SwCommand* command, uint8_t* record) {
+  memset(record, 0, SW_COMMAND_LOG_RECORD_SIZE);
+  record[0] = (uint8_t)command->op;
+  record[1] = command->flags;
+  record[2] = command->format;
+  record[3] = command->blend;
+  record[4] = command->encoding;
+  record[5] = command->anchor;
+  sw_write_le32(record + 8, (uint32_t)command->payload_length);
+  sw_write_le64(record + 16, (uint64_t)command->timestamp_us);
+  sw_write_le64(record + 24, (uint64_t)command->texture);
+  sw_write_le32(record + 32, (uint32_t)command->x);
+  sw_write_le32(record + 36, (uint32_t)command->y);
+  sw_write_le32(record + 40, (uint32_t)command->width);
+  sw_write_le32(record + 44, (uint32_t)command->height);
+}
+
+bool sw_command_log_write(FILE* file, const SwCommand* command) {
+  uint8_t record[SW_COMMAND_LOG_RECORD_SIZE];
+  sw_command_log_encode(command, record);
+  return fwrite(record, 1, sizeof(record), file) == sizeof(record) &&
+         (command->payload_length == 0 ||
+          fwrite(command->payload, 1, command->payload_length, file) == command->payload_length);
+}
+
+bool sw_command_log_read_header(FILE* file) {
+  char magic[SW_COMMAND_LOG_MAGIC_SIZE];
+  return fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+         memcmp(magic, SW_COMMAND_LOG_MAGIC, sizeof(magic)) == 0;
+}
+
+int sw_command_log_read(FILE* file, SwCommand* command, std::vector<uint8_t>* payload) {
+  uint8_t record[SW_COMMAND_LOG_RECORD_SIZE];
+  size_t read = fread(record, 1, sizeof(record), file);
+  if (read == 0) {
+    return 0;
+  }
+  if (read != sizeof(record) || record[0] >= SW_COMMAND_OP_COUNT) {
+    return -1;
+  }
+  command->op = (SwCommandOp)record[0];
+  command->flags = record[1];
+  command->format = record[2];
+  command->blend = record[3];
+  command->encoding = record[4];
+  command->anchor = record[5];
+  command->payload_length = sw_read_le32(record + 8);
+  command->timestamp_us = (int64_t)sw_read_le64(record + 16);
+  command->texture = (int64_t)sw_read_le64(record + 24);
+  command->x = (int32_t)sw_read_le32(record + 32);
+  command->y = (int32_t)sw_read_le32(record + 36);
+  command->width = (int32_t)sw_read_le32(record + 40);
+  command->height = (int32_t)sw_read_le32(record + 44);
+  if (command->payload_length > SW_COMMAND_LOG_MAX_PAYLOAD) {
+    return -1;
+  }
+  payload->resize(command->payload_length);
+  if (command->payload_length > 0 && fread(payload->data(), 1, command->payload_length, file) != command->payload_length) {
+    return -1;
+  }
+  command->payload = payload->data();
+  return 1;
+}
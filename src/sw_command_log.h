@@ -0,0 +1,98 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_COMMAND_LOG_H_
+#define INCLUDE_SW_COMMAND_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Command logs record the calls a plugin received, so that sw_rend_replay
+// can run them again without an app. A log is the magic followed by one
+// record per command, with every integer little-endian:
+//
+//   uint8 op, uint8 flags, uint8 format, uint8 blend, uint8 encoding,
+//   uint8 anchor, 2 bytes reserved, uint32 payload length, 4 bytes reserved,
+//   int64 timestamp in microseconds since the log started, int64 texture,
+//   int32 x, int32 y, int32 width, int32 height,
+//   the payload
+#define SW_COMMAND_LOG_MAGIC "SWCMDL01"
+#define SW_COMMAND_LOG_MAGIC_SIZE 8
+#define SW_COMMAND_LOG_RECORD_SIZE 48
+
+typedef enum {
+  // Create a |width| x |height| texture, known as |texture| from then on
+  SW_COMMAND_INIT = 0,
+  SW_COMMAND_DISPOSE = 1,
+  // Resize to |width| x |height| around |anchor|
+  SW_COMMAND_RESIZE = 2,
+  // Draw the payload, |format| pixels or |encoding| encoded, to the |width|
+  // x |height| rect at (|x|, |y|) with |blend|. A width or height of -1
+  // stands for the texture's own.
+  SW_COMMAND_DRAW = 3,
+  // Run the payload as an int32 raster command list
+  SW_COMMAND_RASTER = 4,
+  SW_COMMAND_INVALIDATE = 5,
+  // A call that changed |texture| in a way the log cannot capture, such as a
+  // blit, sprite or tilemap, named by the payload. The texture no longer
+  // matches the app's from here on in a replay.
+  SW_COMMAND_UNLOGGED = 6,
+} SwCommandOp;
+
+#define SW_COMMAND_OP_COUNT 7
+
+// Init: the texture is tear-free
+#define SW_COMMAND_FLAG_TEAR_FREE 1
+// Draw: the rect was written in place through the texture's address, so
+// there is no payload
+#define SW_COMMAND_FLAG_IN_PLACE 2
+
+typedef struct {
+  SwCommandOp op;
+  uint8_t flags;
+  uint8_t format;
+  uint8_t blend;
+  uint8_t encoding;
+  uint8_t anchor;
+  int64_t timestamp_us;
+  int64_t texture;
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+  const uint8_t* payload;
+  size_t payload_length;
+} SwCommand;
+
+bool sw_command_log_write_header(FILE* file);
+
+// Fill the SW_COMMAND_LOG_RECORD_SIZE bytes at |record| with the record of
+// |command|, which its payload follows in a log
+void sw_command_log_encode(const SwCommand* command, uint8_t* record);
+
+bool sw_command_log_write(FILE* file, const SwCommand* command);
+
+// Check the magic at the start of |file|
+bool sw_command_log_read_header(FILE* file);
+
+// Read the next command into |command|, pointing its payload into |payload|,
+// which is reused. Returns 1 on success, 0 at the end of the log and -1 if
+// the record is cut short or malformed.
+int sw_command_log_read(FILE* file, SwCommand* command, std::vector<uint8_t>* payload);
+
+#endif //INCLUDE_SW_COMMAND_LOG_H_
@@ -0,0 +1,108 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_damage.h"
+
+#include <algorithm>
+#include <cstdint>
+
+SwRect sw_rect_intersect(SwRect a, SwRect b) {
+  int64_t x0 = std::max(a.x, b.x);
+  int64_t y0 = std::max(a.y, b.y);
+  int64_t x1 = std::min(a.x + a.width, b.x + b.width);
+  int64_t y1 = std::min(a.y + a.height, b.y + b.height);
+  return {x0, y0, std::max<int64_t>(x1 - x0, 0), std::max<int64_t>(y1 - y0, 0)};
+}
+
+SwRect sw_rect_union(SwRect a, SwRect b) {
+  if (sw_rect_is_empty(a)) {
+    return b;
+  }
+  if (sw_rect_is_empty(b)) {
+    return a;
+  }
+  int64_t x0 = std::min(a.x, b.x);
+  int64_t y0 = std::min(a.y, b.y);
+  int64_t x1 = std::max(a.x + a.width, b.x + b.width);
+  int64_t y1 = std::max(a.y + a.height, b.y + b.height);
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+// Whether |a| and |b| overlap or share an edge
+static bool sw_rect_touches(SwRect a, SwRect b) {
+  return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+         a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static void sw_damage_remove(SwDamage* damage, int index) {
+  damage->rects[index] = damage->rects[--damage->count];
+}
+
+void sw_damage_clear(SwDamage* damage) {
+  damage->count = 0;
+}
+
+void sw_damage_add(SwDamage* damage, SwRect rect) {
+  if (sw_rect_is_empty(rect)) {
+    return;
+  }
+  // Swallow every rect the new one touches, repeating since the grown rect
+  // may now reach rects it did not before
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (int i = 0; i < damage->count; i++) {
+      if (sw_rect_touches(damage->rects[i], rect)) {
+        rect = sw_rect_union(rect, damage->rects[i]);
+        sw_damage_remove(damage, i);
+        merged = true;
+        break;
+      }
+    }
+  }
+  if (damage->count < SW_DAMAGE_MAX_RECTS) {
+    damage->rects[damage->count++] = rect;
+    return;
+  }
+  // Out of room, so merge with whichever rect grows the least and start over
+  int best = 0;
+  int64_t best_growth = INT64_MAX;
+  for (int i = 0; i < damage->count; i++) {
+    SwRect other = damage->rects[i];
+    int64_t growth = sw_rect_area(sw_rect_union(rect, other)) - sw_rect_area(rect) - sw_rect_area(other);
+    if (growth < best_growth) {
+      best = i;
+      best_growth = growth;
+    }
+  }
+  rect = sw_rect_union(rect, damage->rects[best]);
+  sw_damage_remove(damage, best);
+  sw_damage_add(damage, rect);
+}
+
+void sw_damage_add_damage(SwDamage* damage, const SwDamage* other) {
+  for (int i = 0; i < other->count; i++) {
+    sw_damage_add(damage, other->rects[i]);
+  }
+}
+
+int64_t sw_damage_area(const SwDamage* damage) {
+  int64_t area = 0;
+  for (int i = 0; i < damage->count; i++) {
+    area += sw_rect_area(damage->rects[i]);
+  }
+  return area;
+}
@@ -0,0 +1,56 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_DAMAGE_H_
+#define INCLUDE_SW_DAMAGE_H_
+
+#include <cstdint>
+
+// Most rects a SwDamage keeps before merging them together
+#define SW_DAMAGE_MAX_RECTS 16
+
+typedef struct {
+  int64_t x;
+  int64_t y;
+  int64_t width;
+  int64_t height;
+} SwRect;
+
+// Region accumulated from a series of rects. Overlapping or touching rects are
+// merged into their bounding box, so the stored rects never overlap and their
+// area is at least the area actually covered.
+typedef struct {
+  SwRect rects[SW_DAMAGE_MAX_RECTS];
+  int count;
+} SwDamage;
+
+inline bool sw_rect_is_empty(SwRect rect) {
+  return rect.width <= 0 || rect.height <= 0;
+}
+
+inline int64_t sw_rect_area(SwRect rect) {
+  return sw_rect_is_empty(rect) ? 0 : rect.width * rect.height;
+}
+
+SwRect sw_rect_intersect(SwRect a, SwRect b);
+SwRect sw_rect_union(SwRect a, SwRect b);
+
+void sw_damage_clear(SwDamage* damage);
+void sw_damage_add(SwDamage* damage, SwRect rect);
+void sw_damage_add_damage(SwDamage* damage, const SwDamage* other);
+int64_t sw_damage_area(const SwDamage* damage);
+
+#endif //INCLUDE_SW_DAMAGE_H_
@@ -0,0 +1,297 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_pixel_convert.h"
+#include "sw_simd.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(SW_HAVE_X86)
+#define SW_CONVERT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+typedef void (*SwConvertRow)(uint8_t* dst, const uint8_t* src, int64_t count);
+
+int sw_pixel_format_bytes_per_pixel(SwPixelFormat format) {
+  switch (format) {
+    case SW_PIXEL_FORMAT_RGBA8888:
+    case SW_PIXEL_FORMAT_BGRA8888:
+      return 4;
+    case SW_PIXEL_FORMAT_RGB888:
+      return 3;
+    case SW_PIXEL_FORMAT_RGB565:
+      return 2;
+    case SW_PIXEL_FORMAT_GRAY8:
+      return 1;
+  }
+  return 4;
+}
+
+// Scalar kernels, used on other architectures and for the tail of each row
+
+static void sw_convert_rgba8888(uint8_t* dst, const uint8_t* src, int64_t count) {
+  memcpy(dst, src, 4 * count);
+}
+
+static void sw_convert_bgra8888(uint8_t* dst, const uint8_t* src, int64_t count) {
+  for (int64_t i = 0; i < count; i++, dst += 4, src += 4) {
+    dst[0] = src[2];
+    dst[1] = src[1];
+    dst[2] = src[0];
+    dst[3] = src[3];
+  }
+}
+
+static void sw_convert_rgb888(uint8_t* dst, const uint8_t* src, int64_t count) {
+  for (int64_t i = 0; i < count; i++, dst += 4, src += 3) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = 0xff;
+  }
+}
+
+static void sw_convert_rgb565(uint8_t* dst, const uint8_t* src, int64_t count) {
+  for (int64_t i = 0; i < count; i++, dst += 4, src += 2) {
+    uint16_t pixel = src[0] | (src[1] << 8);
+    uint8_t r = pixel >> 11, g = (pixel >> 5) & 0x3f, b = pixel & 0x1f;
+    dst[0] = (r << 3) | (r >> 2);
+    dst[1] = (g << 2) | (g >> 4);
+    dst[2] = (b << 3) | (b >> 2);
+    dst[3] = 0xff;
+  }
+}
+
+static void sw_convert_gray8(uint8_t* dst, const uint8_t* src, int64_t count) {
+  for (int64_t i = 0; i < count; i++, dst += 4, src++) {
+    dst[0] = dst[1] = dst[2] = *src;
+    dst[3] = 0xff;
+  }
+}
+
+static const SwConvertRow sw_convert_scalar[SW_PIXEL_FORMAT_COUNT] = {
+  sw_convert_rgba8888,
+  sw_convert_bgra8888,
+  sw_convert_rgb888,
+  sw_convert_rgb565,
+  sw_convert_gray8,
+};
+
+#ifdef SW_CONVERT_X86
+
+// SSE2 kernels. There is no byte shuffle before SSSE3, so packed RGB888 is
+// left to the scalar kernel at this level.
+
+SW_TARGET("sse2")
+static void sw_convert_bgra8888_sse2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m128i ga_mask = _mm_set1_epi32((int)0xff00ff00);
+  const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+  int64_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+    __m128i rb = _mm_and_si128(v, rb_mask);
+    rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_or_si128(_mm_and_si128(v, ga_mask), rb));
+  }
+  sw_convert_bgra8888(dst + 4 * i, src + 4 * i, count - i);
+}
+
+SW_TARGET("sse2")
+static void sw_convert_rgb565_sse2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m128i mask5 = _mm_set1_epi16(0x1f);
+  const __m128i mask6 = _mm_set1_epi16(0x3f);
+  const __m128i alpha = _mm_set1_epi16((short)0xff00);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + 2 * i));
+    __m128i r = _mm_and_si128(_mm_srli_epi16(v, 11), mask5);
+    __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+    __m128i b = _mm_and_si128(v, mask5);
+    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+    g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+    __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    __m128i ba = _mm_or_si128(b, alpha);
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i + 16), _mm_unpackhi_epi16(rg, ba));
+  }
+  sw_convert_rgb565(dst + 4 * i, src + 2 * i, count - i);
+}
+
+SW_TARGET("sse2")
+static void sw_convert_gray8_sse2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m128i alpha = _mm_set1_epi8((char)0xff);
+  int64_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i gg_lo = _mm_unpacklo_epi8(v, v);
+    __m128i gg_hi = _mm_unpackhi_epi8(v, v);
+    __m128i ga_lo = _mm_unpacklo_epi8(v, alpha);
+    __m128i ga_hi = _mm_unpackhi_epi8(v, alpha);
+    uint8_t* out = dst + 4 * i;
+    _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(gg_lo, ga_lo));
+    _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(gg_lo, ga_lo));
+    _mm_storeu_si128((__m128i*)(out + 32), _mm_unpacklo_epi16(gg_hi, ga_hi));
+    _mm_storeu_si128((__m128i*)(out + 48), _mm_unpackhi_epi16(gg_hi, ga_hi));
+  }
+  sw_convert_gray8(dst + 4 * i, src + i, count - i);
+}
+
+static const SwConvertRow sw_convert_sse2[SW_PIXEL_FORMAT_COUNT] = {
+  sw_convert_rgba8888,
+  sw_convert_bgra8888_sse2,
+  sw_convert_rgb888,
+  sw_convert_rgb565_sse2,
+  sw_convert_gray8_sse2,
+};
+
+// AVX2 kernels
+
+SW_TARGET("avx2")
+static void sw_convert_bgra8888_avx2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m256i swap = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + 4 * i));
+    _mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_shuffle_epi8(v, swap));
+  }
+  sw_convert_bgra8888(dst + 4 * i, src + 4 * i, count - i);
+}
+
+SW_TARGET("avx2")
+static void sw_convert_rgb888_avx2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  // Spread four 3-byte pixels across four 4-byte slots per 128-bit lane
+  const __m256i spread = _mm256_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+  int64_t i = 0;
+  // Each step reads 28 bytes for 24 bytes of pixels, so stop while that stays
+  // inside the source
+  for (; i + 10 <= count; i += 8) {
+    __m128i lo = _mm_loadu_si128((const __m128i*)(src + 3 * i));
+    __m128i hi = _mm_loadu_si128((const __m128i*)(src + 3 * i + 12));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    _mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_or_si256(_mm256_shuffle_epi8(v, spread), alpha));
+  }
+  sw_convert_rgb888(dst + 4 * i, src + 3 * i, count - i);
+}
+
+SW_TARGET("avx2")
+static void sw_convert_rgb565_avx2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m256i mask5 = _mm256_set1_epi16(0x1f);
+  const __m256i mask6 = _mm256_set1_epi16(0x3f);
+  const __m256i alpha = _mm256_set1_epi16((short)0xff00);
+  int64_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + 2 * i));
+    __m256i r = _mm256_and_si256(_mm256_srli_epi16(v, 11), mask5);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi16(v, 5), mask6);
+    __m256i b = _mm256_and_si256(v, mask5);
+    r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+    g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+    b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+    __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+    __m256i ba = _mm256_or_si256(b, alpha);
+    // Unpacking works within 128-bit lanes, so put the halves back in order
+    __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+    __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+    _mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 4 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  sw_convert_rgb565(dst + 4 * i, src + 2 * i, count - i);
+}
+
+SW_TARGET("avx2")
+static void sw_convert_gray8_avx2(uint8_t* dst, const uint8_t* src, int64_t count) {
+  const __m256i splat = _mm256_set1_epi32(0x00010101);
+  const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+  int64_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+    _mm256_storeu_si256((__m256i*)(dst + 4 * i), _mm256_or_si256(_mm256_mullo_epi32(v, splat), alpha));
+  }
+  sw_convert_gray8(dst + 4 * i, src + i, count - i);
+}
+
+static const SwConvertRow sw_convert_avx2[SW_PIXEL_FORMAT_COUNT] = {
+  sw_convert_rgba8888,
+  sw_convert_bgra8888_avx2,
+  sw_convert_rgb888_avx2,
+  sw_convert_rgb565_avx2,
+  sw_convert_gray8_avx2,
+};
+
+#endif // SW_CONVERT_X86
+
+#if defined(SW_CONVERT_X86) && defined(_MSC_VER)
+// MSVC has no __builtin_cpu_supports, so ask CPUID directly. AVX2 also needs
+// the OS to save the wider registers, which XGETBV reports.
+static bool sw_convert_has_avx2() {
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  const int osxsave_avx = (1 << 27) | (1 << 28);
+  if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+}
+
+static bool sw_convert_has_sse2() {
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+}
+#elif defined(SW_CONVERT_X86)
+static bool sw_convert_has_avx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+static bool sw_convert_has_sse2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse2");
+}
+#endif
+
+static const SwConvertRow* sw_convert_select() {
+#ifdef SW_CONVERT_X86
+  if (sw_convert_has_avx2()) {
+    return sw_convert_avx2;
+  }
+  if (sw_convert_has_sse2()) {
+    return sw_convert_sse2;
+  }
+#endif
+  return sw_convert_scalar;
+}
+
+void sw_pixel_convert_row(uint8_t* dst, const uint8_t* src, int64_t count, SwPixelFormat format) {
+  static const SwConvertRow* kernels = sw_convert_select();
+  kernels[format](dst, src, count);
+}
@@ -0,0 +1,48 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_PIXEL_CONVERT_H_
+#define INCLUDE_SW_PIXEL_CONVERT_H_
+
+#include <cstdint>
+
+// Layouts pixel data can be supplied in. Textures always store RGBA8888.
+// The values are part of the method channel protocol.
+typedef enum {
+  SW_PIXEL_FORMAT_RGBA8888 = 0,
+  // Red and blue swapped, as produced by most Cairo and X11 surfaces
+  SW_PIXEL_FORMAT_BGRA8888 = 1,
+  // Packed 3-byte pixels, drawn opaque
+  SW_PIXEL_FORMAT_RGB888 = 2,
+  // Little-endian 16-bit pixels with red in the high bits, drawn opaque
+  SW_PIXEL_FORMAT_RGB565 = 3,
+  // One luminance byte per pixel, drawn opaque
+  SW_PIXEL_FORMAT_GRAY8 = 4,
+} SwPixelFormat;
+
+#define SW_PIXEL_FORMAT_COUNT 5
+
+inline bool sw_pixel_format_is_valid(int64_t format) {
+  return format >= 0 && format < SW_PIXEL_FORMAT_COUNT;
+}
+
+int sw_pixel_format_bytes_per_pixel(SwPixelFormat format);
+
+// Convert |count| pixels of |format| from |src| to RGBA8888 at |dst|, using
+// the widest vector instructions the CPU supports
+void sw_pixel_convert_row(uint8_t* dst, const uint8_t* src, int64_t count, SwPixelFormat format);
+
+#endif //INCLUDE_SW_PIXEL_CONVERT_H_
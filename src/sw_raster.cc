@@ -0,0 +1,242 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_raster.h"
+#include "sw_damage.h"
+#include "sw_simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(SW_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+  uint8_t* pixels;
+  int64_t width;
+  int64_t height;
+  SwDamage* damage;
+  SwWorkerPool* workers;
+} SwRasterTarget;
+
+// One fill handed to the worker pool
+typedef struct {
+  SwRasterTarget* target;
+  SwRect clip;
+  uint32_t color;
+} SwRasterFill;
+
+static int sw_raster_operand_count(int32_t opcode) {
+  switch (opcode) {
+    case SW_RASTER_CLEAR:
+      return 1;
+    case SW_RASTER_FILL_RECT:
+    case SW_RASTER_LINE:
+    case SW_RASTER_STROKE_RECT:
+      return 5;
+    case SW_RASTER_HSPAN:
+    case SW_RASTER_VSPAN:
+    case SW_RASTER_FILL_CIRCLE:
+      return 4;
+  }
+  return -1;
+}
+
+int64_t sw_raster_validate(const int32_t* commands, size_t length) {
+  size_t i = 0;
+  int64_t index = 0;
+  while (i < length) {
+    int operands = sw_raster_operand_count(commands[i]);
+    if (operands < 0 || i + 1 + operands > length) {
+      return index;
+    }
+    i += 1 + operands;
+    index++;
+  }
+  return -1;
+}
+
+void sw_raster_fill_span(uint8_t* dst, int64_t count, uint32_t color) {
+  int64_t i = 0;
+#if defined(SW_HAVE_SSE2)
+  __m128i fill = _mm_set1_epi32((int)color);
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), fill);
+  }
+#endif
+  for (; i < count; i++) {
+    memcpy(dst + 4 * i, &color, 4);
+  }
+}
+
+static void sw_raster_fill_band(int64_t start, int64_t end, void* user_data) {
+  SwRasterFill* fill = (SwRasterFill*)user_data;
+  SwRasterTarget* target = fill->target;
+  for (int64_t y = fill->clip.y + start; y < fill->clip.y + end; y++) {
+    sw_raster_fill_span(target->pixels + 4 * (y * target->width + fill->clip.x), fill->clip.width, fill->color);
+  }
+}
+
+// Fill |rect| clipped to the target
+static void sw_raster_fill(SwRasterTarget* target, SwRect rect, uint32_t color) {
+  SwRect clip = sw_rect_intersect(rect, {0, 0, target->width, target->height});
+  if (sw_rect_is_empty(clip)) {
+    return;
+  }
+  SwRasterFill fill = {target, clip, color};
+  sw_worker_pool_run(target->workers, clip.height, 4 * sw_rect_area(clip), sw_raster_fill_band, &fill);
+  sw_damage_add(target->damage, clip);
+}
+
+static void sw_raster_plot(SwRasterTarget* target, int64_t x, int64_t y, uint32_t color) {
+  if (x >= 0 && y >= 0 && x < target->width && y < target->height) {
+    memcpy(target->pixels + 4 * (y * target->width + x), &color, 4);
+  }
+}
+
+// Shorten a line to the part that can touch the target, so that lines with far
+// off-screen endpoints cost no more than the pixels they draw. Returns false
+// if none of it does.
+static bool sw_raster_clip_line(SwRasterTarget* target, int64_t* x0, int64_t* y0, int64_t* x1, int64_t* y1) {
+  double dx = (double)(*x1 - *x0), dy = (double)(*y1 - *y0);
+  double p[4] = {-dx, dx, -dy, dy};
+  double q[4] = {(double)(*x0 + 1), (double)(target->width - *x0), (double)(*y0 + 1), (double)(target->height - *y0)};
+  double t0 = 0, t1 = 1;
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0) {
+      if (q[i] < 0) {
+        return false;
+      }
+      continue;
+    }
+    double t = q[i] / p[i];
+    if (p[i] < 0) {
+      t0 = std::max(t0, t);
+    } else {
+      t1 = std::min(t1, t);
+    }
+  }
+  if (t0 > t1) {
+    return false;
+  }
+  int64_t sx = *x0, sy = *y0;
+  *x0 = sx + (int64_t)std::lround(t0 * dx);
+  *y0 = sy + (int64_t)std::lround(t0 * dy);
+  *x1 = sx + (int64_t)std::lround(t1 * dx);
+  *y1 = sy + (int64_t)std::lround(t1 * dy);
+  return true;
+}
+
+static void sw_raster_line(SwRasterTarget* target, int64_t x0, int64_t y0, int64_t x1, int64_t y1, uint32_t color) {
+  if (y0 == y1) {
+    sw_raster_fill(target, {std::min(x0, x1), y0, std::abs(x1 - x0) + 1, 1}, color);
+    return;
+  }
+  if (x0 == x1) {
+    sw_raster_fill(target, {x0, std::min(y0, y1), 1, std::abs(y1 - y0) + 1}, color);
+    return;
+  }
+  if (!sw_raster_clip_line(target, &x0, &y0, &x1, &y1)) {
+    return;
+  }
+  SwRect bounds = {std::min(x0, x1), std::min(y0, y1), std::abs(x1 - x0) + 1, std::abs(y1 - y0) + 1};
+  sw_damage_add(target->damage, sw_rect_intersect(bounds, {0, 0, target->width, target->height}));
+  int64_t dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int64_t dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int64_t err = dx + dy;
+  while (true) {
+    sw_raster_plot(target, x0, y0, color);
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int64_t e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+static void sw_raster_stroke_rect(SwRasterTarget* target, SwRect rect, uint32_t color) {
+  if (sw_rect_is_empty(rect)) {
+    return;
+  }
+  sw_raster_fill(target, {rect.x, rect.y, rect.width, 1}, color);
+  sw_raster_fill(target, {rect.x, rect.y + rect.height - 1, rect.width, 1}, color);
+  sw_raster_fill(target, {rect.x, rect.y + 1, 1, rect.height - 2}, color);
+  sw_raster_fill(target, {rect.x + rect.width - 1, rect.y + 1, 1, rect.height - 2}, color);
+}
+
+static void sw_raster_fill_circle(SwRasterTarget* target, int64_t cx, int64_t cy, int64_t radius, uint32_t color) {
+  if (radius < 0) {
+    return;
+  }
+  int64_t y0 = std::max<int64_t>(cy - radius, 0);
+  int64_t y1 = std::min<int64_t>(cy + radius, target->height - 1);
+  for (int64_t y = y0; y <= y1; y++) {
+    int64_t dy = y - cy;
+    int64_t half = (int64_t)std::sqrt((double)(radius * radius - dy * dy));
+    int64_t x0 = std::max<int64_t>(cx - half, 0);
+    int64_t x1 = std::min<int64_t>(cx + half, target->width - 1);
+    if (x0 <= x1) {
+      sw_raster_fill_span(target->pixels + 4 * (y * target->width + x0), x1 - x0 + 1, color);
+    }
+  }
+  SwRect bounds = {cx - radius, cy - radius, 2 * radius + 1, 2 * radius + 1};
+  sw_damage_add(target->damage, sw_rect_intersect(bounds, {0, 0, target->width, target->height}));
+}
+
+void sw_raster_execute(uint8_t* pixels, int64_t width, int64_t height,
+                       const int32_t* commands, size_t length, SwDamage* damage,
+                       SwWorkerPool* workers) {
+  SwRasterTarget target = {pixels, width, height, damage, workers};
+  size_t i = 0;
+  while (i < length) {
+    const int32_t* op = commands + i;
+    switch (op[0]) {
+      case SW_RASTER_CLEAR:
+        sw_raster_fill(&target, {0, 0, width, height}, (uint32_t)op[1]);
+        break;
+      case SW_RASTER_FILL_RECT:
+        sw_raster_fill(&target, {op[1], op[2], op[3], op[4]}, (uint32_t)op[5]);
+        break;
+      case SW_RASTER_HSPAN:
+        sw_raster_fill(&target, {op[1], op[2], op[3], 1}, (uint32_t)op[4]);
+        break;
+      case SW_RASTER_VSPAN:
+        sw_raster_fill(&target, {op[1], op[2], 1, op[3]}, (uint32_t)op[4]);
+        break;
+      case SW_RASTER_LINE:
+        sw_raster_line(&target, op[1], op[2], op[3], op[4], (uint32_t)op[5]);
+        break;
+      case SW_RASTER_STROKE_RECT:
+        sw_raster_stroke_rect(&target, {op[1], op[2], op[3], op[4]}, (uint32_t)op[5]);
+        break;
+      case SW_RASTER_FILL_CIRCLE:
+        sw_raster_fill_circle(&target, op[1], op[2], op[3], (uint32_t)op[4]);
+        break;
+    }
+    i += 1 + sw_raster_operand_count(op[0]);
+  }
+}
@@ -0,0 +1,61 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_RASTER_H_
+#define INCLUDE_SW_RASTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sw_damage.h"
+#include "sw_worker_pool.h"
+
+// Opcodes of a raster command list. Each command is its opcode followed by
+// the listed int32 operands. Colors are RGBA with red in the low byte, so
+// they land in memory in the same order as texture pixels.
+// The values are part of the method channel protocol.
+typedef enum {
+  // color
+  SW_RASTER_CLEAR = 0,
+  // x, y, width, height, color
+  SW_RASTER_FILL_RECT = 1,
+  // x, y, length, color
+  SW_RASTER_HSPAN = 2,
+  // x, y, length, color
+  SW_RASTER_VSPAN = 3,
+  // x0, y0, x1, y1, color; both endpoints are drawn
+  SW_RASTER_LINE = 4,
+  // x, y, width, height, color; a one pixel outline
+  SW_RASTER_STROKE_RECT = 5,
+  // center x, center y, radius, color
+  SW_RASTER_FILL_CIRCLE = 6,
+} SwRasterOpcode;
+
+// Check that |commands| is a well formed command list. Returns the index of
+// the first bad command, or -1 if there is none.
+int64_t sw_raster_validate(const int32_t* commands, size_t length);
+
+// Run a command list validated with sw_raster_validate against a |width| x
+// |height| RGBA image, adding everything drawn to |damage|. Large fills are
+// split across |workers| if given.
+void sw_raster_execute(uint8_t* pixels, int64_t width, int64_t height,
+                       const int32_t* commands, size_t length, SwDamage* damage,
+                       SwWorkerPool* workers = nullptr);
+
+// Fill |count| pixels starting at |dst| with |color|
+void sw_raster_fill_span(uint8_t* dst, int64_t count, uint32_t color);
+
+#endif //INCLUDE_SW_RASTER_H_
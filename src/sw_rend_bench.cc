@@ -0,0 +1,117 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+// Measures the throughput of the pixel operations behind draws, format
+// conversions and fills, without a Flutter engine:
+//
+//   sw_rend_bench [--workers N] [--seconds S]
+//
+// Every operation runs at each size on one thread and then split across N
+// workers (4 by default), and is reported in GB/s of texture memory written.
+
+#include "sw_raster.h"
+#include "sw_surface.h"
+#include "sw_worker_pool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+typedef struct {
+  const char* name;
+  SwPixelFormat format;
+  SwBlendMode blend;
+  // Fill through the rasterizer instead of drawing pixels
+  bool fill;
+} SwBenchOp;
+
+static const SwBenchOp sw_bench_ops[] = {
+  {"draw rgba", SW_PIXEL_FORMAT_RGBA8888, SW_BLEND_SRC, false},
+  {"draw rgba src-over", SW_PIXEL_FORMAT_RGBA8888, SW_BLEND_SRC_OVER, false},
+  {"convert bgra8888", SW_PIXEL_FORMAT_BGRA8888, SW_BLEND_SRC, false},
+  {"convert rgb888", SW_PIXEL_FORMAT_RGB888, SW_BLEND_SRC, false},
+  {"convert rgb565", SW_PIXEL_FORMAT_RGB565, SW_BLEND_SRC, false},
+  {"convert gray8", SW_PIXEL_FORMAT_GRAY8, SW_BLEND_SRC, false},
+  {"fill", SW_PIXEL_FORMAT_RGBA8888, SW_BLEND_SRC, true},
+};
+
+static const int64_t sw_bench_sizes[] = {64, 256, 1024, 2048, 4096};
+
+static void sw_bench_run_once(const SwBenchOp* op, const SwSurface* surface, const uint8_t* pixels,
+                              SwWorkerPool* workers) {
+  if (op->fill) {
+    int32_t commands[] = {SW_RASTER_FILL_RECT, 0, 0, (int32_t)surface->width, (int32_t)surface->height,
+                          (int32_t)0xff336699};
+    SwDamage damage;
+    sw_damage_clear(&damage);
+    sw_raster_execute(surface->pixels, surface->width, surface->height, commands, 6, &damage, workers);
+    return;
+  }
+  sw_surface_draw_rect(surface, pixels, 0, 0, surface->width, surface->height, op->format, op->blend, workers);
+}
+
+// Returns GB/s written by |op| over at least |seconds|
+static double sw_bench_measure(const SwBenchOp* op, int64_t size, SwWorkerPool* workers, double seconds) {
+  std::vector<uint8_t> store(4 * size * size);
+  std::vector<uint8_t> pixels(4 * size * size);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = (uint8_t)(i * 31 + 7);
+  }
+  SwSurface surface = {store.data(), size, size};
+  // Warm up the caches and the workers
+  sw_bench_run_once(op, &surface, pixels.data(), workers);
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  int64_t iterations = 0;
+  double elapsed = 0;
+  do {
+    sw_bench_run_once(op, &surface, pixels.data(), workers);
+    iterations++;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (elapsed < seconds);
+  return (double)iterations * store.size() / elapsed / 1e9;
+}
+
+int main(int argc, char** argv) {
+  int workers = 4;
+  double seconds = 0.25;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--workers N] [--seconds S]\n", argv[0]);
+      return 2;
+    }
+  }
+  // Split every job, however small, so that the worker column shows the
+  // threads' overhead as well as their gains
+  SwWorkerPool* pool = sw_worker_pool_new(workers, 0);
+  printf("%-20s %6s %12s %12s\n", "operation", "size", "1 thread", "workers");
+  for (const SwBenchOp& op : sw_bench_ops) {
+    for (int64_t size : sw_bench_sizes) {
+      double single = sw_bench_measure(&op, size, nullptr, seconds);
+      double split = sw_bench_measure(&op, size, pool, seconds);
+      printf("%-20s %6lld %7.2f GB/s %7.2f GB/s\n", op.name, (long long)size, single, split);
+    }
+  }
+  sw_worker_pool_unref(pool);
+  return 0;
+}
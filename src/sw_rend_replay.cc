@@ -0,0 +1,331 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+// Runs a command log recorded by the plugin against the shared pixel code,
+// without a Flutter engine, and reports throughput and the latency of each
+// kind of command:
+//
+//   sw_rend_replay [--realtime] [--workers N] [--repeat N] LOG
+//
+// Commands run back to back unless --realtime spaces them out as they were
+// recorded. Textures are kept like the plugin keeps them, down to copying
+// presented frames of tear-free textures into a second store. Calls the log
+// only marks, such as blits, are skipped and reported.
+
+#include "sw_command_log.h"
+#include "sw_raster.h"
+#include "sw_rle.h"
+#include "sw_surface.h"
+#include "sw_worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Most pixels a replayed texture may have. Logs record calls before the
+// plugin checks them, so sizes the plugin would have refused show up here.
+#define SW_REPLAY_MAX_PIXELS (1ll << 28)
+
+typedef struct {
+  SwCommand command;
+  std::vector<uint8_t> payload;
+} SwReplayCommand;
+
+typedef struct {
+  std::vector<uint8_t> store;
+  // The frame last presented, for tear-free textures only
+  std::vector<uint8_t> front;
+  int64_t width;
+  int64_t height;
+  bool tear_free;
+  SwDamage damage;
+} SwReplayTexture;
+
+static const char* const sw_replay_op_names[SW_COMMAND_OP_COUNT] = {
+  "init", "dispose", "resize", "draw", "raster", "invalidate", "unlogged",
+};
+
+static SwSurface sw_replay_surface(SwReplayTexture* texture) {
+  return {texture->store.data(), texture->width, texture->height};
+}
+
+// Whether a texture may be |width| x |height|
+static bool sw_replay_size_is_valid(int64_t width, int64_t height) {
+  return width >= 0 && height >= 0 && (width == 0 || height <= SW_REPLAY_MAX_PIXELS / width);
+}
+
+// Returns false if the size is malformed or too large to replay
+static bool sw_replay_init(std::map<int64_t, SwReplayTexture>* textures, const SwCommand* command) {
+  int64_t width = command->width, height = command->height;
+  if (!sw_replay_size_is_valid(width, height)) {
+    return false;
+  }
+  SwReplayTexture& texture = (*textures)[command->texture];
+  texture.store.assign(4 * width * height, 0);
+  texture.tear_free = (command->flags & SW_COMMAND_FLAG_TEAR_FREE) != 0;
+  if (texture.tear_free) {
+    texture.front.assign(4 * width * height, 0);
+  }
+  texture.width = width;
+  texture.height = height;
+  sw_damage_clear(&texture.damage);
+  return true;
+}
+
+// Returns false, leaving |texture| as it was, if the size is malformed or
+// too large to replay
+static bool sw_replay_resize(SwReplayTexture* texture, const SwCommand* command) {
+  int64_t width = command->width, height = command->height;
+  if (!sw_replay_size_is_valid(width, height)) {
+    return false;
+  }
+  std::vector<uint8_t> store(4 * width * height, 0);
+  SwSurface to = {store.data(), width, height};
+  SwSurface from = sw_replay_surface(texture);
+  if (command->anchor == 0) {
+    sw_surface_relayout(&to, &from, 0, 0);
+  } else if (command->anchor == 1) {
+    sw_surface_relayout(&to, &from, (width - texture->width) / 2, (height - texture->height) / 2);
+  }
+  texture->store.swap(store);
+  if (texture->tear_free) {
+    texture->front = texture->store;
+  }
+  texture->width = width;
+  texture->height = height;
+  sw_damage_clear(&texture->damage);
+  sw_damage_add(&texture->damage, {0, 0, width, height});
+  return true;
+}
+
+// Returns false if the draw is malformed, as the plugin would have refused it
+static bool sw_replay_draw(SwReplayTexture* texture, const SwCommand* command, SwWorkerPool* workers) {
+  int64_t width = command->width == -1 ? texture->width : command->width;
+  int64_t height = command->height == -1 ? texture->height : command->height;
+  SwSurface surface = sw_replay_surface(texture);
+  if (command->flags & SW_COMMAND_FLAG_IN_PLACE) {
+    sw_damage_add(&texture->damage, sw_surface_clip(&surface, {command->x, command->y, width, height}));
+    return true;
+  }
+  if (width < 0 || height < 0 || !sw_pixel_format_is_valid(command->format) ||
+      !sw_blend_mode_is_valid(command->blend) || !sw_encoding_is_valid(command->encoding)) {
+    return false;
+  }
+  if (command->encoding != SW_ENCODING_RAW) {
+    SwRect rect = {command->x, command->y, width, height};
+    SwRect clip = sw_surface_clip(&surface, rect);
+    if (clip.x != rect.x || clip.y != rect.y || clip.width != rect.width || clip.height != rect.height ||
+        !sw_rle_validate(command->payload, command->payload_length, width * height)) {
+      return false;
+    }
+    if (width > 0 && height > 0) {
+      SwRect changed = sw_rle_decode(surface.pixels + 4 * (rect.y * surface.width + rect.x), 4 * surface.width,
+                                     width, height, command->payload, command->payload_length,
+                                     command->encoding == SW_ENCODING_XOR_RLE);
+      sw_damage_add(&texture->damage, {rect.x + changed.x, rect.y + changed.y, changed.width, changed.height});
+    }
+    return true;
+  }
+  SwPixelFormat format = (SwPixelFormat)command->format;
+  // Divide rather than multiply, which could overflow for bogus sizes
+  if (command->payload_length / sw_pixel_format_bytes_per_pixel(format) / std::max<int64_t>(width, 1) <
+      (size_t)height) {
+    return false;
+  }
+  sw_damage_add(&texture->damage, sw_surface_draw_rect(&surface, command->payload, command->x, command->y, width,
+                                                       height, format, (SwBlendMode)command->blend, workers));
+  return true;
+}
+
+static bool sw_replay_raster(SwReplayTexture* texture, const SwCommand* command, SwWorkerPool* workers) {
+  const int32_t* commands = (const int32_t*)command->payload;
+  size_t length = command->payload_length / sizeof(int32_t);
+  if (sw_raster_validate(commands, length) >= 0) {
+    return false;
+  }
+  sw_raster_execute(texture->store.data(), texture->width, texture->height, commands, length, &texture->damage,
+                    workers);
+  return true;
+}
+
+static void sw_replay_invalidate(SwReplayTexture* texture, SwWorkerPool* workers) {
+  if (texture->tear_free) {
+    SwSurface from = sw_replay_surface(texture);
+    SwSurface to = {texture->front.data(), texture->width, texture->height};
+    for (int i = 0; i < texture->damage.count; i++) {
+      sw_surface_copy_rect(&to, &from, texture->damage.rects[i], workers);
+    }
+  }
+  sw_damage_clear(&texture->damage);
+}
+
+// Returns false if the command could not run
+static bool sw_replay_run(std::map<int64_t, SwReplayTexture>* textures, const SwCommand* command,
+                          SwWorkerPool* workers) {
+  if (command->op == SW_COMMAND_INIT) {
+    return sw_replay_init(textures, command);
+  }
+  auto it = textures->find(command->texture);
+  if (it == textures->end()) {
+    return false;
+  }
+  switch (command->op) {
+    case SW_COMMAND_DISPOSE:
+      textures->erase(it);
+      return true;
+    case SW_COMMAND_RESIZE:
+      return sw_replay_resize(&it->second, command);
+    case SW_COMMAND_DRAW:
+      return sw_replay_draw(&it->second, command, workers);
+    case SW_COMMAND_RASTER:
+      return sw_replay_raster(&it->second, command, workers);
+    case SW_COMMAND_INVALIDATE:
+      sw_replay_invalidate(&it->second, workers);
+      return true;
+    case SW_COMMAND_UNLOGGED:
+      // Nothing to run; the caller reports these
+      return true;
+    default:
+      return false;
+  }
+}
+
+static double sw_replay_percentile(const std::vector<int64_t>& sorted, double fraction) {
+  size_t index = std::min(sorted.size() - 1, (size_t)(fraction * sorted.size()));
+  return sorted[index] / 1e3;
+}
+
+int main(int argc, char** argv) {
+  bool realtime = false;
+  int workers = SW_WORKER_POOL_DEFAULT_WORKERS;
+  int repeat = 1;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--realtime") == 0) {
+      realtime = true;
+    } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      workers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+      repeat = std::max(atoi(argv[++i]), 1);
+    } else if (path == nullptr && argv[i][0] != '-') {
+      path = argv[i];
+    } else {
+      path = nullptr;
+      break;
+    }
+  }
+  if (path == nullptr) {
+    fprintf(stderr, "usage: %s [--realtime] [--workers N] [--repeat N] LOG\n", argv[0]);
+    return 2;
+  }
+
+  // Load the whole log first, so that reading it is not timed
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr || !sw_command_log_read_header(file)) {
+    fprintf(stderr, "%s is not a command log\n", path);
+    return 1;
+  }
+  std::vector<SwReplayCommand> commands;
+  int64_t payload_bytes = 0;
+  for (;;) {
+    SwReplayCommand command;
+    int status = sw_command_log_read(file, &command.command, &command.payload);
+    if (status < 0) {
+      fprintf(stderr, "Command %zu of %s is malformed, replaying up to it\n", commands.size(), path);
+    }
+    if (status <= 0) {
+      break;
+    }
+    payload_bytes += command.payload.size();
+    commands.push_back(std::move(command));
+  }
+  fclose(file);
+  // Moving the commands into place may have moved their payloads
+  for (SwReplayCommand& command : commands) {
+    command.command.payload = command.payload.data();
+  }
+  if (commands.empty()) {
+    fprintf(stderr, "%s holds no commands\n", path);
+    return 1;
+  }
+  // Calls the log could not capture, by method, and the textures they leave
+  // different from the app's
+  std::map<std::string, int64_t> unlogged;
+  std::set<int64_t> diverged;
+  for (const SwReplayCommand& command : commands) {
+    if (command.command.op == SW_COMMAND_UNLOGGED) {
+      unlogged[std::string(command.payload.begin(), command.payload.end())]++;
+      diverged.insert(command.command.texture);
+    }
+  }
+
+  SwWorkerPool* pool = sw_worker_pool_new(workers, SW_WORKER_POOL_DEFAULT_THRESHOLD);
+  std::vector<int64_t> latencies[SW_COMMAND_OP_COUNT];
+  int64_t failed = 0;
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  for (int pass = 0; pass < repeat; pass++) {
+    std::map<int64_t, SwReplayTexture> textures;
+    Clock::time_point pass_start = Clock::now();
+    for (const SwReplayCommand& command : commands) {
+      if (realtime) {
+        std::this_thread::sleep_until(
+            pass_start + std::chrono::microseconds(command.command.timestamp_us - commands[0].command.timestamp_us));
+      }
+      Clock::time_point before = Clock::now();
+      if (!sw_replay_run(&textures, &command.command, pool)) {
+        failed++;
+      }
+      latencies[command.command.op].push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count());
+    }
+  }
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  sw_worker_pool_unref(pool);
+
+  int64_t total = (int64_t)commands.size() * repeat;
+  printf("%lld commands in %.3f s: %.0f commands/s, %.1f MB/s of payload\n", (long long)total, elapsed,
+         total / elapsed, (double)payload_bytes * repeat / elapsed / 1e6);
+  if (failed > 0) {
+    printf("%lld commands failed, as they would have in the plugin\n", (long long)failed);
+  }
+  printf("%-12s %10s %10s %10s %10s %10s\n", "command", "count", "p50 us", "p90 us", "p99 us", "max us");
+  for (int op = 0; op < SW_COMMAND_OP_COUNT; op++) {
+    std::vector<int64_t>& sorted = latencies[op];
+    if (sorted.empty() || op == SW_COMMAND_UNLOGGED) {
+      continue;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    printf("%-12s %10zu %10.1f %10.1f %10.1f %10.1f\n", sw_replay_op_names[op], sorted.size(),
+           sw_replay_percentile(sorted, 0.5), sw_replay_percentile(sorted, 0.9), sw_replay_percentile(sorted, 0.99),
+           sorted.back() / 1e3);
+  }
+  if (!unlogged.empty()) {
+    printf("Skipped calls the log could not capture, leaving %zu textures unlike the app's:\n", diverged.size());
+    for (const auto& method : unlogged) {
+      printf("%-12s %10lld\n", method.first.c_str(), (long long)method.second);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,251 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+// Checks the shared pixel kernels against results worked out by hand. Run by
+// ctest, or on its own:
+//
+//   sw_rend_test
+//
+// Rows are long enough to take the vector paths as well as their tails.
+
+#include "sw_blend.h"
+#include "sw_pixel_convert.h"
+#include "sw_rle.h"
+#include "sw_surface.h"
+#include "sw_tilemap.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static int sw_test_failures = 0;
+
+#define SW_CHECK(condition)                                              \
+  do {                                                                   \
+    if (!(condition)) {                                                  \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      sw_test_failures++;                                                \
+    }                                                                    \
+  } while (0)
+
+static const int64_t sw_test_row = 37;
+
+static bool sw_test_pixel_is(const uint8_t* pixel, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  return pixel[0] == r && pixel[1] == g && pixel[2] == b && pixel[3] == a;
+}
+
+static void sw_test_convert() {
+  std::vector<uint8_t> dst(4 * sw_test_row);
+  std::vector<uint8_t> gray(sw_test_row);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    gray[i] = (uint8_t)(7 * i);
+  }
+  sw_pixel_convert_row(dst.data(), gray.data(), sw_test_row, SW_PIXEL_FORMAT_GRAY8);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    SW_CHECK(sw_test_pixel_is(&dst[4 * i], gray[i], gray[i], gray[i], 255));
+  }
+
+  std::vector<uint8_t> bgra(4 * sw_test_row);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    uint8_t pixel[4] = {(uint8_t)i, 2, (uint8_t)(100 + i), 50};
+    memcpy(&bgra[4 * i], pixel, 4);
+  }
+  sw_pixel_convert_row(dst.data(), bgra.data(), sw_test_row, SW_PIXEL_FORMAT_BGRA8888);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    SW_CHECK(sw_test_pixel_is(&dst[4 * i], (uint8_t)(100 + i), 2, (uint8_t)i, 50));
+  }
+
+  std::vector<uint8_t> rgb(3 * sw_test_row);
+  for (int64_t i = 0; i < 3 * sw_test_row; i++) {
+    rgb[i] = (uint8_t)i;
+  }
+  sw_pixel_convert_row(dst.data(), rgb.data(), sw_test_row, SW_PIXEL_FORMAT_RGB888);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    SW_CHECK(sw_test_pixel_is(&dst[4 * i], rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2], 255));
+  }
+
+  // Pure red, green and blue, then black and white, repeated
+  static const uint16_t rgb565[] = {0xf800, 0x07e0, 0x001f, 0x0000, 0xffff};
+  static const uint8_t expected[][3] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {0, 0, 0}, {255, 255, 255}};
+  std::vector<uint8_t> packed(2 * sw_test_row);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    packed[2 * i] = (uint8_t)(rgb565[i % 5] & 0xff);
+    packed[2 * i + 1] = (uint8_t)(rgb565[i % 5] >> 8);
+  }
+  sw_pixel_convert_row(dst.data(), packed.data(), sw_test_row, SW_PIXEL_FORMAT_RGB565);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    const uint8_t* rgb = expected[i % 5];
+    SW_CHECK(sw_test_pixel_is(&dst[4 * i], rgb[0], rgb[1], rgb[2], 255));
+  }
+}
+
+static void sw_test_blend() {
+  std::vector<uint8_t> dst(4 * sw_test_row), src(4 * sw_test_row);
+  // Opaque sources replace, transparent premultiplied ones add
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    uint8_t alpha = i % 2 == 0 ? 255 : 0;
+    uint8_t from[4] = {10, 20, 30, alpha};
+    uint8_t to[4] = {1, 2, 3, 4};
+    memcpy(&src[4 * i], from, 4);
+    memcpy(&dst[4 * i], to, 4);
+  }
+  sw_blend_row(dst.data(), src.data(), sw_test_row, SW_BLEND_SRC_OVER);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    if (i % 2 == 0) {
+      SW_CHECK(sw_test_pixel_is(&dst[4 * i], 10, 20, 30, 255));
+    } else {
+      SW_CHECK(sw_test_pixel_is(&dst[4 * i], 11, 22, 33, 4));
+    }
+  }
+
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    uint8_t from[4] = {200, 100, 0, 255};
+    uint8_t to[4] = {100, 100, 7, 255};
+    memcpy(&src[4 * i], from, 4);
+    memcpy(&dst[4 * i], to, 4);
+  }
+  sw_blend_row(dst.data(), src.data(), sw_test_row, SW_BLEND_ADD);
+  for (int64_t i = 0; i < sw_test_row; i++) {
+    SW_CHECK(sw_test_pixel_is(&dst[4 * i], 255, 200, 7, 255));
+  }
+}
+
+static void sw_test_scale() {
+  // Two pixels doubled in width and height
+  const uint8_t src[] = {1, 2, 3, 255, 4, 5, 6, 255};
+  std::vector<uint8_t> pixels(4 * 4 * 2);
+  SwSurface surface = {pixels.data(), 4, 2};
+  SwRect drawn = sw_surface_blit_scaled(&surface, src, 8, 2, 1, 0, 0, 4, 2, SW_SCALE_NEAREST, nullptr);
+  SW_CHECK(drawn.width == 4 && drawn.height == 2);
+  for (int64_t i = 0; i < 8; i++) {
+    const uint8_t* expected = (i % 4) < 2 ? src : src + 4;
+    SW_CHECK(memcmp(&pixels[4 * i], expected, 4) == 0);
+  }
+
+  // Bilinear keeps a flat image flat, including at the edges
+  const uint8_t flat[] = {9, 8, 7, 255, 9, 8, 7, 255, 9, 8, 7, 255, 9, 8, 7, 255};
+  std::vector<uint8_t> large(4 * sw_test_row * 3);
+  SwSurface wide = {large.data(), sw_test_row, 3};
+  sw_surface_blit_scaled(&wide, flat, 8, 2, 2, 0, 0, sw_test_row, 3, SW_SCALE_BILINEAR, nullptr);
+  for (int64_t i = 0; i < sw_test_row * 3; i++) {
+    SW_CHECK(sw_test_pixel_is(&large[4 * i], 9, 8, 7, 255));
+  }
+
+  // Destination rects too large to sample are refused rather than overflowing
+  drawn = sw_surface_blit_scaled(&surface, src, 8, 2, 1, -((int64_t)1 << 40) + 2, 0, (int64_t)1 << 40, 2,
+                                 SW_SCALE_NEAREST, nullptr);
+  SW_CHECK(sw_rect_is_empty(drawn));
+}
+
+static void sw_test_rle() {
+  // A run of four red pixels, then a literal green and blue
+  const uint8_t data[] = {
+      (3 << 1) | 1, 255, 0, 0, 255,
+      (1 << 1), 0, 255, 0, 255, 0, 0, 255, 255,
+  };
+  SW_CHECK(sw_rle_validate(data, sizeof(data), 6));
+  SW_CHECK(!sw_rle_validate(data, sizeof(data), 5));
+  SW_CHECK(!sw_rle_validate(data, sizeof(data), 7));
+  SW_CHECK(!sw_rle_validate(data, sizeof(data) - 1, 6));
+
+  // Decoded into the middle of a wider image, so the stride matters
+  std::vector<uint8_t> pixels(4 * 4 * 2, 0);
+  SwRect changed = sw_rle_decode(pixels.data() + 4, 16, 3, 2, data, sizeof(data), false);
+  SW_CHECK(changed.height == 2);
+  SW_CHECK(sw_test_pixel_is(&pixels[0], 0, 0, 0, 0));
+  for (int i = 1; i < 4; i++) {
+    SW_CHECK(sw_test_pixel_is(&pixels[4 * i], 255, 0, 0, 255));
+  }
+  SW_CHECK(sw_test_pixel_is(&pixels[4 * 4], 0, 0, 0, 0));
+  SW_CHECK(sw_test_pixel_is(&pixels[4 * 5], 255, 0, 0, 255));
+  SW_CHECK(sw_test_pixel_is(&pixels[4 * 6], 0, 255, 0, 255));
+  SW_CHECK(sw_test_pixel_is(&pixels[4 * 7], 0, 0, 255, 255));
+}
+
+static void sw_test_rle_xor() {
+  // XORing the same data in twice restores the image, and runs of 0 leave it
+  const uint8_t data[] = {(3 << 1) | 1, 0, 0, 0, 0, (1 << 1), 1, 2, 3, 4, 5, 6, 7, 8};
+  SW_CHECK(sw_rle_validate(data, sizeof(data), 6));
+  std::vector<uint8_t> pixels(4 * 6);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = (uint8_t)(3 * i);
+  }
+  std::vector<uint8_t> original = pixels;
+  SwRect changed = sw_rle_decode(pixels.data(), 24, 6, 1, data, sizeof(data), true);
+  SW_CHECK(changed.height == 1);
+  SW_CHECK(memcmp(pixels.data(), original.data(), 16) == 0);
+  SW_CHECK(pixels[16] == (original[16] ^ 1) && pixels[23] == (original[23] ^ 8));
+  sw_rle_decode(pixels.data(), 24, 6, 1, data, sizeof(data), true);
+  SW_CHECK(pixels == original);
+}
+
+static void sw_test_tilemap_scroll() {
+  // Two 2x2 tiles, red and blue, on a 6x2 map seen through a 4x2 viewport
+  std::vector<uint8_t> tileset(4 * 4 * 2);
+  for (int64_t y = 0; y < 2; y++) {
+    for (int64_t x = 0; x < 4; x++) {
+      uint8_t pixel[4] = {(uint8_t)(x < 2 ? 255 : 0), 0, (uint8_t)(x < 2 ? 0 : 255), 255};
+      memcpy(&tileset[4 * (y * 4 + x)], pixel, 4);
+    }
+  }
+  const int32_t tiles[] = {0, 1, 0, 1, 1, SW_TILEMAP_EMPTY};
+  std::vector<uint8_t> scrolled(4 * 4 * 2), fresh(4 * 4 * 2);
+  SwSurface scrolled_surface = {scrolled.data(), 4, 2};
+  SwSurface fresh_surface = {fresh.data(), 4, 2};
+  SwTilemap* scrolling = sw_tilemap_new(2, 2, 6, 1, tileset.data(), 4, 2);
+  SwTilemap* reference = sw_tilemap_new(2, 2, 6, 1, tileset.data(), 4, 2);
+  SW_CHECK(sw_tilemap_get_tile_count(scrolling) == 2);
+  SwDamage damage;
+  sw_damage_clear(&damage);
+  SW_CHECK(sw_tilemap_set_tiles(scrolling, &scrolled_surface, 0, 0, 6, 1, tiles, &damage, nullptr));
+  SW_CHECK(!sw_tilemap_set_tiles(scrolling, &scrolled_surface, 1, 0, 6, 1, tiles, &damage, nullptr));
+  sw_tilemap_set_tiles(reference, &fresh_surface, 0, 0, 6, 1, tiles, &damage, nullptr);
+  sw_tilemap_render(scrolling, &scrolled_surface, {0, 0, 4, 2}, &damage, nullptr);
+
+  // Scrolling by part of the viewport, by a whole tile, past the map's end,
+  // to the ends of the int64 range and back must match drawing the same
+  // offset from scratch
+  const int64_t offsets[][2] = {{1, 0}, {3, 0}, {5, 1}, {-2, 0}, {100, 0}, {INT64_MIN, INT64_MAX},
+                                {INT64_MAX, INT64_MIN}, {0, 0}};
+  for (const int64_t* offset : offsets) {
+    sw_damage_clear(&damage);
+    sw_tilemap_scroll(scrolling, &scrolled_surface, offset[0], offset[1], &damage, nullptr);
+    sw_tilemap_scroll(reference, &fresh_surface, offset[0], offset[1], &damage, nullptr);
+    sw_tilemap_render(reference, &fresh_surface, {0, 0, 4, 2}, &damage, nullptr);
+    SW_CHECK(scrolled == fresh);
+  }
+  // At the origin the viewport shows red, blue
+  SW_CHECK(sw_test_pixel_is(&scrolled[0], 255, 0, 0, 255));
+  SW_CHECK(sw_test_pixel_is(&scrolled[4 * 2], 0, 0, 255, 255));
+  sw_tilemap_free(scrolling);
+  sw_tilemap_free(reference);
+}
+
+int main() {
+  sw_test_convert();
+  sw_test_blend();
+  sw_test_scale();
+  sw_test_rle();
+  sw_test_rle_xor();
+  sw_test_tilemap_scroll();
+  if (sw_test_failures > 0) {
+    fprintf(stderr, "%d checks failed\n", sw_test_failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,160 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_rle.h"
+#include "sw_raster.h"
+#include "sw_simd.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(SW_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+// Longest LEB128 header accepted, enough for any pixel count
+#define SW_RLE_MAX_HEADER_BYTES 9
+
+// Read a header at |*pos|, advancing past it. Returns false if it is
+// truncated or too long.
+static bool sw_rle_read_header(const uint8_t* data, size_t length, size_t* pos, uint64_t* header) {
+  uint64_t value = 0;
+  for (int i = 0; i < SW_RLE_MAX_HEADER_BYTES; i++) {
+    if (*pos >= length) {
+      return false;
+    }
+    uint8_t byte = data[(*pos)++];
+    value |= (uint64_t)(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *header = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool sw_rle_validate(const uint8_t* data, size_t length, int64_t pixels) {
+  size_t pos = 0;
+  uint64_t covered = 0;
+  while (pos < length) {
+    uint64_t header;
+    if (!sw_rle_read_header(data, length, &pos, &header)) {
+      return false;
+    }
+    uint64_t count = (header >> 1) + 1;
+    if (count > (uint64_t)pixels - covered) {
+      return false;
+    }
+    size_t bytes = (header & 1) ? 4 : 4 * count;
+    if (bytes > length - pos) {
+      return false;
+    }
+    pos += bytes;
+    covered += count;
+  }
+  return covered == (uint64_t)pixels;
+}
+
+// XOR |count| pixels from |src| into |dst|
+static void sw_rle_xor_span(uint8_t* dst, const uint8_t* src, int64_t count) {
+  int64_t i = 0;
+#if defined(SW_HAVE_SSE2)
+  for (; i + 4 <= count; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + 4 * i));
+    __m128i s = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_xor_si128(d, s));
+  }
+#endif
+  for (; i < count; i++) {
+    for (int k = 0; k < 4; k++) {
+      dst[4 * i + k] ^= src[4 * i + k];
+    }
+  }
+}
+
+// XOR |color| into |count| pixels at |dst|
+static void sw_rle_xor_fill(uint8_t* dst, int64_t count, uint32_t color) {
+  int64_t i = 0;
+#if defined(SW_HAVE_SSE2)
+  __m128i fill = _mm_set1_epi32((int)color);
+  for (; i + 4 <= count; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i*)(dst + 4 * i));
+    _mm_storeu_si128((__m128i*)(dst + 4 * i), _mm_xor_si128(d, fill));
+  }
+#endif
+  for (; i < count; i++) {
+    uint32_t pixel;
+    memcpy(&pixel, dst + 4 * i, 4);
+    pixel ^= color;
+    memcpy(dst + 4 * i, &pixel, 4);
+  }
+}
+
+SwRect sw_rle_decode(uint8_t* dst, int64_t stride, int64_t width, int64_t height,
+                     const uint8_t* data, size_t length, bool xor_dst) {
+  size_t pos = 0;
+  int64_t x = 0, y = 0;
+  int64_t first_row = height, last_row = -1;
+  while (pos < length && y < height) {
+    uint64_t header = 0;
+    if (!sw_rle_read_header(data, length, &pos, &header)) {
+      break;
+    }
+    int64_t count = (int64_t)(header >> 1) + 1;
+    bool run = header & 1;
+    const uint8_t* src = data + pos;
+    pos += run ? 4 : 4 * count;
+    uint32_t color = 0;
+    if (run) {
+      memcpy(&color, src, 4);
+    }
+    // A run XORing in 0 changes nothing
+    bool skip = xor_dst && run && color == 0;
+    if (!skip && count > 0) {
+      first_row = std::min(first_row, y);
+      last_row = std::max(last_row, std::min(y + (x + count - 1) / width, height - 1));
+    }
+    while (count > 0) {
+      int64_t span = std::min(count, width - x);
+      if (!skip) {
+        uint8_t* row = dst + y * stride + 4 * x;
+        if (run && xor_dst) {
+          sw_rle_xor_fill(row, span, color);
+        } else if (run) {
+          sw_raster_fill_span(row, span, color);
+        } else if (xor_dst) {
+          sw_rle_xor_span(row, src, span);
+        } else {
+          memcpy(row, src, 4 * span);
+        }
+        if (!run) {
+          src += 4 * span;
+        }
+      }
+      count -= span;
+      x += span;
+      if (x == width) {
+        x = 0;
+        y++;
+      }
+    }
+  }
+  if (last_row < 0) {
+    return {0, 0, 0, 0};
+  }
+  return {0, first_row, width, last_row - first_row + 1};
+}
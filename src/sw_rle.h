@@ -0,0 +1,60 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_RLE_H_
+#define INCLUDE_SW_RLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sw_damage.h"
+
+// How the pixels of a draw are encoded. Encoded pixels are always RGBA.
+// The values are part of the method channel protocol.
+typedef enum {
+  // Tightly packed pixels
+  SW_ENCODING_RAW = 0,
+  // Run-length encoded pixels
+  SW_ENCODING_RLE = 1,
+  // Run-length encoded XOR of each pixel with the one already in the
+  // texture, so unchanged areas become runs of 0
+  SW_ENCODING_XOR_RLE = 2,
+} SwEncoding;
+
+#define SW_ENCODING_COUNT 3
+
+inline bool sw_encoding_is_valid(int64_t encoding) {
+  return encoding >= 0 && encoding < SW_ENCODING_COUNT;
+}
+
+// Run-length encoded data is a series of packets covering the pixels of a
+// rect in row-major order; packets may span rows. Each starts with an
+// unsigned LEB128 header h holding a count n = (h >> 1) + 1:
+//
+//   h & 1 == 0  literal: n pixels of 4 bytes each follow
+//   h & 1 == 1  run: one 4-byte pixel follows, repeated n times
+//
+// Check that |data| is well formed and covers exactly |pixels| pixels
+bool sw_rle_validate(const uint8_t* data, size_t length, int64_t pixels);
+
+// Decode data checked with sw_rle_validate into the |width| x |height| rect
+// at |dst|, whose rows are |stride| bytes apart. With |xor_dst| set the decoded
+// pixels are XORed into |dst| instead of replacing it, and runs of 0 are
+// skipped. Returns the rows actually changed, relative to |dst|.
+SwRect sw_rle_decode(uint8_t* dst, int64_t stride, int64_t width, int64_t height,
+                     const uint8_t* data, size_t length, bool xor_dst);
+
+#endif //INCLUDE_SW_RLE_H_
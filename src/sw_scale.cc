@@ -0,0 +1,185 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_scale.h"
+#include "sw_raster.h"
+#include "sw_simd.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(SW_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+// Source position under the center of output pixel |i| of |dst_size| in 16.16
+// fixed point, for nearest sampling
+static inline int64_t sw_scale_center(int64_t i, int64_t src_size, int64_t dst_size) {
+  return ((2 * i + 1) * src_size << 16) / (2 * dst_size);
+}
+
+// Split the bilinear sample position for output pixel |i| into the two source
+// pixels around it and the weight of the second out of 256
+static void sw_scale_bilinear_position(int64_t i, int64_t src_size, int64_t dst_size,
+                                       int32_t* p0, int32_t* p1, uint8_t* weight) {
+  int64_t pos = std::max<int64_t>(sw_scale_center(i, src_size, dst_size) - 0x8000, 0);
+  int64_t p = pos >> 16;
+  if (p >= src_size - 1) {
+    *p0 = *p1 = (int32_t)(src_size - 1);
+    *weight = 0;
+    return;
+  }
+  *p0 = (int32_t)p;
+  *p1 = (int32_t)p + 1;
+  *weight = (uint8_t)(pos >> 8);
+}
+
+void sw_scale_init(SwScale* scale, SwScaleFilter filter, int64_t src_width, int64_t src_height,
+                   int64_t dst_width, int64_t dst_height, SwRect clip) {
+  scale->filter = filter;
+  scale->src_width = src_width;
+  scale->src_height = src_height;
+  scale->dst_width = dst_width;
+  scale->dst_height = dst_height;
+  scale->clip = clip;
+  scale->x0 = (int32_t*)malloc(sizeof(int32_t) * clip.width);
+  scale->x1 = nullptr;
+  scale->wx = nullptr;
+  if (filter == SW_SCALE_NEAREST) {
+    for (int64_t i = 0; i < clip.width; i++) {
+      scale->x0[i] = (int32_t)(sw_scale_center(clip.x + i, src_width, dst_width) >> 16);
+    }
+    return;
+  }
+  scale->x1 = (int32_t*)malloc(sizeof(int32_t) * clip.width);
+  scale->wx = (uint8_t*)malloc(clip.width);
+  for (int64_t i = 0; i < clip.width; i++) {
+    sw_scale_bilinear_position(clip.x + i, src_width, dst_width, &scale->x0[i], &scale->x1[i], &scale->wx[i]);
+  }
+}
+
+void sw_scale_clear(SwScale* scale) {
+  free(scale->x0);
+  free(scale->x1);
+  free(scale->wx);
+  scale->x0 = scale->x1 = nullptr;
+  scale->wx = nullptr;
+}
+
+static void sw_scale_nearest_row(const SwScale* scale, uint8_t* dst, const uint8_t* src) {
+  int64_t width = scale->clip.width;
+  if (scale->dst_width % scale->src_width == 0) {
+    // Integer factor: every source pixel covers a run of |factor| outputs
+    int64_t factor = scale->dst_width / scale->src_width;
+    int64_t i = 0;
+    while (i < width) {
+      int64_t run = std::min(factor - (scale->clip.x + i) % factor, width - i);
+      uint32_t color;
+      memcpy(&color, src + 4 * scale->x0[i], 4);
+      sw_raster_fill_span(dst + 4 * i, run, color);
+      i += run;
+    }
+    return;
+  }
+  for (int64_t i = 0; i < width; i++) {
+    memcpy(dst + 4 * i, src + 4 * scale->x0[i], 4);
+  }
+}
+
+#if defined(SW_HAVE_SSE2)
+
+// Interpolates one output pixel per iteration with the left and right source
+// pixels widened side by side to 16-bit lanes [r0 g0 b0 a0 r1 g1 b1 a1]:
+// first between the two rows, then between the two halves. Every
+// intermediate fits in 16 bits, and the rounding matches the scalar path below.
+static void sw_scale_bilinear_row_sse2(const SwScale* scale, uint8_t* dst, const uint8_t* top,
+                                       const uint8_t* bottom, uint32_t wy) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i half = _mm_set1_epi16(128);
+  const __m128i top_weight = _mm_set1_epi16((short)(256 - wy));
+  const __m128i bottom_weight = _mm_set1_epi16((short)wy);
+  for (int64_t i = 0; i < scale->clip.width; i++) {
+    int32_t p;
+    memcpy(&p, top + 4 * scale->x0[i], 4);
+    __m128i t = _mm_cvtsi32_si128(p);
+    memcpy(&p, top + 4 * scale->x1[i], 4);
+    t = _mm_unpacklo_epi8(_mm_unpacklo_epi32(t, _mm_cvtsi32_si128(p)), zero);
+    memcpy(&p, bottom + 4 * scale->x0[i], 4);
+    __m128i b = _mm_cvtsi32_si128(p);
+    memcpy(&p, bottom + 4 * scale->x1[i], 4);
+    b = _mm_unpacklo_epi8(_mm_unpacklo_epi32(b, _mm_cvtsi32_si128(p)), zero);
+    __m128i v = _mm_add_epi16(_mm_mullo_epi16(t, top_weight), _mm_mullo_epi16(b, bottom_weight));
+    v = _mm_srli_epi16(_mm_add_epi16(v, half), 8);
+    short wx = scale->wx[i];
+    __m128i weights = _mm_set_epi16(wx, wx, wx, wx, (short)(256 - wx), (short)(256 - wx), (short)(256 - wx),
+                                    (short)(256 - wx));
+    v = _mm_mullo_epi16(v, weights);
+    v = _mm_add_epi16(_mm_add_epi16(v, _mm_srli_si128(v, 8)), half);
+    v = _mm_srli_epi16(v, 8);
+    p = _mm_cvtsi128_si32(_mm_packus_epi16(v, zero));
+    memcpy(dst + 4 * i, &p, 4);
+  }
+}
+
+#else
+
+static void sw_scale_bilinear_row_scalar(const SwScale* scale, uint8_t* dst, const uint8_t* top,
+                                         const uint8_t* bottom, uint32_t wy) {
+  for (int64_t i = 0; i < scale->clip.width; i++) {
+    const uint8_t* t0 = top + 4 * scale->x0[i];
+    const uint8_t* t1 = top + 4 * scale->x1[i];
+    const uint8_t* b0 = bottom + 4 * scale->x0[i];
+    const uint8_t* b1 = bottom + 4 * scale->x1[i];
+    uint32_t wx = scale->wx[i];
+    for (int c = 0; c < 4; c++) {
+      uint32_t left = (t0[c] * (256 - wy) + b0[c] * wy + 128) >> 8;
+      uint32_t right = (t1[c] * (256 - wy) + b1[c] * wy + 128) >> 8;
+      dst[4 * i + c] = (uint8_t)((left * (256 - wx) + right * wx + 128) >> 8);
+    }
+  }
+}
+
+#endif // SW_HAVE_SSE2
+
+void sw_scale_rows(const SwScale* scale, uint8_t* dst, int64_t dst_stride, const uint8_t* src, int64_t src_stride,
+                   int64_t start, int64_t end) {
+  int64_t last = -1;
+  for (int64_t row = start; row < end; row++) {
+    uint8_t* out = dst + row * dst_stride;
+    int64_t y = scale->clip.y + row;
+    if (scale->filter == SW_SCALE_NEAREST) {
+      int64_t sy = sw_scale_center(y, scale->src_height, scale->dst_height) >> 16;
+      // Rows sampling the same source row come out the same
+      if (sy == last) {
+        memcpy(out, out - dst_stride, 4 * scale->clip.width);
+      } else {
+        sw_scale_nearest_row(scale, out, src + sy * src_stride);
+      }
+      last = sy;
+      continue;
+    }
+    int32_t y0, y1;
+    uint8_t wy;
+    sw_scale_bilinear_position(y, scale->src_height, scale->dst_height, &y0, &y1, &wy);
+#if defined(SW_HAVE_SSE2)
+    sw_scale_bilinear_row_sse2(scale, out, src + y0 * src_stride, src + y1 * src_stride, wy);
+#else
+    sw_scale_bilinear_row_scalar(scale, out, src + y0 * src_stride, src + y1 * src_stride, wy);
+#endif
+  }
+}
@@ -0,0 +1,79 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_SCALE_H_
+#define INCLUDE_SW_SCALE_H_
+
+#include <cstdint>
+
+#include "sw_damage.h"
+
+// How a scaled blit samples its source.
+// The values are part of the method channel protocol.
+typedef enum {
+  // Take the source pixel under the center of each output pixel
+  SW_SCALE_NEAREST = 0,
+  // Interpolate between the four source pixels around the center of each
+  // output pixel
+  SW_SCALE_BILINEAR = 1,
+} SwScaleFilter;
+
+#define SW_SCALE_FILTER_COUNT 2
+
+inline bool sw_scale_filter_is_valid(int64_t filter) {
+  return filter >= 0 && filter < SW_SCALE_FILTER_COUNT;
+}
+
+// Largest source or destination side a scaled blit accepts. Sample positions
+// are computed in 16.16 fixed point from the product of the two sizes, which
+// stays well inside 64 bits below this.
+#define SW_SCALE_MAX_SIZE (1 << 22)
+
+inline bool sw_scale_size_is_valid(int64_t width, int64_t height) {
+  return width >= 0 && height >= 0 && width <= SW_SCALE_MAX_SIZE && height <= SW_SCALE_MAX_SIZE;
+}
+
+// Sampling positions for scaling a |src_width| x |src_height| image onto a
+// |dst_width| x |dst_height| rect, of which only |clip|, relative to the rect,
+// is written
+typedef struct {
+  SwScaleFilter filter;
+  int64_t src_width;
+  int64_t src_height;
+  int64_t dst_width;
+  int64_t dst_height;
+  SwRect clip;
+  // Per clip column, the source column to the left of its center, the one to
+  // the right and the weight of the right one out of 256. Only |x0| is used
+  // for SW_SCALE_NEAREST.
+  int32_t* x0;
+  int32_t* x1;
+  uint8_t* wx;
+} SwScale;
+
+// All sizes must be positive and at most SW_SCALE_MAX_SIZE, and |clip| must
+// lie within the rect
+void sw_scale_init(SwScale* scale, SwScaleFilter filter, int64_t src_width, int64_t src_height,
+                   int64_t dst_width, int64_t dst_height, SwRect clip);
+
+void sw_scale_clear(SwScale* scale);
+
+// Write rows [|start|, |end|) of the clip to |dst|, which points at the clip's
+// top-left pixel, from the RGBA image at |src|. Strides are in bytes.
+void sw_scale_rows(const SwScale* scale, uint8_t* dst, int64_t dst_stride, const uint8_t* src, int64_t src_stride,
+                   int64_t start, int64_t end);
+
+#endif //INCLUDE_SW_SCALE_H_
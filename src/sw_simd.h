@@ -0,0 +1,43 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_SIMD_H_
+#define INCLUDE_SW_SIMD_H_
+
+// Which vector kernels the compiler can build. GCC and Clang describe the
+// target with __SSE2__ and __x86_64__; MSVC never defines those, and instead
+// has _M_X64, where SSE2 is always available, or _M_IX86_FP for 32-bit
+// builds with /arch:SSE2 or higher.
+
+// SSE2 can be used unconditionally
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SW_HAVE_SSE2 1
+#endif
+
+// Kernels for wider instruction sets can be built and picked at runtime
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86)
+#define SW_HAVE_X86 1
+#endif
+
+// Builds a function for |isa| whatever the rest of the file targets. MSVC
+// lets any function use any intrinsic, so it needs nothing.
+#if defined(__GNUC__) || defined(__clang__)
+#define SW_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SW_TARGET(isa)
+#endif
+
+#endif //INCLUDE_SW_SIMD_H_
@@ -0,0 +1,169 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_sprite_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Pixels modulated at a time when a sprite is drawn with an alpha
+#define SW_SPRITE_CHUNK 256
+
+typedef struct {
+  std::vector<uint8_t> pixels;
+  int64_t width;
+  int64_t height;
+  // Position in SwSpriteCache::order
+  std::list<int64_t>::iterator use;
+} SwSprite;
+
+struct _SwSpriteCache {
+  // Guards everything below. Draws hold it while they copy, so a sprite is
+  // never evicted from under them.
+  std::mutex lock;
+  std::unordered_map<int64_t, SwSprite> sprites;
+  // IDs from least to most recently used
+  std::list<int64_t> order;
+  int64_t next_id;
+  int64_t bytes;
+  int64_t capacity;
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+};
+
+// Evict least recently used sprites until |needed| more bytes fit
+static void sw_sprite_cache_make_room(SwSpriteCache* cache, int64_t needed) {
+  while (!cache->order.empty() && cache->bytes + needed > cache->capacity) {
+    auto it = cache->sprites.find(cache->order.front());
+    cache->bytes -= (int64_t)it->second.pixels.size();
+    cache->sprites.erase(it);
+    cache->order.pop_front();
+    cache->evictions++;
+  }
+}
+
+SwSpriteCache* sw_sprite_cache_new(int64_t capacity) {
+  SwSpriteCache* cache = new SwSpriteCache();
+  cache->next_id = 1;
+  cache->bytes = 0;
+  cache->capacity = std::max<int64_t>(capacity, 0);
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->evictions = 0;
+  return cache;
+}
+
+void sw_sprite_cache_free(SwSpriteCache* cache) {
+  delete cache;
+}
+
+void sw_sprite_cache_set_capacity(SwSpriteCache* cache, int64_t capacity) {
+  std::lock_guard<std::mutex> lock(cache->lock);
+  cache->capacity = std::max<int64_t>(capacity, 0);
+  sw_sprite_cache_make_room(cache, 0);
+}
+
+int64_t sw_sprite_cache_add(SwSpriteCache* cache, const uint8_t* pixels, int64_t width, int64_t height) {
+  int64_t size = 4 * std::max<int64_t>(width, 0) * std::max<int64_t>(height, 0);
+  std::lock_guard<std::mutex> lock(cache->lock);
+  if (size > cache->capacity) {
+    return 0;
+  }
+  sw_sprite_cache_make_room(cache, size);
+  int64_t id = cache->next_id++;
+  SwSprite& sprite = cache->sprites[id];
+  sprite.pixels.assign(pixels, pixels + size);
+  sprite.width = width;
+  sprite.height = height;
+  sprite.use = cache->order.insert(cache->order.end(), id);
+  cache->bytes += size;
+  return id;
+}
+
+bool sw_sprite_cache_remove(SwSpriteCache* cache, int64_t id) {
+  std::lock_guard<std::mutex> lock(cache->lock);
+  auto it = cache->sprites.find(id);
+  if (it == cache->sprites.end()) {
+    return false;
+  }
+  cache->bytes -= (int64_t)it->second.pixels.size();
+  cache->order.erase(it->second.use);
+  cache->sprites.erase(it);
+  return true;
+}
+
+// Blend |count| pixels of |src| onto |dst| with every channel, or only
+// alpha, scaled by |alpha|
+static void sw_sprite_draw_row(uint8_t* dst, const uint8_t* src, int64_t count, uint8_t alpha, SwBlendMode blend) {
+  uint8_t scaled[4 * SW_SPRITE_CHUNK];
+  int first_channel = blend == SW_BLEND_SRC_OVER_STRAIGHT ? 3 : 0;
+  for (int64_t i = 0; i < count; i += SW_SPRITE_CHUNK) {
+    int64_t chunk = std::min<int64_t>(SW_SPRITE_CHUNK, count - i);
+    memcpy(scaled, src + 4 * i, 4 * chunk);
+    for (int64_t p = 0; p < chunk; p++) {
+      for (int c = first_channel; c < 4; c++) {
+        uint32_t value = scaled[4 * p + c] * alpha + 128;
+        scaled[4 * p + c] = (uint8_t)((value + (value >> 8)) >> 8);
+      }
+    }
+    if (blend == SW_BLEND_SRC) {
+      memcpy(dst + 4 * i, scaled, 4 * chunk);
+    } else {
+      sw_blend_row(dst + 4 * i, scaled, chunk, blend);
+    }
+  }
+}
+
+bool sw_sprite_cache_draw(SwSpriteCache* cache, int64_t id, const SwSurface* surface, int64_t x, int64_t y,
+                          uint8_t alpha, SwBlendMode blend, SwRect* drawn, SwWorkerPool* workers) {
+  std::lock_guard<std::mutex> lock(cache->lock);
+  auto it = cache->sprites.find(id);
+  if (it == cache->sprites.end()) {
+    cache->misses++;
+    return false;
+  }
+  cache->hits++;
+  SwSprite& sprite = it->second;
+  cache->order.splice(cache->order.end(), cache->order, sprite.use);
+  if (alpha == 255) {
+    *drawn = sw_surface_draw_rect(surface, sprite.pixels.data(), x, y, sprite.width, sprite.height,
+                                  SW_PIXEL_FORMAT_RGBA8888, blend, workers);
+    return true;
+  }
+  *drawn = sw_surface_clip(surface, {x, y, sprite.width, sprite.height});
+  for (int64_t row = 0; row < drawn->height; row++) {
+    const uint8_t* src = sprite.pixels.data() + 4 * ((drawn->y - y + row) * sprite.width + (drawn->x - x));
+    uint8_t* dst = surface->pixels + 4 * ((drawn->y + row) * surface->width + drawn->x);
+    sw_sprite_draw_row(dst, src, drawn->width, alpha, blend);
+  }
+  return true;
+}
+
+void sw_sprite_cache_get_stats(SwSpriteCache* cache, SwSpriteCacheStats* stats) {
+  std::lock_guard<std::mutex> lock(cache->lock);
+  stats->hits = cache->hits;
+  stats->misses = cache->misses;
+  stats->evictions = cache->evictions;
+  stats->sprites = (int64_t)cache->sprites.size();
+  stats->bytes = cache->bytes;
+  stats->capacity = cache->capacity;
+}
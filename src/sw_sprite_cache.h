@@ -0,0 +1,70 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_SPRITE_CACHE_H_
+#define INCLUDE_SW_SPRITE_CACHE_H_
+
+#include <cstdint>
+
+#include "sw_blend.h"
+#include "sw_damage.h"
+#include "sw_surface.h"
+#include "sw_worker_pool.h"
+
+// Bytes of sprites kept by default
+#define SW_SPRITE_CACHE_DEFAULT_CAPACITY (64 * 1024 * 1024)
+
+typedef struct {
+  // Blits of sprites that were and were not in the cache
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+  int64_t sprites;
+  int64_t bytes;
+  int64_t capacity;
+} SwSpriteCacheStats;
+
+// RGBA images uploaded once and drawn by ID. Once the sprites take up more
+// than the capacity, the least recently added or drawn ones are evicted, and
+// drawing them misses until they are added again under a new ID. Every
+// function may be called from any thread.
+typedef struct _SwSpriteCache SwSpriteCache;
+
+SwSpriteCache* sw_sprite_cache_new(int64_t capacity);
+
+void sw_sprite_cache_free(SwSpriteCache* cache);
+
+// Change the capacity in bytes, evicting sprites until they fit
+void sw_sprite_cache_set_capacity(SwSpriteCache* cache, int64_t capacity);
+
+// Store a copy of the |width| x |height| tightly packed RGBA image at
+// |pixels|, evicting other sprites to make room. Returns its ID, which is
+// never reused, or 0 if the image is larger than the whole cache.
+int64_t sw_sprite_cache_add(SwSpriteCache* cache, const uint8_t* pixels, int64_t width, int64_t height);
+
+// Drop sprite |id|. Returns false if it was not in the cache.
+bool sw_sprite_cache_remove(SwSpriteCache* cache, int64_t id);
+
+// Draw sprite |id| with its top-left corner at (|x|, |y|) of |surface|,
+// clipped to it, with |alpha| scaling every channel of the sprite, or only
+// its alpha for SW_BLEND_SRC_OVER_STRAIGHT. Sets |drawn| to the area drawn
+// and returns true, or returns false if the sprite is not in the cache.
+bool sw_sprite_cache_draw(SwSpriteCache* cache, int64_t id, const SwSurface* surface, int64_t x, int64_t y,
+                          uint8_t alpha, SwBlendMode blend, SwRect* drawn, SwWorkerPool* workers);
+
+void sw_sprite_cache_get_stats(SwSpriteCache* cache, SwSpriteCacheStats* stats);
+
+#endif //INCLUDE_SW_SPRITE_CACHE_H_
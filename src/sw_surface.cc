@@ -0,0 +1,199 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_surface.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Pixels converted at a time when a draw needs both conversion and blending
+#define SW_BLEND_CHUNK 256
+
+SwRect sw_surface_clip(const SwSurface* surface, SwRect rect) {
+  return sw_rect_intersect({0, 0, surface->width, surface->height}, rect);
+}
+
+// Draw one row of |count| |format| pixels from |src| onto |dst|
+static void sw_surface_draw_row(uint8_t* dst, const uint8_t* src, int64_t count, SwPixelFormat format, SwBlendMode blend) {
+  if (blend == SW_BLEND_SRC) {
+    sw_pixel_convert_row(dst, src, count, format);
+    return;
+  }
+  if (format == SW_PIXEL_FORMAT_RGBA8888) {
+    sw_blend_row(dst, src, count, blend);
+    return;
+  }
+  uint8_t converted[4 * SW_BLEND_CHUNK];
+  int bpp = sw_pixel_format_bytes_per_pixel(format);
+  for (int64_t i = 0; i < count; i += SW_BLEND_CHUNK) {
+    int64_t chunk = std::min<int64_t>(count - i, SW_BLEND_CHUNK);
+    sw_pixel_convert_row(converted, src + bpp * i, chunk, format);
+    sw_blend_row(dst + 4 * i, converted, chunk, blend);
+  }
+}
+
+// One draw handed to the worker pool
+typedef struct {
+  const SwSurface* surface;
+  const uint8_t* pixels;
+  int64_t stride;
+  SwRect clip;
+  SwPixelFormat format;
+  SwBlendMode blend;
+} SwSurfaceDraw;
+
+static void sw_surface_draw_band(int64_t start, int64_t end, void* user_data) {
+  SwSurfaceDraw* draw = (SwSurfaceDraw*)user_data;
+  for (int64_t dy = start; dy < end; dy++) {
+    uint8_t* dst = draw->surface->pixels + 4 * ((draw->clip.y + dy) * draw->surface->width + draw->clip.x);
+    sw_surface_draw_row(dst, draw->pixels + dy * draw->stride, draw->clip.width, draw->format, draw->blend);
+  }
+}
+
+SwRect sw_surface_draw_rect(const SwSurface* surface, const uint8_t* pixels, int64_t x, int64_t y,
+                            int64_t width, int64_t height, SwPixelFormat format, SwBlendMode blend,
+                            SwWorkerPool* workers) {
+  SwRect clip = sw_surface_clip(surface, {x, y, width, height});
+  if (sw_rect_is_empty(clip)) {
+    return clip;
+  }
+  int bpp = sw_pixel_format_bytes_per_pixel(format);
+  // Skip whatever part of the source fell outside the surface
+  pixels += bpp * ((clip.y - y) * width + (clip.x - x));
+  SwSurfaceDraw draw = {surface, pixels, bpp * width, clip, format, blend};
+  sw_worker_pool_run(workers, clip.height, 4 * sw_rect_area(clip), sw_surface_draw_band, &draw);
+  return clip;
+}
+
+bool sw_surface_read_rect(const SwSurface* surface, uint8_t* dst, int64_t x, int64_t y, int64_t width, int64_t height) {
+  if (x < 0 || y < 0 || width < 0 || height < 0 || x > surface->width - width || y > surface->height - height) {
+    return false;
+  }
+  const uint8_t* src = surface->pixels + 4 * (y * surface->width + x);
+  if (width == surface->width) {
+    memcpy(dst, src, 4 * width * height);
+    return true;
+  }
+  for (int64_t dy = 0; dy < height; dy++) {
+    memcpy(dst + 4 * dy * width, src + 4 * dy * surface->width, 4 * width);
+  }
+  return true;
+}
+
+// One rect of a copy handed to the worker pool
+typedef struct {
+  const SwSurface* dst;
+  const SwSurface* src;
+  SwRect rect;
+} SwSurfaceCopy;
+
+static void sw_surface_copy_band(int64_t start, int64_t end, void* user_data) {
+  SwSurfaceCopy* copy = (SwSurfaceCopy*)user_data;
+  int64_t width = copy->src->width;
+  SwRect rect = copy->rect;
+  int64_t offset = 4 * ((rect.y + start) * width + rect.x);
+  if (rect.x == 0 && rect.width == width) {
+    memcpy(copy->dst->pixels + offset, copy->src->pixels + offset, 4 * rect.width * (end - start));
+    return;
+  }
+  for (int64_t dy = start; dy < end; dy++, offset += 4 * width) {
+    memcpy(copy->dst->pixels + offset, copy->src->pixels + offset, 4 * rect.width);
+  }
+}
+
+void sw_surface_copy_rect(const SwSurface* dst, const SwSurface* src, SwRect rect, SwWorkerPool* workers) {
+  SwSurfaceCopy copy = {dst, src, sw_surface_clip(src, rect)};
+  if (sw_rect_is_empty(copy.rect)) {
+    return;
+  }
+  sw_worker_pool_run(workers, copy.rect.height, 4 * sw_rect_area(copy.rect), sw_surface_copy_band, &copy);
+}
+
+void sw_surface_relayout(const SwSurface* dst, const SwSurface* src, int64_t dx, int64_t dy) {
+  SwRect keep = sw_surface_clip(dst, {dx, dy, src->width, src->height});
+  for (int64_t y = 0; y < dst->height; y++) {
+    uint8_t* row = dst->pixels + 4 * y * dst->width;
+    if (sw_rect_is_empty(keep) || y < keep.y || y >= keep.y + keep.height) {
+      memset(row, 0, 4 * dst->width);
+      continue;
+    }
+    memset(row, 0, 4 * keep.x);
+    memcpy(row + 4 * keep.x, src->pixels + 4 * ((y - dy) * src->width + keep.x - dx), 4 * keep.width);
+    memset(row + 4 * (keep.x + keep.width), 0, 4 * (dst->width - keep.x - keep.width));
+  }
+}
+
+void sw_surface_shift(const SwSurface* surface, int64_t dx, int64_t dy) {
+  int64_t width = surface->width - std::abs(dx);
+  int64_t height = surface->height - std::abs(dy);
+  if (width <= 0 || height <= 0 || (dx == 0 && dy == 0)) {
+    return;
+  }
+  int64_t stride = 4 * surface->width;
+  uint8_t* dst = surface->pixels + 4 * std::max<int64_t>(dx, 0) + stride * std::max<int64_t>(dy, 0);
+  const uint8_t* src = surface->pixels + 4 * std::max<int64_t>(-dx, 0) + stride * std::max<int64_t>(-dy, 0);
+  if (dx == 0) {
+    // Whole rows move as one block
+    memmove(dst, src, stride * height);
+    return;
+  }
+  // Walk rows against the direction of the move so that none is overwritten
+  // before it is read. Rows overlap from one to the next, so this stays on
+  // one thread.
+  if (dy > 0) {
+    for (int64_t y = height - 1; y >= 0; y--) {
+      memmove(dst + y * stride, src + y * stride, 4 * width);
+    }
+  } else {
+    for (int64_t y = 0; y < height; y++) {
+      memmove(dst + y * stride, src + y * stride, 4 * width);
+    }
+  }
+}
+
+// One scaled blit handed to the worker pool
+typedef struct {
+  const SwScale* scale;
+  // Top-left pixel of the clip in the surface
+  uint8_t* dst;
+  int64_t dst_stride;
+  const uint8_t* pixels;
+  int64_t stride;
+} SwSurfaceBlit;
+
+static void sw_surface_blit_band(int64_t start, int64_t end, void* user_data) {
+  SwSurfaceBlit* blit = (SwSurfaceBlit*)user_data;
+  sw_scale_rows(blit->scale, blit->dst, blit->dst_stride, blit->pixels, blit->stride, start, end);
+}
+
+SwRect sw_surface_blit_scaled(const SwSurface* surface, const uint8_t* pixels, int64_t src_stride,
+                              int64_t src_width, int64_t src_height, int64_t x, int64_t y,
+                              int64_t width, int64_t height, SwScaleFilter filter, SwWorkerPool* workers) {
+  SwRect clip = sw_surface_clip(surface, {x, y, width, height});
+  if (src_width <= 0 || src_height <= 0 || sw_rect_is_empty(clip) ||
+      !sw_scale_size_is_valid(src_width, src_height) || !sw_scale_size_is_valid(width, height)) {
+    return {0, 0, 0, 0};
+  }
+  SwScale scale;
+  sw_scale_init(&scale, filter, src_width, src_height, width, height, {clip.x - x, clip.y - y, clip.width, clip.height});
+  SwSurfaceBlit blit = {&scale, surface->pixels + 4 * (clip.y * surface->width + clip.x), 4 * surface->width,
+                        pixels, src_stride};
+  sw_worker_pool_run(workers, clip.height, 4 * sw_rect_area(clip), sw_surface_blit_band, &blit);
+  sw_scale_clear(&scale);
+  return clip;
+}
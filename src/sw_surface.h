@@ -0,0 +1,70 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_SURFACE_H_
+#define INCLUDE_SW_SURFACE_H_
+
+#include <cstdint>
+
+#include "sw_blend.h"
+#include "sw_damage.h"
+#include "sw_pixel_convert.h"
+#include "sw_scale.h"
+#include "sw_worker_pool.h"
+
+// A tightly packed RGBA image owned by someone else, such as a texture's
+// store or one of its mailbox slots. These operations hold no locks; callers
+// serialize access themselves. |workers| may be null to do all of the work on
+// the calling thread.
+typedef struct {
+  uint8_t* pixels;
+  int64_t width;
+  int64_t height;
+} SwSurface;
+
+// |rect| clipped to |surface|
+SwRect sw_surface_clip(const SwSurface* surface, SwRect rect);
+
+// Draw a |width| x |height| rect of tightly packed |format| pixels to (|x|,
+// |y|), clipped to |surface|. Returns the area drawn.
+SwRect sw_surface_draw_rect(const SwSurface* surface, const uint8_t* pixels, int64_t x, int64_t y,
+                            int64_t width, int64_t height, SwPixelFormat format, SwBlendMode blend,
+                            SwWorkerPool* workers);
+
+// Copy the |width| x |height| rect at (|x|, |y|) to |dst| as tightly packed
+// rows. Returns false if the rect does not lie within |surface|.
+bool sw_surface_read_rect(const SwSurface* surface, uint8_t* dst, int64_t x, int64_t y, int64_t width, int64_t height);
+
+// Copy |rect| of |src| to the same place in |dst|, which has the same size
+void sw_surface_copy_rect(const SwSurface* dst, const SwSurface* src, SwRect rect, SwWorkerPool* workers);
+
+// Lay out the content of |src| on |dst| shifted by (|dx|, |dy|), clearing
+// everything else
+void sw_surface_relayout(const SwSurface* dst, const SwSurface* src, int64_t dx, int64_t dy);
+
+// Move the content of |surface| by (|dx|, |dy|) in place. The area it
+// uncovers keeps stale pixels for the caller to redraw.
+void sw_surface_shift(const SwSurface* surface, int64_t dx, int64_t dy);
+
+// Scale the |src_width| x |src_height| RGBA image at |pixels|, whose rows are
+// |src_stride| bytes apart, onto the |width| x |height| rect at (|x|, |y|),
+// clipped to |surface|. Returns the area drawn, which is empty when either size
+// exceeds SW_SCALE_MAX_SIZE.
+SwRect sw_surface_blit_scaled(const SwSurface* surface, const uint8_t* pixels, int64_t src_stride,
+                              int64_t src_width, int64_t src_height, int64_t x, int64_t y,
+                              int64_t width, int64_t height, SwScaleFilter filter, SwWorkerPool* workers);
+
+#endif //INCLUDE_SW_SURFACE_H_
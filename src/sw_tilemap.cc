@@ -0,0 +1,181 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_tilemap.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+struct _SwTilemap {
+  std::vector<uint8_t> tileset;
+  int64_t tileset_width;
+  // Tiles across and in the whole tileset
+  int64_t tileset_columns;
+  int64_t tile_count;
+  int64_t tile_width;
+  int64_t tile_height;
+  // Row-major tile index of each cell
+  std::vector<int32_t> cells;
+  int64_t columns;
+  int64_t rows;
+  // Map pixel at the top-left corner of the viewport
+  int64_t scroll_x;
+  int64_t scroll_y;
+};
+
+SwTilemap* sw_tilemap_new(int64_t tile_width, int64_t tile_height, int64_t columns, int64_t rows,
+                          const uint8_t* tileset, int64_t tileset_width, int64_t tileset_height) {
+  SwTilemap* tilemap = new SwTilemap();
+  tilemap->tile_width = std::max<int64_t>(tile_width, 1);
+  tilemap->tile_height = std::max<int64_t>(tile_height, 1);
+  tilemap->tileset_width = std::max<int64_t>(tileset_width, 0);
+  tileset_height = std::max<int64_t>(tileset_height, 0);
+  tilemap->tileset.assign(tileset, tileset + 4 * tilemap->tileset_width * tileset_height);
+  tilemap->tileset_columns = tilemap->tileset_width / tilemap->tile_width;
+  tilemap->tile_count = tilemap->tileset_columns * (tileset_height / tilemap->tile_height);
+  tilemap->columns = std::max<int64_t>(columns, 0);
+  tilemap->rows = std::max<int64_t>(rows, 0);
+  tilemap->cells.assign(tilemap->columns * tilemap->rows, SW_TILEMAP_EMPTY);
+  tilemap->scroll_x = 0;
+  tilemap->scroll_y = 0;
+  return tilemap;
+}
+
+void sw_tilemap_free(SwTilemap* tilemap) {
+  delete tilemap;
+}
+
+int64_t sw_tilemap_get_tile_count(SwTilemap* tilemap) {
+  return tilemap->tile_count;
+}
+
+// Fill the |count| pixels at |dst| from the map pixels starting at (|x|, |y|)
+static void sw_tilemap_render_span(const SwTilemap* tilemap, uint8_t* dst, int64_t x, int64_t y, int64_t count) {
+  int64_t map_width = tilemap->columns * tilemap->tile_width;
+  bool row_in_map = y >= 0 && y < tilemap->rows * tilemap->tile_height;
+  while (count > 0) {
+    if (!row_in_map || x >= map_width) {
+      memset(dst, 0, 4 * count);
+      return;
+    }
+    if (x < 0) {
+      int64_t n = std::min(-x, count);
+      memset(dst, 0, 4 * n);
+      dst += 4 * n;
+      x += n;
+      count -= n;
+      continue;
+    }
+    // The rest of this cell's row of pixels, up to |count|
+    int64_t tile_x = x % tilemap->tile_width, tile_y = y % tilemap->tile_height;
+    int64_t n = std::min(tilemap->tile_width - tile_x, count);
+    int64_t tile = tilemap->cells[(y / tilemap->tile_height) * tilemap->columns + x / tilemap->tile_width];
+    if (tile < 0 || tile >= tilemap->tile_count) {
+      memset(dst, 0, 4 * n);
+    } else {
+      int64_t src_x = (tile % tilemap->tileset_columns) * tilemap->tile_width + tile_x;
+      int64_t src_y = (tile / tilemap->tileset_columns) * tilemap->tile_height + tile_y;
+      memcpy(dst, tilemap->tileset.data() + 4 * (src_y * tilemap->tileset_width + src_x), 4 * n);
+    }
+    dst += 4 * n;
+    x += n;
+    count -= n;
+  }
+}
+
+// One render handed to the worker pool
+typedef struct {
+  const SwTilemap* tilemap;
+  const SwSurface* surface;
+  SwRect area;
+} SwTilemapRender;
+
+static void sw_tilemap_render_band(int64_t start, int64_t end, void* user_data) {
+  SwTilemapRender* render = (SwTilemapRender*)user_data;
+  const SwTilemap* tilemap = render->tilemap;
+  SwRect area = render->area;
+  for (int64_t dy = start; dy < end; dy++) {
+    uint8_t* dst = render->surface->pixels + 4 * ((area.y + dy) * render->surface->width + area.x);
+    sw_tilemap_render_span(tilemap, dst, tilemap->scroll_x + area.x, tilemap->scroll_y + area.y + dy, area.width);
+  }
+}
+
+void sw_tilemap_render(SwTilemap* tilemap, const SwSurface* surface, SwRect area, SwDamage* damage,
+                       SwWorkerPool* workers) {
+  SwTilemapRender render = {tilemap, surface, sw_surface_clip(surface, area)};
+  if (sw_rect_is_empty(render.area)) {
+    return;
+  }
+  sw_worker_pool_run(workers, render.area.height, 4 * sw_rect_area(render.area), sw_tilemap_render_band, &render);
+  sw_damage_add(damage, render.area);
+}
+
+bool sw_tilemap_set_tiles(SwTilemap* tilemap, const SwSurface* surface, int64_t column, int64_t row,
+                          int64_t width, int64_t height, const int32_t* tiles, SwDamage* damage,
+                          SwWorkerPool* workers) {
+  if (column < 0 || row < 0 || width < 0 || height < 0 || column > tilemap->columns - width ||
+      row > tilemap->rows - height) {
+    return false;
+  }
+  for (int64_t dy = 0; dy < height; dy++) {
+    for (int64_t dx = 0; dx < width; dx++) {
+      int32_t& cell = tilemap->cells[(row + dy) * tilemap->columns + column + dx];
+      int32_t tile = tiles[dy * width + dx];
+      if (cell == tile) {
+        continue;
+      }
+      cell = tile;
+      // Render clips the cell to the viewport, so cells out of view cost
+      // nothing more
+      sw_tilemap_render(tilemap, surface,
+                        {(column + dx) * tilemap->tile_width - tilemap->scroll_x,
+                         (row + dy) * tilemap->tile_height - tilemap->scroll_y, tilemap->tile_width,
+                         tilemap->tile_height},
+                        damage, workers);
+    }
+  }
+  return true;
+}
+
+void sw_tilemap_scroll(SwTilemap* tilemap, const SwSurface* surface, int64_t x, int64_t y, SwDamage* damage,
+                       SwWorkerPool* workers) {
+  x = std::min(std::max(x, -SW_TILEMAP_MAX_SCROLL), SW_TILEMAP_MAX_SCROLL);
+  y = std::min(std::max(y, -SW_TILEMAP_MAX_SCROLL), SW_TILEMAP_MAX_SCROLL);
+  int64_t dx = tilemap->scroll_x - x, dy = tilemap->scroll_y - y;
+  tilemap->scroll_x = x;
+  tilemap->scroll_y = y;
+  if (dx == 0 && dy == 0) {
+    return;
+  }
+  SwRect all = {0, 0, surface->width, surface->height};
+  if (std::abs(dx) >= surface->width || std::abs(dy) >= surface->height) {
+    sw_tilemap_render(tilemap, surface, all, damage, workers);
+    return;
+  }
+  sw_surface_shift(surface, dx, dy);
+  // Rows scrolled into view across the whole width, then columns scrolled
+  // into view across the rows in between
+  SwRect rows = {0, dy > 0 ? 0 : surface->height + dy, surface->width, std::abs(dy)};
+  SwRect columns = {dx > 0 ? 0 : surface->width + dx, std::max<int64_t>(dy, 0), std::abs(dx),
+                    surface->height - std::abs(dy)};
+  sw_tilemap_render(tilemap, surface, rows, damage, workers);
+  sw_tilemap_render(tilemap, surface, columns, damage, workers);
+  // Every pixel in view has moved
+  sw_damage_add(damage, all);
+}
@@ -0,0 +1,71 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_TILEMAP_H_
+#define INCLUDE_SW_TILEMAP_H_
+
+#include <cstdint>
+
+#include "sw_damage.h"
+#include "sw_surface.h"
+#include "sw_worker_pool.h"
+
+// Tile index of a cell with nothing in it, which is drawn transparent. So is
+// any index past the last tile of the tileset.
+#define SW_TILEMAP_EMPTY -1
+
+// Largest scroll offset either way, in map pixels. Far past the edge of any
+// grid, it keeps the arithmetic on offsets from overflowing.
+#define SW_TILEMAP_MAX_SCROLL ((int64_t)1 << 40)
+
+// A grid of cells, each showing one tile of a tileset, seen through a
+// viewport the size of the surface it is drawn to. The tileset is an atlas of
+// equally sized tiles numbered left to right, then top to bottom. The
+// viewport starts at a scroll offset in map pixels; whatever it shows outside
+// the grid is transparent. Functions that draw only touch the parts of the
+// surface that need it, and add those to |damage|.
+typedef struct _SwTilemap SwTilemap;
+
+// Create a |columns| x |rows| tilemap of empty cells, cutting
+// |tile_width| x |tile_height| tiles from a copy of the |tileset_width| x
+// |tileset_height| tightly packed RGBA atlas at |tileset|
+SwTilemap* sw_tilemap_new(int64_t tile_width, int64_t tile_height, int64_t columns, int64_t rows,
+                          const uint8_t* tileset, int64_t tileset_width, int64_t tileset_height);
+
+void sw_tilemap_free(SwTilemap* tilemap);
+
+// Number of tiles in the tileset
+int64_t sw_tilemap_get_tile_count(SwTilemap* tilemap);
+
+// Draw |area| of |surface| from scratch, as seen from the current scroll
+// offset
+void sw_tilemap_render(SwTilemap* tilemap, const SwSurface* surface, SwRect area, SwDamage* damage,
+                       SwWorkerPool* workers);
+
+// Set the |width| x |height| cells at (|column|, |row|) to the row-major tile
+// indices in |tiles|, redrawing the ones that changed and are in view.
+// Returns false, changing nothing, if the cells do not lie within the grid.
+bool sw_tilemap_set_tiles(SwTilemap* tilemap, const SwSurface* surface, int64_t column, int64_t row,
+                          int64_t width, int64_t height, const int32_t* tiles, SwDamage* damage,
+                          SwWorkerPool* workers);
+
+// Move the viewport to (|x|, |y|) in map pixels, each clamped to
+// ±SW_TILEMAP_MAX_SCROLL. What stays in view is moved within |surface| rather
+// than redrawn, and only the strips scrolled into view are drawn.
+void sw_tilemap_scroll(SwTilemap* tilemap, const SwSurface* surface, int64_t x, int64_t y, SwDamage* damage,
+                       SwWorkerPool* workers);
+
+#endif //INCLUDE_SW_TILEMAP_H_
@@ -0,0 +1,190 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+typedef struct {
+  const char* category;
+  const char* name;
+  int64_t start_ns;
+  int64_t duration_ns;
+} SwTraceEvent;
+
+typedef struct {
+  // Only contended while a dump reads the ring
+  std::mutex lock;
+  SwTraceEvent events[SW_TRACE_RING_SIZE];
+  // Events ever recorded, of which the last SW_TRACE_RING_SIZE are kept
+  uint64_t count;
+  int64_t tid;
+  const char* thread_name;
+  bool exited;
+} SwTraceRing;
+
+// Marks the thread's ring once the thread exits, so a dump can free it
+typedef struct SwTraceThread {
+  SwTraceRing* ring = nullptr;
+  const char* name = nullptr;
+  ~SwTraceThread() {
+    if (ring != nullptr) {
+      std::lock_guard<std::mutex> lock(ring->lock);
+      ring->exited = true;
+    }
+  }
+} SwTraceThread;
+
+static std::atomic<bool> enabled(false);
+static std::atomic<int64_t> next_tid(1);
+// Guards |rings|
+static std::mutex rings_lock;
+static std::vector<SwTraceRing*> rings;
+static thread_local SwTraceThread trace_thread;
+
+bool sw_trace_is_enabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void sw_trace_set_enabled(bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+void sw_trace_set_thread_name(const char* name) {
+  trace_thread.name = name;
+  if (trace_thread.ring != nullptr) {
+    std::lock_guard<std::mutex> lock(trace_thread.ring->lock);
+    trace_thread.ring->thread_name = name;
+  }
+}
+
+int64_t sw_trace_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The calling thread's ring, made on its first event
+static SwTraceRing* sw_trace_get_ring() {
+  if (trace_thread.ring == nullptr) {
+    SwTraceRing* ring = new SwTraceRing();
+    ring->count = 0;
+    ring->tid = next_tid.fetch_add(1);
+    ring->thread_name = trace_thread.name;
+    ring->exited = false;
+    std::lock_guard<std::mutex> lock(rings_lock);
+    rings.push_back(ring);
+    trace_thread.ring = ring;
+  }
+  return trace_thread.ring;
+}
+
+void sw_trace_record(const char* category, const char* name, int64_t start_ns) {
+  int64_t end_ns = sw_trace_now_ns();
+  SwTraceRing* ring = sw_trace_get_ring();
+  std::lock_guard<std::mutex> lock(ring->lock);
+  ring->events[ring->count % SW_TRACE_RING_SIZE] = {category, name, start_ns, end_ns - start_ns};
+  ring->count++;
+}
+
+static void sw_trace_append_string(std::string* json, const char* str) {
+  json->push_back('"');
+  for (const char* c = str == nullptr ? "" : str; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      json->push_back('\\');
+      json->push_back(*c);
+    } else if ((unsigned char)*c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", *c);
+      json->append(escape);
+    } else {
+      json->push_back(*c);
+    }
+  }
+  json->push_back('"');
+}
+
+// Times are written in microseconds, as the format expects, keeping
+// nanosecond precision
+static void sw_trace_append_us(std::string* json, int64_t ns) {
+  char number[32];
+  snprintf(number, sizeof(number), "%" PRId64 ".%03d", ns / 1000, (int)(ns % 1000));
+  json->append(number);
+}
+
+static void sw_trace_append_ring(std::string* json, SwTraceRing* ring, int64_t pid, bool* first) {
+  char ids[64];
+  snprintf(ids, sizeof(ids), "\"pid\":%" PRId64 ",\"tid\":%" PRId64, pid, ring->tid);
+  if (ring->thread_name != nullptr) {
+    json->append(*first ? "\n" : ",\n");
+    *first = false;
+    json->append("{\"name\":\"thread_name\",\"ph\":\"M\",");
+    json->append(ids);
+    json->append(",\"args\":{\"name\":");
+    sw_trace_append_string(json, ring->thread_name);
+    json->append("}}");
+  }
+  uint64_t kept = std::min<uint64_t>(ring->count, SW_TRACE_RING_SIZE);
+  for (uint64_t i = ring->count - kept; i < ring->count; i++) {
+    const SwTraceEvent& event = ring->events[i % SW_TRACE_RING_SIZE];
+    json->append(*first ? "\n" : ",\n");
+    *first = false;
+    json->append("{\"name\":");
+    sw_trace_append_string(json, event.name);
+    json->append(",\"cat\":");
+    sw_trace_append_string(json, event.category);
+    json->append(",\"ph\":\"X\",\"ts\":");
+    sw_trace_append_us(json, event.start_ns);
+    json->append(",\"dur\":");
+    sw_trace_append_us(json, event.duration_ns);
+    json->push_back(',');
+    json->append(ids);
+    json->push_back('}');
+  }
+}
+
+std::string sw_trace_dump_json(int64_t pid, bool clear) {
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  std::lock_guard<std::mutex> lock(rings_lock);
+  for (auto it = rings.begin(); it != rings.end();) {
+    SwTraceRing* ring = *it;
+    bool exited;
+    {
+      std::lock_guard<std::mutex> ring_lock(ring->lock);
+      sw_trace_append_ring(&json, ring, pid, &first);
+      if (clear) {
+        ring->count = 0;
+      }
+      exited = ring->exited;
+    }
+    if (clear && exited) {
+      delete ring;
+      it = rings.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  json.append("\n]}\n");
+  return json;
+}
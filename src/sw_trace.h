@@ -0,0 +1,74 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_TRACE_H_
+#define INCLUDE_SW_TRACE_H_
+
+#include <cstdint>
+#include <string>
+
+// Events each thread keeps before overwriting its oldest ones
+#define SW_TRACE_RING_SIZE 16384
+
+// Event tracing for the Chrome trace viewer and Perfetto. Each thread records
+// into a ring of its own, so recording never waits on another thread except
+// while a dump is reading that ring. Tracing is off by default, and costs one
+// atomic load per event while it is.
+//
+// Names and categories are stored by pointer, so they must be string
+// literals or otherwise live as long as the trace.
+
+bool sw_trace_is_enabled();
+
+void sw_trace_set_enabled(bool enabled);
+
+// Name the calling thread in traces
+void sw_trace_set_thread_name(const char* name);
+
+// Current time in nanoseconds on the clock events are stamped with, the
+// monotonic clock the Flutter timeline also uses
+int64_t sw_trace_now_ns();
+
+// Record an event on the calling thread that started at |start_ns| and ends
+// now
+void sw_trace_record(const char* category, const char* name, int64_t start_ns);
+
+// Every recorded event as Chrome trace JSON, attributed to process |pid|.
+// |clear| discards the events returned, along with threads that have exited.
+std::string sw_trace_dump_json(int64_t pid, bool clear);
+
+// Records its lifetime as an event, if tracing was enabled when it began
+class SwTraceScope {
+ public:
+  SwTraceScope(const char* category, const char* name)
+      : category_(category), name_(name), start_ns_(sw_trace_is_enabled() ? sw_trace_now_ns() : -1) {}
+  ~SwTraceScope() {
+    if (start_ns_ >= 0) {
+      sw_trace_record(category_, name_, start_ns_);
+    }
+  }
+  SwTraceScope(const SwTraceScope&) = delete;
+  SwTraceScope& operator=(const SwTraceScope&) = delete;
+
+ private:
+  const char* category_;
+  const char* name_;
+  int64_t start_ns_;
+};
+
+#define SW_TRACE_SCOPE(category, name) SwTraceScope sw_trace_scope(category, name)
+
+#endif //INCLUDE_SW_TRACE_H_
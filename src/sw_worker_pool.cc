@@ -0,0 +1,172 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#include "sw_worker_pool.h"
+#include "sw_trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Most bands a job is split into
+#define SW_WORKER_POOL_MAX_WORKERS 64
+
+// Shared by the bands of one job, which lives on the caller's stack until
+// every band has finished
+typedef struct {
+  SwWorkerBandFunc func;
+  void* user_data;
+  std::mutex lock;
+  std::condition_variable done;
+  int remaining;
+} SwWorkerJob;
+
+typedef struct {
+  SwWorkerJob* job;
+  int64_t start;
+  int64_t end;
+} SwWorkerBand;
+
+struct _SwWorkerPool {
+  std::atomic<int> workers;
+  std::atomic<int64_t> threshold;
+  std::atomic<int> ref_count;
+  // Guards everything below
+  std::mutex lock;
+  std::condition_variable wake;
+  std::deque<SwWorkerBand*> queue;
+  // Threads are only ever added, since idle ones just sleep
+  std::vector<std::thread> threads;
+  bool stopping;
+};
+
+static void sw_worker_pool_thread(SwWorkerPool* pool) {
+  sw_trace_set_thread_name("sw_rend worker");
+  std::unique_lock<std::mutex> lock(pool->lock);
+  for (;;) {
+    pool->wake.wait(lock, [pool] { return pool->stopping || !pool->queue.empty(); });
+    if (pool->queue.empty()) {
+      return;
+    }
+    SwWorkerBand* band = pool->queue.front();
+    pool->queue.pop_front();
+    lock.unlock();
+    SwWorkerJob* job = band->job;
+    {
+      SW_TRACE_SCOPE("sw_rend", "band");
+      job->func(band->start, band->end, job->user_data);
+    }
+    {
+      std::lock_guard<std::mutex> job_lock(job->lock);
+      if (--job->remaining == 0) {
+        job->done.notify_one();
+      }
+    }
+    lock.lock();
+  }
+}
+
+static int sw_worker_pool_clamp_workers(int workers) {
+  return std::min(std::max(workers, 1), SW_WORKER_POOL_MAX_WORKERS);
+}
+
+// Start threads until the caller and the threads make up |workers|
+static void sw_worker_pool_grow(SwWorkerPool* pool, int workers) {
+  std::lock_guard<std::mutex> lock(pool->lock);
+  while ((int)pool->threads.size() < workers - 1) {
+    pool->threads.emplace_back(sw_worker_pool_thread, pool);
+  }
+}
+
+SwWorkerPool* sw_worker_pool_new(int workers, int64_t threshold) {
+  SwWorkerPool* pool = new SwWorkerPool();
+  pool->workers = sw_worker_pool_clamp_workers(workers);
+  pool->threshold = std::max<int64_t>(threshold, 0);
+  pool->ref_count = 1;
+  pool->stopping = false;
+  sw_worker_pool_grow(pool, pool->workers);
+  return pool;
+}
+
+SwWorkerPool* sw_worker_pool_ref(SwWorkerPool* pool) {
+  pool->ref_count.fetch_add(1);
+  return pool;
+}
+
+void sw_worker_pool_unref(SwWorkerPool* pool) {
+  if (pool->ref_count.fetch_sub(1) != 1) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(pool->lock);
+    pool->stopping = true;
+  }
+  pool->wake.notify_all();
+  for (std::thread& thread : pool->threads) {
+    thread.join();
+  }
+  delete pool;
+}
+
+void sw_worker_pool_set_workers(SwWorkerPool* pool, int workers) {
+  workers = sw_worker_pool_clamp_workers(workers);
+  sw_worker_pool_grow(pool, workers);
+  pool->workers = workers;
+}
+
+int sw_worker_pool_get_workers(SwWorkerPool* pool) {
+  return pool->workers;
+}
+
+void sw_worker_pool_set_threshold(SwWorkerPool* pool, int64_t threshold) {
+  pool->threshold = std::max<int64_t>(threshold, 0);
+}
+
+int64_t sw_worker_pool_get_threshold(SwWorkerPool* pool) {
+  return pool->threshold;
+}
+
+void sw_worker_pool_run(SwWorkerPool* pool, int64_t rows, int64_t bytes, SwWorkerBandFunc func, void* user_data) {
+  int workers = pool == nullptr ? 1 : sw_worker_pool_get_workers(pool);
+  if (workers <= 1 || rows < 2 || bytes < sw_worker_pool_get_threshold(pool)) {
+    func(0, rows, user_data);
+    return;
+  }
+  int bands = (int)std::min<int64_t>(workers, rows);
+  SwWorkerJob job;
+  job.func = func;
+  job.user_data = user_data;
+  job.remaining = bands - 1;
+  SwWorkerBand band[SW_WORKER_POOL_MAX_WORKERS];
+  for (int i = 0; i < bands; i++) {
+    band[i] = {&job, rows * i / bands, rows * (i + 1) / bands};
+  }
+  {
+    std::lock_guard<std::mutex> lock(pool->lock);
+    for (int i = 1; i < bands; i++) {
+      pool->queue.push_back(&band[i]);
+    }
+  }
+  pool->wake.notify_all();
+  func(band[0].start, band[0].end, user_data);
+  std::unique_lock<std::mutex> lock(job.lock);
+  job.done.wait(lock, [&job] { return job.remaining == 0; });
+}
@@ -0,0 +1,59 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+#ifndef INCLUDE_SW_WORKER_POOL_H_
+#define INCLUDE_SW_WORKER_POOL_H_
+
+#include <cstdint>
+
+// Workers used by default, unless the machine has fewer cores
+#define SW_WORKER_POOL_DEFAULT_WORKERS 4
+
+// Bytes a job must touch before it is split across workers by default
+#define SW_WORKER_POOL_DEFAULT_THRESHOLD (512 * 1024)
+
+// Processes rows [start, end) of a job
+typedef void (*SwWorkerBandFunc)(int64_t start, int64_t end, void* user_data);
+
+// Persistent threads that split row-based jobs such as copies, conversions
+// and fills into bands. The calling thread works on one band itself, so a
+// pool of n workers runs n - 1 threads. Pools are reference counted since
+// textures can outlive the plugin that made them.
+typedef struct _SwWorkerPool SwWorkerPool;
+
+SwWorkerPool* sw_worker_pool_new(int workers, int64_t threshold);
+
+SwWorkerPool* sw_worker_pool_ref(SwWorkerPool* pool);
+
+// Drop a reference, joining the threads once the last one is gone
+void sw_worker_pool_unref(SwWorkerPool* pool);
+
+// Change how many workers, counting the caller, share each job
+void sw_worker_pool_set_workers(SwWorkerPool* pool, int workers);
+
+int sw_worker_pool_get_workers(SwWorkerPool* pool);
+
+// Change how many bytes a job must touch to be split
+void sw_worker_pool_set_threshold(SwWorkerPool* pool, int64_t threshold);
+
+int64_t sw_worker_pool_get_threshold(SwWorkerPool* pool);
+
+// Run |func| over |rows| rows and return once all of them are done. Jobs
+// touching fewer than the threshold's |bytes|, and any job when |pool| is
+// null, run entirely on the calling thread. Bands never share a row.
+void sw_worker_pool_run(SwWorkerPool* pool, int64_t rows, int64_t bytes, SwWorkerBandFunc func, void* user_data);
+
+#endif //INCLUDE_SW_WORKER_POOL_H_
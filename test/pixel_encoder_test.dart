@@ -0,0 +1,100 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:sw_rend/pixel_encoder.dart';
+
+/// Decode [data] into [dst] the way the device does, XORing with what is
+/// there if [xor] is set
+void _decode(Uint8List data, Uint8List dst, {bool xor = false}) {
+  int pos = 0, out = 0;
+  while (pos < data.length) {
+    int header = 0, shift = 0;
+    while (true) {
+      int byte = data[pos++];
+      header |= (byte & 0x7f) << shift;
+      shift += 7;
+      if (byte < 0x80) {
+        break;
+      }
+    }
+    int count = (header >> 1) + 1;
+    for (int i = 0; i < count; i++) {
+      int from = header & 1 == 1 ? pos : pos + 4 * i;
+      for (int b = 0; b < 4; b++) {
+        dst[out + b] = xor ? dst[out + b] ^ data[from + b] : data[from + b];
+      }
+      out += 4;
+    }
+    pos += header & 1 == 1 ? 4 : 4 * count;
+  }
+  expect(out, dst.length);
+}
+
+/// A frame with flat areas and noise, like a typical UI
+Uint8List _frame(int pixels, int seed) {
+  Uint8List frame = Uint8List(4 * pixels);
+  for (int i = 0; i < pixels; i++) {
+    int value = i % 50 < 30 ? 0x20 : (i * 31 + seed) & 0xff;
+    frame.setRange(4 * i, 4 * i + 4, [value, value ^ seed, 0x40, 0xff]);
+  }
+  return frame;
+}
+
+void main() {
+  test('RLE round trips', () {
+    Uint8List pixels = _frame(1000, 7);
+    Uint8List decoded = Uint8List(pixels.length);
+    _decode(PixelEncoder.encodeRle(pixels), decoded);
+    expect(decoded, pixels);
+  });
+
+  test('RLE packs a flat rect into one run', () {
+    Uint8List pixels = Uint8List(4 * 100);
+    for (int i = 0; i < pixels.length; i += 4) {
+      pixels.setRange(i, i + 4, [1, 2, 3, 4]);
+    }
+    // Two header bytes for a count of 100, then the pixel
+    expect(PixelEncoder.encodeRle(pixels), [0xc7, 0x01, 1, 2, 3, 4]);
+  });
+
+  test('RLE accepts views that are not 4-byte aligned', () {
+    Uint8List pixels = _frame(64, 3);
+    Uint8List backing = Uint8List(pixels.length + 1)..setRange(1, pixels.length + 1, pixels);
+    Uint8List view = Uint8List.sublistView(backing, 1);
+    Uint8List decoded = Uint8List(pixels.length);
+    _decode(PixelEncoder.encodeRle(view), decoded);
+    expect(decoded, pixels);
+  });
+
+  test('XOR RLE turns the previous frame into the current one', () {
+    Uint8List previous = _frame(1000, 7);
+    Uint8List current = Uint8List.fromList(previous);
+    current.setRange(400, 440, List.filled(40, 0x99));
+    Uint8List decoded = Uint8List.fromList(previous);
+    _decode(PixelEncoder.encodeXorRle(previous, current), decoded, xor: true);
+    expect(decoded, current);
+  });
+
+  test('XOR RLE of an unchanged frame is one run of zeros', () {
+    Uint8List frame = _frame(1000, 7);
+    Uint8List encoded = PixelEncoder.encodeXorRle(frame, Uint8List.fromList(frame));
+    expect(encoded.length, lessThanOrEqualTo(6));
+    expect(encoded.sublist(encoded.length - 4), [0, 0, 0, 0]);
+  });
+}
@@ -0,0 +1,54 @@
+/*
+Copyright 2022 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+ */
+
+import 'dart:ui';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:sw_rend/raster_commands.dart';
+
+void main() {
+  // Red lands in the low byte, so the word reads ABGR
+  const Color color = Color(0xFF102030);
+  const int word = -13623280; // 0xFF302010
+
+  test('encodes each command with its opcode and arguments', () {
+    RasterCommands commands = RasterCommands()
+      ..clear(color)
+      ..fillRect(const Rect.fromLTWH(1, 2, 3, 4), color)
+      ..hspan(5, 6, 7, color)
+      ..vspan(8, 9, 10, color)
+      ..line(const Offset(1, 2), const Offset(3, 4), color)
+      ..strokeRect(const Rect.fromLTWH(5, 6, 7, 8), color)
+      ..fillCircle(const Offset(9, 10), 11, color);
+    expect(commands.build(), [
+      0, word,
+      1, 1, 2, 3, 4, word,
+      2, 5, 6, 7, word,
+      3, 8, 9, 10, word,
+      4, 1, 2, 3, 4, word,
+      5, 5, 6, 7, 8, word,
+      6, 9, 10, 11, word,
+    ]);
+  });
+
+  test('reset empties the list', () {
+    RasterCommands commands = RasterCommands()..clear(color);
+    expect(commands.isEmpty, isFalse);
+    commands.reset();
+    expect(commands.isEmpty, isTrue);
+    expect(commands.build(), isEmpty);
+  });
+}
@@ -15,8 +15,17 @@ limitations under the License.
  */
 
 import 'dart:typed_data';
+import 'dart:ui';
 
 import 'package:flutter_test/flutter_test.dart';
+import 'package:sw_rend/capture_format.dart';
+import 'package:sw_rend/draw_batch.dart';
+import 'package:sw_rend/pixel_blend_mode.dart';
+import 'package:sw_rend/pixel_encoding.dart';
+import 'package:sw_rend/pixel_format.dart';
+import 'package:sw_rend/presented_frame.dart';
+import 'package:sw_rend/resize_anchor.dart';
+import 'package:sw_rend/scale_filter.dart';
 import 'package:sw_rend/sw_rend.dart';
 import 'package:sw_rend/sw_rend_method_channel.dart';
 import 'package:sw_rend/sw_rend_platform_interface.dart';
@@ -27,13 +36,55 @@ class MockTestNativePlatform
     implements SwRendPlatform {
 
   @override
-  Future<int?> init(int w, int h) => Future.value(-1);
+  Future<int?> init(int w, int h, {bool tearFree = false}) => Future.value(-1);
 
   @override
-  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List pixels) => Future.value(null);
+  Future<void> resize(int texId, int w, int h,
+      {ResizeAnchor anchor = ResizeAnchor.topLeft}) => Future.value(null);
 
   @override
-  Future<Uint8List?> getPixels(int texId) => Future.value(Uint8List(0));
+  Future<void> draw(int texId, int x, int y, int w, int h, Uint8List? pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      PixelEncoding encoding = PixelEncoding.raw}) => Future.value(null);
+
+  // The last batch drawn
+  Int64List? batchRecords;
+  Uint8List? batchPixels;
+  PixelFormat? batchFormat;
+  bool? batchInvalidate;
+
+  @override
+  Future<void> drawBatch(Int64List records, Uint8List pixels,
+      {PixelFormat format = PixelFormat.rgba8888,
+      PixelBlendMode blend = PixelBlendMode.src,
+      bool invalidate = false}) {
+    batchRecords = records;
+    batchPixels = pixels;
+    batchFormat = format;
+    batchInvalidate = invalidate;
+    return Future.value(null);
+  }
+
+  @override
+  Future<void> raster(int texId, Int32List commands, {bool invalidate = false}) => Future.value(null);
+
+  @override
+  Future<void> blit(int texId, int x, int y, int w, int h,
+          {Uint8List? pixels,
+          int? source,
+          int srcX = 0,
+          int srcY = 0,
+          int? srcW,
+          int? srcH,
+          ScaleFilter filter = ScaleFilter.nearest,
+          bool invalidate = false}) =>
+      Future.value(null);
+
+  @override
+  Future<Uint8List?> getPixels(int texId,
+          {int? x, int? y, int? w, int? h, int? address}) =>
+      Future.value(Uint8List(0));
 
   @override
   Future<void> invalidate(int texId) => Future.value(null);
@@ -44,9 +95,73 @@ class MockTestNativePlatform
   @override
   Future<Int32List?> getSize(int texId) => Future.value(Int32List(0));
 
+  @override
+  Future<int?> getBufferAddress(int texId) => Future.value(0);
+
+  @override
+  Future<Map<String, dynamic>?> getDamage(int texId) => Future.value(null);
+
   @override
   Future<Int64List?> listTextures() => Future.value(null);
 
+  @override
+  Future<Map<String, dynamic>?> getPoolStats() => Future.value(null);
+
+  @override
+  Future<String?> dumpTrace({bool clear = true}) => Future.value(null);
+
+  @override
+  Future<Map<String, dynamic>?> getStats({int? texId, bool reset = false}) => Future.value(null);
+
+  @override
+  Future<void> startRecording(int texId, String path,
+          {CaptureFormat format = CaptureFormat.raw, int fps = 60}) => Future.value(null);
+
+  @override
+  Future<Map<String, dynamic>?> stopRecording(int texId) => Future.value(null);
+
+  @override
+  Future<int?> addSprite(Uint8List pixels, int w, int h) => Future.value(null);
+
+  @override
+  Future<bool?> removeSprite(int sprite) => Future.value(null);
+
+  @override
+  Future<bool?> blitSprite(int texId, int sprite, int x, int y,
+          {int alpha = 255, PixelBlendMode blend = PixelBlendMode.srcOver, bool invalidate = false}) =>
+      Future.value(null);
+
+  @override
+  Future<Int64List?> blitSprites(int texId, Int64List records,
+          {PixelBlendMode blend = PixelBlendMode.srcOver, bool invalidate = false}) =>
+      Future.value(null);
+
+  @override
+  Future<Map<String, dynamic>?> getSpriteStats() => Future.value(null);
+
+  @override
+  Future<int?> setTilemap(int texId, Uint8List tileset, int tilesetW, int tilesetH,
+          int tileW, int tileH, int columns, int rows,
+          {Int32List? tiles, int x = 0, int y = 0, bool invalidate = false}) =>
+      Future.value(null);
+
+  @override
+  Future<void> removeTilemap(int texId) => Future.value(null);
+
+  @override
+  Future<void> setTiles(int texId, int column, int row, int w, int h, Int32List tiles,
+          {bool invalidate = false}) =>
+      Future.value(null);
+
+  @override
+  Future<void> scrollTilemap(int texId, int x, int y, {bool invalidate = false}) => Future.value(null);
+
+  @override
+  Stream<PresentedFrame> get presentedFrames => const Stream.empty();
+
+  @override
+  Future<Map<String, dynamic>?> configure({int? workers, int? threshold, bool? renderThread, bool? tracing, String? commandLog, int? spriteCacheBytes}) => Future.value(null);
+
 }
 
 void main() {
@@ -63,4 +178,25 @@ void main() {
   
     expect(await testNativePlugin.init(1, 1), -1);
   });
+
+  test('DrawBatch sends every rect in one call', () async {
+    MockTestNativePlatform fakePlatform = MockTestNativePlatform();
+    SwRendPlatform.instance = fakePlatform;
+    DrawBatch batch = DrawBatch(format: PixelFormat.gray8);
+    batch.add(1, const Rect.fromLTWH(2, 3, 2, 1), Uint8List.fromList([10, 11]));
+    batch.add(4, const Rect.fromLTWH(5, 6, 1, 3), Uint8List.fromList([12, 13, 14]));
+    expect(batch.length, 2);
+    await batch.submit();
+    expect(fakePlatform.batchRecords, [1, 2, 3, 2, 1, 0, 4, 5, 6, 1, 3, 2]);
+    expect(fakePlatform.batchPixels, [10, 11, 12, 13, 14]);
+    expect(fakePlatform.batchFormat, PixelFormat.gray8);
+    expect(fakePlatform.batchInvalidate, isTrue);
+    expect(batch.length, 0);
+  });
+
+  test('DrawBatch refuses pixels smaller than their rect', () {
+    DrawBatch batch = DrawBatch();
+    expect(() => batch.add(1, const Rect.fromLTWH(0, 0, 2, 2), Uint8List(15)), throwsArgumentError);
+    expect(batch.length, 0);
+  });
 }
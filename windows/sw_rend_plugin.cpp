@@ -15,6 +15,7 @@ limitations under the License.
  */
 
 #include "sw_rend_plugin.h"
+#include "sw_surface.h"
 
 // This must be included before many other Windows headers.
 #include <windows.h>
@@ -39,6 +40,14 @@ limitations under the License.
 
 namespace sw_rend {
 
+	// Largest texture init and resize accept, 1 GiB of RGBA, so that a bogus size is
+	// refused rather than running out of memory
+	constexpr int64_t kMaxTexturePixels = int64_t(1) << 28;
+
+	static bool is_valid_size(int width, int height) {
+		return width >= 0 && height >= 0 && (width == 0 || height <= kMaxTexturePixels / width);
+	}
+
 	PixelTextureObject::PixelTextureObject(
 		int width,
 		int height,
@@ -56,6 +65,9 @@ namespace sw_rend {
 		_texture = std::make_unique<flutter::TextureVariant>(
 			flutter::PixelBufferTexture(
 				[=](size_t w, size_t h) -> const FlutterDesktopPixelBuffer* {
+					std::lock_guard<std::mutex> lock(this->_frame_mutex);
+					this->_retired_pixels.clear();
+					this->_retired_fdpbs.clear();
 					return this->_fdpb.get();
 				}
 			)
@@ -75,15 +87,67 @@ namespace sw_rend {
 		return _pixels;
 	}
 
+	bool PixelTextureObject::read(int x, int y, int width, int height, uint8_t* dst) const {
+		SwSurface surface = { const_cast<uint8_t*>(_pixels.data()), _width, _height };
+		return sw_surface_read_rect(&surface, dst, x, y, width, height);
+	}
+
 	std::tuple<int32_t, int32_t> PixelTextureObject::get_size() const {
 		return std::tuple<int32_t, int32_t>(_width, _height);
 	}
 
-	void PixelTextureObject::draw(int x, int y, int width, int height, const std::vector<uint8_t>& pixels) {
-		int row_size = min(width, _width - x);
-		for (int dy = 0; dy < height && y + dy < _height; dy++) {
-			std::memcpy(_pixels.data() + 4 * ((y + dy) * _width + x + x), pixels.data() + 4 * (dy * width + x), row_size * 4);
+	bool PixelTextureObject::draw(int x, int y, int width, int height, const std::vector<uint8_t>& pixels,
+		SwPixelFormat format, SwBlendMode blend, SwEncoding encoding) {
+		if (width < 0 || height < 0) {
+			return false;
 		}
+		if (encoding != SW_ENCODING_RAW) {
+			if (format != SW_PIXEL_FORMAT_RGBA8888 || blend != SW_BLEND_SRC ||
+				!sw_rle_validate(pixels.data(), pixels.size(), static_cast<int64_t>(width) * height)) {
+				return false;
+			}
+			if (width == 0 || height == 0) {
+				return true;
+			}
+			if (x < 0 || y < 0 || x > _width - width || y > _height - height) {
+				return false;
+			}
+			sw_rle_decode(_pixels.data() + 4 * (static_cast<size_t>(y) * _width + x), 4 * static_cast<int64_t>(_width),
+				width, height, pixels.data(), pixels.size(), encoding == SW_ENCODING_XOR_RLE);
+			return true;
+		}
+		if (pixels.size() / sw_pixel_format_bytes_per_pixel(format) / max(width, 1) < static_cast<size_t>(height)) {
+			return false;
+		}
+		SwSurface surface = { _pixels.data(), _width, _height };
+		sw_surface_draw_rect(&surface, pixels.data(), x, y, width, height, format, blend, nullptr);
+		return true;
+	}
+
+	void PixelTextureObject::resize(int width, int height, ResizeAnchor anchor) {
+		int dx = 0, dy = 0;
+		if (anchor == ResizeAnchor::kCenter) {
+			dx = (width - _width) / 2;
+			dy = (height - _height) / 2;
+		}
+		std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+		if (anchor != ResizeAnchor::kClear) {
+			SwSurface from = { _pixels.data(), _width, _height };
+			SwSurface to = { pixels.data(), width, height };
+			sw_surface_relayout(&to, &from, dx, dy);
+		}
+		auto fdpb = std::make_unique<FlutterDesktopPixelBuffer>();
+		fdpb->width = width;
+		fdpb->height = height;
+		fdpb->buffer = pixels.data();
+		std::lock_guard<std::mutex> lock(_frame_mutex);
+		// Moving a vector keeps its storage, which the engine may be reading
+		_retired_pixels.push_back(std::move(_pixels));
+		_retired_fdpbs.push_back(std::move(_fdpb));
+		_pixels = std::move(pixels);
+		_fdpb = std::move(fdpb);
+		_width = width;
+		_height = height;
 	}
 
 	// static
@@ -114,6 +178,7 @@ namespace sw_rend {
 		functions = std::map<std::string, ExposedFunction>({
 			{"init", &SwRendPlugin::initialize},
 			{"draw", &SwRendPlugin::draw},
+			{"resize", &SwRendPlugin::resize},
 			{"invalidate", &SwRendPlugin::invalidate},
 			{"get_pixels", &SwRendPlugin::get_pixels},
 			{"get_size", &SwRendPlugin::get_size},
@@ -142,6 +207,10 @@ namespace sw_rend {
 		flutter::EncodableMap args = std::get<flutter::EncodableMap>(*argptr);
 		width = std::get<int>(args[flutter::EncodableValue("width")]);
 		height = std::get<int>(args[flutter::EncodableValue("height")]);
+		if (!is_valid_size(width, height)) {
+			result->Error("INVALID", "Invalid size provided");
+			return;
+		}
 		std::unique_ptr<PixelTextureObject> pto = std::make_unique<PixelTextureObject>(width, height, texture_reg);
 		int64_t tex_id = pto->get_texture_id();
 		textures[tex_id] = std::move(pto);
@@ -156,12 +225,54 @@ namespace sw_rend {
 		int h = std::get<int>(args[flutter::EncodableValue("height")]);
 		std::vector<uint8_t> bytes = std::get<std::vector<uint8_t>>(args[flutter::EncodableValue("pixels")]);
 		const int64_t tex_id = std::get<int64_t>(args[flutter::EncodableValue("texture")]);
+		int format = SW_PIXEL_FORMAT_RGBA8888, blend = SW_BLEND_SRC, encoding = SW_ENCODING_RAW;
+		auto found = args.find(flutter::EncodableValue("format"));
+		if (found != args.end()) {
+			format = std::get<int>(found->second);
+		}
+		found = args.find(flutter::EncodableValue("blend"));
+		if (found != args.end()) {
+			blend = std::get<int>(found->second);
+		}
+		found = args.find(flutter::EncodableValue("encoding"));
+		if (found != args.end()) {
+			encoding = std::get<int>(found->second);
+		}
 		auto res = textures.find(tex_id);
 		if (res == textures.end()) {
 			result->Error("NO_TEX", "Unknown texture ID provided");
 		}
+		else if (!sw_pixel_format_is_valid(format) || !sw_blend_mode_is_valid(blend) || !sw_encoding_is_valid(encoding)) {
+			result->Error("INVALID", "Unknown pixel format, blend mode or encoding");
+		}
+		else if (!res->second->draw(x0, y0, w, h, bytes, static_cast<SwPixelFormat>(format),
+			static_cast<SwBlendMode>(blend), static_cast<SwEncoding>(encoding))) {
+			result->Error("INVALID", "Pixel data does not cover the rect");
+		}
 		else {
-			res->second->draw(x0, y0, w, h, bytes);
+			result->Success(flutter::EncodableValue());
+		}
+	}
+
+	void SwRendPlugin::resize(Args argptr, Return result) {
+		flutter::EncodableMap args = std::get<flutter::EncodableMap>(*argptr);
+		const int64_t tex_id = std::get<int64_t>(args[flutter::EncodableValue("texture")]);
+		const int w = std::get<int>(args[flutter::EncodableValue("width")]);
+		const int h = std::get<int>(args[flutter::EncodableValue("height")]);
+		ResizeAnchor anchor = ResizeAnchor::kTopLeft;
+		auto found = args.find(flutter::EncodableValue("anchor"));
+		if (found != args.end()) {
+			anchor = static_cast<ResizeAnchor>(std::get<int>(found->second));
+		}
+		auto res = textures.find(tex_id);
+		if (res == textures.end()) {
+			result->Error("NO_TEX", "Unknown texture ID provided");
+		}
+		else if (!is_valid_size(w, h) || anchor < ResizeAnchor::kTopLeft || anchor > ResizeAnchor::kClear) {
+			result->Error("INVALID", "Invalid size or anchor provided");
+		}
+		else {
+			res->second->resize(w, h, anchor);
 			result->Success(flutter::EncodableValue());
 		}
 	}
@@ -187,7 +298,47 @@ namespace sw_rend {
 			result->Error("NO_TEX", "Unknown texture ID provided");
 		}
 		else {
-			result->Success(flutter::EncodableValue(res->second->get_pixels()));
+			auto [tex_w, tex_h] = res->second->get_size();
+			int x = 0, y = 0, w = tex_w, h = tex_h;
+			auto found = args.find(flutter::EncodableValue("x"));
+			if (found != args.end()) {
+				x = std::get<int>(found->second);
+			}
+			found = args.find(flutter::EncodableValue("y"));
+			if (found != args.end()) {
+				y = std::get<int>(found->second);
+			}
+			found = args.find(flutter::EncodableValue("width"));
+			if (found != args.end()) {
+				w = std::get<int>(found->second);
+			}
+			found = args.find(flutter::EncodableValue("height"));
+			if (found != args.end()) {
+				h = std::get<int>(found->second);
+			}
+			found = args.find(flutter::EncodableValue("address"));
+			if (found != args.end()) {
+				// Caller-provided memory, nothing is copied into the response
+				uint8_t* dst = reinterpret_cast<uint8_t*>(found->second.LongValue());
+				if (!res->second->read(x, y, w, h, dst)) {
+					result->Error("INVALID", "Rect lies outside the texture");
+				}
+				else {
+					result->Success(flutter::EncodableValue());
+				}
+			}
+			else if (x == 0 && y == 0 && w == tex_w && h == tex_h) {
+				result->Success(flutter::EncodableValue(res->second->get_pixels()));
+			}
+			else if (x < 0 || y < 0 || w < 0 || h < 0 || x > tex_w - w || y > tex_h - h) {
+				// Checked before allocating for the rect
+				result->Error("INVALID", "Rect lies outside the texture");
+			}
+			else {
+				std::vector<uint8_t> pixels(4 * static_cast<size_t>(w) * h);
+				res->second->read(x, y, w, h, pixels.data());
+				result->Success(flutter::EncodableValue(std::move(pixels)));
+			}
 		}
 	}
 
@@ -24,11 +24,24 @@ limitations under the License.
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <vector>
 
+#include "sw_blend.h"
+#include "sw_pixel_convert.h"
+#include "sw_rle.h"
+
 namespace sw_rend {
 
+	// Where existing content ends up when a texture is resized. The values
+	// are part of the method channel protocol.
+	enum class ResizeAnchor {
+		kTopLeft = 0,
+		kCenter = 1,
+		kClear = 2,
+	};
+
 	class PixelTextureObject {
 	public:
 		PixelTextureObject(int width, int height, flutter::TextureRegistrar& texture_reg);
@@ -39,8 +52,17 @@ namespace sw_rend {
 
 		void invalidate();
 		std::vector<uint8_t>& get_pixels();
+		// Copy a rect to |dst| as tightly packed rows, or return false if it
+		// does not lie within the texture
+		bool read(int x, int y, int width, int height, uint8_t* dst) const;
 		std::tuple<int32_t, int32_t> get_size() const;
-		void draw(int x, int y, int width, int height, const std::vector<uint8_t>& pixels);
+		// Write a rect of |pixels| in |format|, or of RGBA pixels in |encoding|,
+		// or return false if the data does not cover it. Encoded rects must
+		// lie within the texture and replace what is there.
+		bool draw(int x, int y, int width, int height, const std::vector<uint8_t>& pixels,
+			SwPixelFormat format, SwBlendMode blend, SwEncoding encoding);
+		// Change the size in place, keeping the texture ID
+		void resize(int width, int height, ResizeAnchor anchor);
 
 		inline int64_t get_texture_id() { return _texture_id; };
 
@@ -48,6 +70,12 @@ namespace sw_rend {
 		int _width, _height;
 		std::vector<uint8_t> _pixels;
 		std::unique_ptr<FlutterDesktopPixelBuffer> _fdpb;
+		// Guards _fdpb against resizes while the engine asks for a frame
+		std::mutex _frame_mutex;
+		// What every resize since the engine last asked for a frame replaced,
+		// kept until it asks again since it may still be reading them
+		std::vector<std::vector<uint8_t>> _retired_pixels;
+		std::vector<std::unique_ptr<FlutterDesktopPixelBuffer>> _retired_fdpbs;
 		std::unique_ptr<flutter::TextureVariant> _texture;
 		int64_t _texture_id;
 		flutter::TextureRegistrar& _texture_reg;
@@ -78,6 +106,7 @@ namespace sw_rend {
 			std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 		void initialize(Args, Return);
 		void draw(Args, Return);
+		void resize(Args, Return);
 		void invalidate(Args, Return);
 		void get_pixels(Args, Return);
 		void get_size(Args, Return);